@@ -0,0 +1,151 @@
+/*
+ * This program measures the cost of the decisions of the AdrComponent on a
+ * large population of devices, each of which is heard by multiple gateways.
+ * The SNR the decisions are based on is computed both from the rolling
+ * statistics kept by each EndDeviceStatus and by a reference implementation
+ * of the scan of the received packet list it replaced, and the two are
+ * checked to be the same.
+ */
+
+#include "ns3/adr-component.h"
+#include "ns3/end-device-status.h"
+#include "ns3/network-status.h"
+#include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/lora-tag.h"
+#include "ns3/mac48-address.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include "ns3/integer.h"
+#include "ns3/random-variable-stream.h"
+#include "lorawan-benchmark.h"
+#include <cmath>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("AdrBenchmark");
+
+// Benchmark settings
+int nDevices = 100000;
+int nGateways = 3;
+int nPackets = 8;
+int historyRange = 4;
+
+/**
+ * Reference implementation: combine the receive power over the gateways of
+ * each of the last historyRange packets in a copy of the received packet
+ * list, and average the results.
+ */
+double
+ReferenceAverageRxPower (Ptr<EndDeviceStatus> status)
+{
+  EndDeviceStatus::ReceivedPacketList packetList = status->GetReceivedPacketList ();
+  double sum = 0;
+  auto it = packetList.rbegin ();
+  for (int i = 0; i < historyRange; i++, it++)
+    {
+      EndDeviceStatus::GatewayList gwList = it->second.gwList;
+      double gwSum = 0;
+      for (auto &gw : gwList)
+        {
+          gwSum += gw.second.rxPower;
+        }
+      sum += gwSum / gwList.size ();
+    }
+  return sum / historyRange;
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices", nDevices);
+  cmd.AddValue ("nGateways", "Number of gateways receiving each packet", nGateways);
+  cmd.AddValue ("nPackets", "Number of packets received from each device", nPackets);
+  cmd.AddValue ("historyRange", "Number of packets used by ADR", historyRange);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nPackets < historyRange, "Not enough packets for ADR");
+
+  Ptr<AdrComponent> adr = CreateObject<AdrComponent> ();
+  adr->SetAttribute ("HistoryRange", IntegerValue (historyRange));
+  Ptr<NetworkStatus> networkStatus = CreateObject<NetworkStatus> ();
+  Ptr<UniformRandomVariable> power = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> sf = CreateObject<UniformRandomVariable> ();
+
+  std::vector<Address> gateways;
+  for (int gw = 0; gw < nGateways; gw++)
+    {
+      gateways.push_back (Mac48Address::Allocate ());
+    }
+
+  // Fill the history of each device
+  std::vector<Ptr<EndDeviceStatus>> devices;
+  for (int device = 0; device < nDevices; device++)
+    {
+      LoraDeviceAddress address (device);
+      Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> (
+          address, CreateObject<ClassAEndDeviceLorawanMac> ());
+      uint8_t deviceSf = sf->GetInteger (7, 12);
+
+      for (int fCnt = 0; fCnt < nPackets; fCnt++)
+        {
+          LoraFrameHeader frameHdr;
+          frameHdr.SetAsUplink ();
+          frameHdr.SetAddress (address);
+          frameHdr.SetFCnt (fCnt);
+          frameHdr.SetAdr (true);
+          LorawanMacHeader macHdr;
+          macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+          Ptr<Packet> packet = Create<Packet> (10);
+          packet->AddHeader (frameHdr);
+          packet->AddHeader (macHdr);
+
+          for (uint32_t gwIndex = 0; gwIndex < gateways.size (); gwIndex++)
+            {
+              Ptr<Packet> copy = packet->Copy ();
+              LoraTag tag (deviceSf);
+              tag.SetFrequency (868.1);
+              tag.SetReceivePower (power->GetValue (-140, -90));
+              copy->AddPacketTag (tag);
+              Ptr<const ParsedUplink> uplink = Create<ParsedUplink> (copy);
+              status->InsertReceivedPacket (uplink, gateways[gwIndex], gwIndex);
+              adr->OnReceivedPacket (uplink, status, networkStatus);
+            }
+        }
+      devices.push_back (status);
+    }
+
+  // Reference SNR computation
+  std::vector<double> reference (nDevices);
+  double referenceNs = MeasureNsPerIteration (nDevices, [&] (uint64_t device)
+    {
+      reference[device] = ReferenceAverageRxPower (devices[device]);
+    });
+
+  // SNR computation from the rolling statistics
+  std::vector<double> rolling (nDevices);
+  double rollingNs = MeasureNsPerIteration (nDevices, [&] (uint64_t device)
+    {
+      rolling[device] = devices[device]->GetRxPowerStatistics ().GetRxPower (
+          RxPowerStatistics::AVERAGE, RxPowerStatistics::AVERAGE);
+    });
+
+  int mismatches = CountMismatches (reference, rolling, [] (double a, double b)
+    {
+      return std::fabs (a - b) <= 1e-9;
+    });
+
+  // Complete ADR decisions
+  double decisionNs = MeasureNsPerIteration (nDevices, [&] (uint64_t device)
+    {
+      adr->BeforeSendingReply (devices[device], networkStatus);
+    });
+
+  PrintRow ("devices", "gateways", "referenceNs", "rollingNs", "speedup", "decisionNs",
+            "mismatches");
+  PrintRow (nDevices, nGateways, referenceNs, rollingNs, referenceNs / rollingNs, decisionNs,
+            mismatches);
+
+  return BenchmarkExitCode (mismatches);
+}
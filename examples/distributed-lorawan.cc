@@ -0,0 +1,313 @@
+/*
+ * This script simulates the same network twice: first sequentially, and then
+ * distributed over the MPI ranks it was launched with, using nodes partitioned
+ * in strips separated by a guard band. It checks that the gateways receive and
+ * lose the same number of packets in both runs.
+ *
+ * The script must be launched with as many ranks as partitions, e.g.:
+ *   mpirun -np 2 ./waf --run "distributed-lorawan --nPartitions=2"
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/lora-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/global-value.h"
+#include "ns3/string.h"
+#include "ns3/command-line.h"
+#include "ns3/mpi-interface.h"
+#include <mpi.h>
+#include <cmath>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("DistributedLorawan");
+
+// Network settings
+uint32_t nDevices = 300;
+uint32_t nPartitions = 2;
+uint32_t nPackets = 5;
+double sideLength = 6000;
+double guardBand = 200;
+double simulationTime = 600;
+
+// Events seen by the nodes owned by this process: packets sent by end
+// devices, and packets received, interfered and dropped for lack of
+// demodulators at gateways
+enum Counter
+{
+  SENT,
+  RECEIVED,
+  INTERFERED,
+  NO_MORE_RECEIVERS,
+  N_COUNTERS
+};
+std::vector<uint32_t> counters (N_COUNTERS, 0);
+
+void
+OnStartSending (Ptr<const Packet> packet, uint32_t systemId)
+{
+  counters[SENT]++;
+}
+
+void
+OnReceivedPacket (Ptr<const Packet> packet, uint32_t systemId)
+{
+  counters[RECEIVED]++;
+}
+
+void
+OnInterference (Ptr<const Packet> packet, uint32_t systemId)
+{
+  counters[INTERFERED]++;
+}
+
+void
+OnNoMoreReceivers (Ptr<const Packet> packet, uint32_t systemId)
+{
+  counters[NO_MORE_RECEIVERS]++;
+}
+
+/**
+ * Run the network and return the counters of the nodes owned by this
+ * process.
+ *
+ * \param positions The positions of the gateways, followed by those of the
+ * end devices.
+ * \param nGateways The number of gateways.
+ * \param distributed Whether nodes should be partitioned among the ranks.
+ */
+std::vector<uint32_t>
+RunNetwork (const std::vector<Vector> &positions, uint32_t nGateways, bool distributed)
+{
+  counters.assign (N_COUNTERS, 0);
+
+  /************************
+  *  Create the channel  *
+  ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  /******************
+  *  Create nodes  *
+  ******************/
+
+  LoraHelper helper;
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  for (auto &position : positions)
+    {
+      allocator->Add (position);
+    }
+
+  // No position falls inside a guard band, so both runs place nodes in the
+  // same spots
+  NodeContainer nodes;
+  uint32_t systemId = 0;
+  if (distributed)
+    {
+      nodes = helper.CreatePartitionedNodes (positions.size (), allocator, nPartitions,
+                                             -sideLength / 2, sideLength / 2, guardBand);
+      systemId = MpiInterface::GetSystemId ();
+    }
+  else
+    {
+      nodes.Create (positions.size ());
+      MobilityHelper mobility;
+      mobility.SetPositionAllocator (allocator);
+      mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+      mobility.Install (nodes);
+    }
+
+  NodeContainer gateways;
+  NodeContainer endDevices;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      if (i < nGateways)
+        {
+          gateways.Add (nodes.Get (i));
+        }
+      else
+        {
+          endDevices.Add (nodes.Get (i));
+        }
+    }
+
+  /**********************
+  *  Create the devices  *
+  **********************/
+
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper;
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  LorawanMacHelper::SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  if (distributed)
+    {
+      helper.BoundLookAhead (channel, guardBand);
+    }
+
+  /*************************
+  *  Schedule the packets  *
+  *************************/
+
+  for (uint32_t i = 0; i < gateways.GetN (); i++)
+    {
+      Ptr<Node> node = gateways.Get (i);
+      if (node->GetSystemId () != systemId)
+        {
+          continue;
+        }
+      Ptr<LoraPhy> phy = node->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+      phy->TraceConnectWithoutContext ("ReceivedPacket", MakeCallback (&OnReceivedPacket));
+      phy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
+                                       MakeCallback (&OnInterference));
+      phy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
+                                       MakeCallback (&OnNoMoreReceivers));
+    }
+
+  // Send times are drawn for all end devices, local or not, so that they are
+  // the same in both runs
+  Ptr<UniformRandomVariable> sendTime = CreateObject<UniformRandomVariable> ();
+  sendTime->SetStream (1);
+  double frequencies[] = {868.1, 868.3, 868.5};
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<Node> node = endDevices.Get (i);
+      Ptr<LoraNetDevice> device = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+      Ptr<EndDeviceLorawanMac> mac = device->GetMac ()->GetObject<EndDeviceLorawanMac> ();
+
+      LoraTxParameters txParams;
+      txParams.sf = mac->GetSfFromDataRate (mac->GetDataRate ());
+
+      for (uint32_t p = 0; p < nPackets; p++)
+        {
+          Time time = Seconds (sendTime->GetValue (0, simulationTime));
+          if (node->GetSystemId () != systemId)
+            {
+              continue;
+            }
+          Simulator::ScheduleWithContext (node->GetId (), time, &LoraPhy::Send,
+                                          device->GetPhy (), Create<Packet> (20), txParams,
+                                          frequencies[i % 3], 14);
+        }
+      if (node->GetSystemId () == systemId)
+        {
+          device->GetPhy ()->TraceConnectWithoutContext ("StartSending",
+                                                         MakeCallback (&OnStartSending));
+        }
+    }
+
+  /****************
+  *  Simulation  *
+  ****************/
+
+  Simulator::Stop (Seconds (simulationTime + 10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return counters;
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices to include in the simulation", nDevices);
+  cmd.AddValue ("nPartitions", "Number of strips, i.e., of MPI ranks", nPartitions);
+  cmd.AddValue ("nPackets", "Number of packets sent by each end device", nPackets);
+  cmd.AddValue ("sideLength", "The side of the square simulation area, in meters", sideLength);
+  cmd.AddValue ("guardBand", "The width of the guard band between strips, in meters", guardBand);
+  cmd.AddValue ("simulationTime", "The time during which packets are sent, in seconds",
+                simulationTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nPartitions < 2, "At least two partitions are needed");
+  double width = sideLength / nPartitions;
+  NS_ABORT_MSG_IF (guardBand >= width / 2, "The guard band is too wide for the strips");
+
+  // One gateway at the center of each strip, and end devices drawn uniformly
+  // outside of the guard bands around the boundaries between strips
+  std::vector<Vector> positions;
+  for (uint32_t k = 0; k < nPartitions; k++)
+    {
+      positions.push_back (Vector (-sideLength / 2 + (k + 0.5) * width, 0, 15));
+    }
+  Ptr<UniformRandomVariable> coordinate = CreateObject<UniformRandomVariable> ();
+  coordinate->SetStream (0);
+  while (positions.size () < nPartitions + nDevices)
+    {
+      double x = coordinate->GetValue (-sideLength / 2, sideLength / 2);
+      double y = coordinate->GetValue (-sideLength / 2, sideLength / 2);
+      bool inGuardBand = false;
+      for (uint32_t k = 1; k < nPartitions; k++)
+        {
+          inGuardBand |= std::abs (x - (-sideLength / 2 + k * width)) < guardBand / 2;
+        }
+      if (!inGuardBand)
+        {
+          positions.push_back (Vector (x, y, 1.2));
+        }
+    }
+
+  // Every rank runs the sequential simulation, before MPI is enabled
+  std::vector<uint32_t> sequential = RunNetwork (positions, nPartitions, false);
+
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue ("ns3::DistributedSimulatorImpl"));
+  MpiInterface::Enable (&argc, &argv);
+  NS_ABORT_MSG_IF (MpiInterface::GetSize () != nPartitions,
+                   "The script must be launched on " << nPartitions << " MPI ranks");
+
+  std::vector<uint32_t> local = RunNetwork (positions, nPartitions, true);
+  std::vector<uint32_t> distributed (N_COUNTERS, 0);
+  MPI_Reduce (local.data (), distributed.data (), N_COUNTERS, MPI_UNSIGNED, MPI_SUM, 0,
+              MPI_COMM_WORLD);
+
+  int result = 0;
+  if (MpiInterface::GetSystemId () == 0)
+    {
+      std::cout << "Sent: " << sequential[SENT] << " sequential, " << distributed[SENT]
+                << " distributed" << std::endl;
+      std::cout << "Received: " << sequential[RECEIVED] << " sequential, "
+                << distributed[RECEIVED] << " distributed" << std::endl;
+      std::cout << "Interfered: " << sequential[INTERFERED] << " sequential, "
+                << distributed[INTERFERED] << " distributed" << std::endl;
+      std::cout << "No more receivers: " << sequential[NO_MORE_RECEIVERS] << " sequential, "
+                << distributed[NO_MORE_RECEIVERS] << " distributed" << std::endl;
+
+      if (sequential != distributed)
+        {
+          std::cout << "The distributed run differs from the sequential one" << std::endl;
+          result = 1;
+        }
+    }
+
+  MpiInterface::Disable ();
+
+  return result;
+}
@@ -0,0 +1,123 @@
+/*
+ * This program compares the strategies that the NetworkScheduler can use to
+ * assign gateways to the replies of receive windows opening in the same
+ * interval. Batches of replies are generated for devices spread over a ring
+ * of gateways, each device being reachable by its closest gateways. For each
+ * strategy, the fraction of replies that are delivered and the CPU time
+ * spent per batch are reported. The reference is the per-device choice of
+ * the best gateway, in which replies competing for a gateway are lost.
+ */
+
+#include "ns3/downlink-planner.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include "ns3/random-variable-stream.h"
+#include "lorawan-benchmark.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("DownlinkPlannerBenchmark");
+
+// Benchmark settings
+int nGateways = 50;
+int nReplies = 30;
+int nCandidates = 3;
+int nBatches = 10000;
+
+/**
+ * Reference implementation: every reply goes through the best gateway of its
+ * device, and only one reply per gateway is delivered.
+ */
+uint64_t
+ReferenceDelivered (const std::vector<DownlinkPlanner::Request> &requests)
+{
+  std::vector<bool> used (nGateways, false);
+  uint64_t delivered = 0;
+  for (auto &request : requests)
+    {
+      if (!used[request.gateways.front ()])
+        {
+          used[request.gateways.front ()] = true;
+          delivered++;
+        }
+    }
+  return delivered;
+}
+
+/**
+ * Plan all batches with a strategy.
+ *
+ * \return The number of delivered replies.
+ */
+uint64_t
+PlanBatches (Ptr<DownlinkPlanner> planner,
+             std::vector<std::vector<DownlinkPlanner::Request>> &batches,
+             double &nsPerBatch)
+{
+  nsPerBatch = MeasureNsPerIteration (batches.size (), [&] (uint64_t i)
+    {
+      planner->Plan (batches[i], nGateways);
+    });
+
+  uint64_t delivered = 0;
+  for (auto &batch : batches)
+    {
+      for (auto &request : batch)
+        {
+          delivered += request.gateway != DownlinkPlanner::NO_GATEWAY;
+        }
+    }
+  return delivered;
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nGateways", "Number of gateways", nGateways);
+  cmd.AddValue ("nReplies", "Number of replies in each batch", nReplies);
+  cmd.AddValue ("nCandidates", "Number of gateways that can reach each device", nCandidates);
+  cmd.AddValue ("nBatches", "Number of batches to plan", nBatches);
+  cmd.Parse (argc, argv);
+
+  // The gateways that can reach a device are the closest ones on the ring,
+  // starting from a random one, in random order of quality
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  std::vector<std::vector<DownlinkPlanner::Request>> batches (nBatches);
+  uint64_t referenceDelivered = 0;
+  for (auto &batch : batches)
+    {
+      batch.resize (nReplies);
+      for (auto &request : batch)
+        {
+          uint32_t first = random->GetInteger (0, nGateways - 1);
+          for (int i = 0; i < nCandidates; i++)
+            {
+              request.gateways.push_back ((first + i) % nGateways);
+            }
+          for (int i = nCandidates - 1; i > 0; i--)
+            {
+              std::swap (request.gateways[i], request.gateways[random->GetInteger (0, i)]);
+            }
+        }
+      referenceDelivered += ReferenceDelivered (batch);
+    }
+  double total = double (nBatches) * nReplies;
+
+  double greedyNs;
+  uint64_t greedyDelivered = PlanBatches (CreateObject<GreedyDownlinkPlanner> (),
+                                          batches, greedyNs);
+  double matchingNs;
+  uint64_t matchingDelivered = PlanBatches (CreateObject<MatchingDownlinkPlanner> (),
+                                            batches, matchingNs);
+
+  PrintRow ("gateways", "replies", "referenceRatio", "greedyRatio", "matchingRatio", "greedyNs",
+            "matchingNs");
+  PrintRow (nGateways, nReplies, referenceDelivered / total, greedyDelivered / total,
+            matchingDelivered / total, greedyNs, matchingNs);
+
+  // The matching is optimal, so it can't deliver fewer replies than the
+  // greedy strategy
+  return BenchmarkExitCode (matchingDelivered < greedyDelivered);
+}
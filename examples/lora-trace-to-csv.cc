@@ -0,0 +1,37 @@
+/*
+ * This program converts a binary trace written by LoraTraceWriter (see
+ * LoraHelper::EnableBinaryTraceOutput) to CSV files, one for each type of
+ * record contained in the trace.
+ *
+ * Example:
+ * ./waf --run "lora-trace-to-csv --input=phyPerformance.bin --prefix=phyPerformance"
+ */
+
+#include "ns3/lora-trace-writer.h"
+#include "ns3/command-line.h"
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string prefix = "trace";
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "The binary trace to convert", input);
+  cmd.AddValue ("prefix", "The prefix of the CSV files to write", prefix);
+  cmd.Parse (argc, argv);
+
+  int64_t nRecords = LoraTraceReader::ConvertToCsv (input, prefix);
+  if (nRecords < 0)
+    {
+      std::cerr << "Unable to convert " << input << std::endl;
+      return 1;
+    }
+
+  std::cout << "Converted " << nRecords << " records" << std::endl;
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Utilities shared by the benchmark programs of the lorawan module, which
+ * time an optimised implementation against a reference one, check that the
+ * two give the same results, and print a table of the measurements.
+ */
+
+#ifndef LORAWAN_BENCHMARK_H
+#define LORAWAN_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Measure the wall clock time taken by a function.
+ *
+ * \param function The function to run.
+ * \return The time taken, in seconds.
+ */
+template <typename Function>
+double
+MeasureSeconds (Function function)
+{
+  auto start = std::chrono::steady_clock::now ();
+  function ();
+  auto end = std::chrono::steady_clock::now ();
+  return std::chrono::duration<double> (end - start).count ();
+}
+
+/**
+ * Measure the average wall clock time of the iterations of a loop.
+ *
+ * \param nIterations The number of iterations.
+ * \param body The body of the loop, which gets the index of the iteration.
+ * \return The time taken by an iteration, in nanoseconds.
+ */
+template <typename Body>
+double
+MeasureNsPerIteration (uint64_t nIterations, Body body)
+{
+  double seconds = MeasureSeconds ([&] ()
+    {
+      for (uint64_t i = 0; i < nIterations; i++)
+        {
+          body (i);
+        }
+    });
+  return seconds * 1e9 / nIterations;
+}
+
+/**
+ * Count the results that differ from the reference ones.
+ *
+ * \param reference The results of the reference implementation.
+ * \param results The results of the implementation being measured.
+ * \param same Whether a result is the same as the reference one.
+ * \return The number of mismatches, including missing results.
+ */
+template <typename T, typename Same>
+int
+CountMismatches (const std::vector<T> &reference, const std::vector<T> &results, Same same)
+{
+  int mismatches = 0;
+  for (std::size_t i = 0; i < reference.size (); i++)
+    {
+      mismatches += i >= results.size () || !same (reference[i], results[i]);
+    }
+  return mismatches;
+}
+
+/**
+ * Count the results that are not equal to the reference ones.
+ */
+template <typename T>
+int
+CountMismatches (const std::vector<T> &reference, const std::vector<T> &results)
+{
+  return CountMismatches (reference, results,
+                          [] (const T &a, const T &b) { return a == b; });
+}
+
+/**
+ * Print a line of the result table, with space-separated columns.
+ */
+inline void
+PrintRow (void)
+{
+  std::cout << std::endl;
+}
+
+template <typename First, typename... Rest>
+void
+PrintRow (const First &first, const Rest &... rest)
+{
+  std::cout << first << (sizeof... (rest) > 0 ? " " : "");
+  PrintRow (rest...);
+}
+
+/**
+ * Get the exit code of a benchmark, reporting failed checks on the standard
+ * error.
+ *
+ * \param failures The number of results that failed their check.
+ * \return 0 if all checks passed, 1 otherwise.
+ */
+inline int
+BenchmarkExitCode (int failures)
+{
+  if (failures > 0)
+    {
+      std::cerr << failures << " results failed their check" << std::endl;
+      return 1;
+    }
+  return 0;
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORAWAN_BENCHMARK_H */
@@ -0,0 +1,442 @@
+/*
+ * This program runs independent replicates of a LoRaWAN network scenario over
+ * a grid of parameters (number of devices, radius, application period and
+ * run number), and merges the metrics computed by the LoraPacketTracker of
+ * each replicate in a single table printed to the standard output.
+ *
+ * Since the ns-3 simulator is a per-process singleton, replicates are run in
+ * a pool of worker processes (at most nWorkers at a time), each of which
+ * reports its results to the parent through a pipe. The scenario can be the
+ * one of complete-network-example (without buildings), of aloha-throughput,
+ * or of adr-example (without mobile devices). In the latter, the radius is
+ * half the side of the square in which devices are placed, and PHY metrics
+ * are those of the first gateway.
+ *
+ * Example:
+ * ./waf --run "lorawan-sweep --scenario=aloha-throughput
+ *              --nDevices=100,200,400 --radius=3000,6000 --appPeriod=600
+ *              --runs=1-10 --nWorkers=64"
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/gateway-lorawan-mac.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/lora-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/pointer.h"
+#include "ns3/config.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/command-line.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <type_traits>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanSweep");
+
+// Sweep settings
+std::string scenarioName = "complete-network";
+std::string nDevicesValues = "200";
+std::string radiusValues = "6400";
+std::string appPeriodValues = "600";
+std::string runValues = "1";
+int nWorkers = 1;
+double simulationTime = 600;
+
+/**
+ * The scenarios a replicate can simulate, each following one of the examples.
+ */
+enum Scenario
+{
+  COMPLETE_NETWORK,
+  ALOHA_THROUGHPUT,
+  ADR
+};
+
+Scenario scenario = COMPLETE_NETWORK;
+
+/**
+ * The parameters of a single replicate.
+ */
+struct Replicate
+{
+  int nDevices;
+  double radius;
+  int appPeriodSeconds;
+  int run;
+};
+
+/**
+ * Parse a single value, aborting unless the whole string is consumed.
+ */
+template <typename T>
+T
+ParseValue (std::string element)
+{
+  std::stringstream elementStream (element);
+  T value;
+  elementStream >> value >> std::ws;
+  NS_ABORT_MSG_IF (elementStream.fail () || !elementStream.eof (), "Invalid value " << element);
+  return value;
+}
+
+/**
+ * Parse a comma-separated list of values. For integral types, each element
+ * can also be a range in the form first-last. Other types only accept single
+ * values, so that negative exponents (e.g., 1e-3) are not taken for ranges.
+ */
+template <typename T>
+std::vector<T>
+ParseList (std::string list)
+{
+  std::vector<T> values;
+  std::stringstream ss (list);
+  std::string element;
+  while (std::getline (ss, element, ','))
+    {
+      std::size_t dash = element.find ('-', 1);
+      if (std::is_integral<T>::value && dash != std::string::npos)
+        {
+          T first = ParseValue<T> (element.substr (0, dash));
+          T last = ParseValue<T> (element.substr (dash + 1));
+          for (T value = first; value <= last; value++)
+            {
+              values.push_back (value);
+            }
+        }
+      else
+        {
+          values.push_back (ParseValue<T> (element));
+        }
+    }
+  return values;
+}
+
+/**
+ * Run a replicate of the scenario, and return the line of the result table
+ * that contains its metrics.
+ */
+std::string
+RunReplicate (Replicate replicate)
+{
+  RngSeedManager::SetRun (replicate.run);
+
+  // Each replicate runs in its own process, so these defaults don't leak
+  // into other replicates
+  if (scenario == ALOHA_THROUGHPUT)
+    {
+      // Make all devices use SF7 (i.e., DR5)
+      Config::SetDefault ("ns3::EndDeviceLorawanMac::DataRate", UintegerValue (5));
+      LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+    }
+  else if (scenario == ADR)
+    {
+      // Set the EDs to require Data Rate control from the NS
+      Config::SetDefault ("ns3::EndDeviceLorawanMac::DRControl", BooleanValue (true));
+    }
+
+  // Mobility
+  MobilityHelper mobility;
+  if (scenario == ADR)
+    {
+      mobility.SetPositionAllocator (
+          "ns3::RandomRectanglePositionAllocator", "X",
+          PointerValue (CreateObjectWithAttributes<UniformRandomVariable> (
+              "Min", DoubleValue (-replicate.radius), "Max", DoubleValue (replicate.radius))),
+          "Y",
+          PointerValue (CreateObjectWithAttributes<UniformRandomVariable> (
+              "Min", DoubleValue (-replicate.radius), "Max", DoubleValue (replicate.radius))));
+    }
+  else
+    {
+      mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator", "rho",
+                                     DoubleValue (replicate.radius), "X", DoubleValue (0.0), "Y",
+                                     DoubleValue (0.0));
+    }
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  // Channel
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  if (scenario == ADR)
+    {
+      Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+      x->SetAttribute ("Min", DoubleValue (0.0));
+      x->SetAttribute ("Max", DoubleValue (10.0));
+      Ptr<RandomPropagationLossModel> randomLoss = CreateObject<RandomPropagationLossModel> ();
+      randomLoss->SetAttribute ("Variable", PointerValue (x));
+      loss->SetNext (randomLoss);
+    }
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  // Helpers
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  if (scenario == ALOHA_THROUGHPUT)
+    {
+      macHelper.SetRegion (LorawanMacHelper::ALOHA);
+    }
+  LoraHelper helper = LoraHelper ();
+  helper.EnablePacketTracking ();
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+  ForwarderHelper forHelper = ForwarderHelper ();
+
+  // End devices
+  NodeContainer endDevices;
+  endDevices.Create (replicate.nDevices);
+  mobility.Install (endDevices);
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<MobilityModel> mobility = (*j)->GetObject<MobilityModel> ();
+      Vector position = mobility->GetPosition ();
+      position.z = 1.2;
+      mobility->SetPosition (position);
+    }
+
+  uint8_t nwkId = 54;
+  uint32_t nwkAddr = 1864;
+  Ptr<LoraDeviceAddressGenerator> addrGen =
+      CreateObject<LoraDeviceAddressGenerator> (nwkId, nwkAddr);
+  macHelper.SetAddressGenerator (addrGen);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  // Gateways: one in the center, or a hexagonal grid covering the square
+  // for the ADR scenario
+  NodeContainer gateways;
+  if (scenario == ADR)
+    {
+      int gatewayDistance = 5000;
+      int gatewayRings = 2 + (std::sqrt (2) * replicate.radius) / (gatewayDistance);
+      gateways.Create (3 * gatewayRings * gatewayRings - 3 * gatewayRings + 1);
+      mobility.SetPositionAllocator (
+          CreateObject<HexGridPositionAllocator> (gatewayDistance / 2));
+    }
+  else
+    {
+      gateways.Create (1);
+      Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+      allocator->Add (Vector (0.0, 0.0, 15.0));
+      mobility.SetPositionAllocator (allocator);
+    }
+  mobility.Install (gateways);
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  // In the ALOHA scenario all devices use SF7, and in the ADR one the
+  // network server sets spreading factors up
+  if (scenario == COMPLETE_NETWORK)
+    {
+      macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+    }
+
+  // Applications
+  Time appStopTime = Seconds (simulationTime);
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (replicate.appPeriodSeconds));
+  if (scenario == COMPLETE_NETWORK)
+    {
+      appHelper.SetPacketSize (23);
+    }
+  else if (scenario == ALOHA_THROUGHPUT)
+    {
+      appHelper.SetPacketSize (150);
+    }
+  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (appStopTime);
+
+  // Network server
+  NodeContainer networkServer;
+  networkServer.Create (1);
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  if (scenario == ADR)
+    {
+      nsHelper.EnableAdr (true);
+      nsHelper.SetAdr ("ns3::AdrComponent");
+    }
+  nsHelper.Install (networkServer);
+  forHelper.Install (gateways);
+
+  Simulator::Stop (appStopTime + Hours (1));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  LoraPacketTracker &tracker = helper.GetPacketTracker ();
+  std::stringstream line;
+  line << replicate.nDevices << " " << replicate.radius << " " << replicate.appPeriodSeconds
+       << " " << replicate.run << " "
+       << tracker.PrintPhyPacketsPerGw (Seconds (0), appStopTime + Hours (1),
+                                        gateways.Get (0)->GetId ())
+       << tracker.CountMacPacketsGlobally (Seconds (0), appStopTime + Hours (1));
+  return line.str ();
+}
+
+/**
+ * A replicate being run by a worker process.
+ */
+struct Worker
+{
+  std::size_t index; //!< The index of the replicate
+  int fd; //!< The read end of the pipe the worker reports to
+};
+
+/**
+ * Read all the data a worker wrote to its pipe.
+ */
+std::string
+ReadAll (int fd)
+{
+  std::string data;
+  char buffer[256];
+  ssize_t n;
+  while ((n = read (fd, buffer, sizeof (buffer))) > 0)
+    {
+      data.append (buffer, n);
+    }
+  close (fd);
+  return data;
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("scenario", "The scenario to simulate (complete-network, aloha-throughput or adr)",
+                scenarioName);
+  cmd.AddValue ("nDevices", "Comma-separated numbers of end devices", nDevicesValues);
+  cmd.AddValue ("radius", "Comma-separated radii of the area to simulate", radiusValues);
+  cmd.AddValue ("appPeriod", "Comma-separated application periods, in seconds",
+                appPeriodValues);
+  cmd.AddValue ("runs", "Comma-separated run numbers (ranges like 1-10 are allowed)", runValues);
+  cmd.AddValue ("nWorkers", "The maximum number of replicates to run concurrently", nWorkers);
+  cmd.AddValue ("simulationTime", "The time for which to simulate", simulationTime);
+  cmd.Parse (argc, argv);
+
+  NS_ABORT_MSG_IF (nWorkers < 1, "At least one worker is needed");
+
+  if (scenarioName == "complete-network")
+    {
+      scenario = COMPLETE_NETWORK;
+    }
+  else if (scenarioName == "aloha-throughput")
+    {
+      scenario = ALOHA_THROUGHPUT;
+    }
+  else if (scenarioName == "adr")
+    {
+      scenario = ADR;
+    }
+  else
+    {
+      NS_ABORT_MSG ("Unknown scenario " << scenarioName);
+    }
+
+  // Build the parameter grid
+  std::vector<Replicate> replicates;
+  for (int nDevices : ParseList<int> (nDevicesValues))
+    {
+      for (double radius : ParseList<double> (radiusValues))
+        {
+          for (int appPeriodSeconds : ParseList<int> (appPeriodValues))
+            {
+              for (int run : ParseList<int> (runValues))
+                {
+                  replicates.push_back ({nDevices, radius, appPeriodSeconds, run});
+                }
+            }
+        }
+    }
+
+  NS_LOG_INFO ("Running " << replicates.size () << " replicates on " << nWorkers << " workers");
+
+  // Results are stored by replicate index, so that the table does not depend
+  // on the order in which workers finish
+  std::vector<std::string> results (replicates.size ());
+  std::map<pid_t, Worker> workers;
+  std::size_t next = 0;
+  bool failed = false;
+
+  while (next < replicates.size () || !workers.empty ())
+    {
+      // Start new workers while there are free slots
+      while (next < replicates.size () && int (workers.size ()) < nWorkers)
+        {
+          int fds[2];
+          NS_ABORT_MSG_IF (pipe (fds) != 0, "Unable to create a pipe");
+
+          // Flush before forking, so that buffered output is not duplicated
+          std::cout.flush ();
+          pid_t pid = fork ();
+          NS_ABORT_MSG_IF (pid < 0, "Unable to create a worker process");
+          if (pid == 0)
+            {
+              close (fds[0]);
+              std::string line = RunReplicate (replicates[next]);
+              ssize_t written = write (fds[1], line.c_str (), line.size ());
+              close (fds[1]);
+              _exit (written == ssize_t (line.size ()) ? 0 : 1);
+            }
+          close (fds[1]);
+          workers[pid] = {next, fds[0]};
+          next++;
+        }
+
+      // Wait for a worker to finish, and collect its results
+      int status;
+      pid_t pid = wait (&status);
+      NS_ABORT_MSG_IF (pid < 0, "Unable to wait for worker processes");
+      auto it = workers.find (pid);
+      if (it == workers.end ())
+        {
+          continue;
+        }
+      std::string line = ReadAll (it->second.fd);
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0 || line.empty ())
+        {
+          std::cerr << "Replicate " << it->second.index << " failed" << std::endl;
+          failed = true;
+        }
+      results[it->second.index] = line;
+      workers.erase (it);
+    }
+
+  std::cout << "nDevices radius appPeriod run sent received interfered noMoreReceivers "
+               "underSensitivity lostBecauseTx macSent macReceived"
+            << std::endl;
+  for (auto &line : results)
+    {
+      if (!line.empty ())
+        {
+          std::cout << line << std::endl;
+        }
+    }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+/*
+ * This program measures the throughput of device lookups in the
+ * NetworkStatus of a server managing a large number of devices, whose
+ * addresses are handed out by a LoraDeviceAddressGenerator. Lookups through
+ * the DeviceAddressTable used by NetworkStatus are compared against a
+ * std::map holding the same devices, which is what NetworkStatus used before.
+ */
+
+#include "ns3/network-status.h"
+#include "ns3/class-a-end-device-lorawan-mac.h"
+#include "ns3/lora-device-address-generator.h"
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include "ns3/random-variable-stream.h"
+#include "lorawan-benchmark.h"
+#include <map>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("NetworkStatusBenchmark");
+
+// Benchmark settings
+int nDevices = 100000;
+int nLookups = 10000000;
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices managed by the server", nDevices);
+  cmd.AddValue ("nLookups", "Number of lookups to measure", nLookups);
+  cmd.Parse (argc, argv);
+
+  // Register the devices, with the addresses used by the examples
+  Ptr<NetworkStatus> status = CreateObject<NetworkStatus> ();
+  std::map<LoraDeviceAddress, Ptr<EndDeviceStatus>> reference;
+  Ptr<LoraDeviceAddressGenerator> addrGen = CreateObject<LoraDeviceAddressGenerator> (54, 1864);
+  std::vector<LoraDeviceAddress> addresses;
+  for (int device = 0; device < nDevices; device++)
+    {
+      Ptr<ClassAEndDeviceLorawanMac> mac = CreateObject<ClassAEndDeviceLorawanMac> ();
+      mac->SetDeviceAddress (addrGen->NextAddress ());
+      status->AddNode (mac);
+      addresses.push_back (mac->GetDeviceAddress ());
+      reference[addresses.back ()] = status->GetEndDeviceStatus (addresses.back ());
+    }
+
+  // Devices are looked up in a random order, as packets arrive
+  Ptr<UniformRandomVariable> index = CreateObject<UniformRandomVariable> ();
+  std::vector<LoraDeviceAddress> lookups;
+  for (int i = 0; i < nLookups; i++)
+    {
+      lookups.push_back (addresses[index->GetInteger (0, nDevices - 1)]);
+    }
+
+  std::vector<bool> referenceFound (nLookups);
+  double referenceSeconds = MeasureSeconds ([&] ()
+    {
+      for (int i = 0; i < nLookups; i++)
+        {
+          referenceFound[i] = reference.find (lookups[i])->second != 0;
+        }
+    });
+
+  std::vector<bool> found (nLookups);
+  double tableSeconds = MeasureSeconds ([&] ()
+    {
+      for (int i = 0; i < nLookups; i++)
+        {
+          found[i] = status->m_endDeviceStatuses.Find (lookups[i]) != 0;
+        }
+    });
+
+  // All devices were registered, so all lookups must succeed
+  int mismatches = CountMismatches (referenceFound, found, [] (bool a, bool b)
+    {
+      return a && b;
+    });
+
+  PrintRow ("devices", "mapLookupsPerSecond", "tableLookupsPerSecond", "speedup", "mismatches");
+  PrintRow (nDevices, nLookups / referenceSeconds, nLookups / tableSeconds,
+            referenceSeconds / tableSeconds, mismatches);
+
+  return BenchmarkExitCode (mismatches);
+}
@@ -0,0 +1,165 @@
+/*
+ * This program measures the saving brought by the time on air tables of
+ * LoraPhy::GetOnAirTime in the scenario of aloha-throughput, where all
+ * devices use SF7 and send large packets to a single gateway. The scenario is
+ * run once with the tables disabled, so that the time on air is computed from
+ * the formula for each packet, and once with the tables enabled, and the
+ * packet counts of the two runs are checked to be the same.
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/end-device-lorawan-mac.h"
+#include "ns3/gateway-lorawan-mac.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/lora-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/config.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/command-line.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include "lorawan-benchmark.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("TimeOnAirBenchmark");
+
+// Benchmark settings
+int nDevices = 2000;
+double radius = 1000;
+double simulationTime = 3600;
+int appPeriodSeconds = 600;
+
+/**
+ * Run the scenario of aloha-throughput, and return the PHY and MAC packet
+ * counts it results in.
+ *
+ * \param seconds Set to the wall clock time taken by the simulation.
+ */
+std::string
+RunScenario (double &seconds)
+{
+  // Draw the same random numbers in all runs
+  RngSeedManager::ResetNextStreamIndex ();
+
+  // Mobility
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator", "rho", DoubleValue (radius),
+                                 "X", DoubleValue (0.0), "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  // Channel
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  // Helpers
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper = LorawanMacHelper ();
+  macHelper.SetRegion (LorawanMacHelper::ALOHA);
+  LoraHelper helper = LoraHelper ();
+  helper.EnablePacketTracking ();
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+  ForwarderHelper forHelper = ForwarderHelper ();
+
+  // End devices
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+  for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+    {
+      Ptr<MobilityModel> mobility = (*j)->GetObject<MobilityModel> ();
+      Vector position = mobility->GetPosition ();
+      position.z = 1.2;
+      mobility->SetPosition (position);
+    }
+
+  uint8_t nwkId = 54;
+  uint32_t nwkAddr = 1864;
+  Ptr<LoraDeviceAddressGenerator> addrGen =
+      CreateObject<LoraDeviceAddressGenerator> (nwkId, nwkAddr);
+  macHelper.SetAddressGenerator (addrGen);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  // Gateway
+  NodeContainer gateways;
+  gateways.Create (1);
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  allocator->Add (Vector (0.0, 0.0, 15.0));
+  mobility.SetPositionAllocator (allocator);
+  mobility.Install (gateways);
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  // Applications
+  Time appStopTime = Seconds (simulationTime);
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (appPeriodSeconds));
+  appHelper.SetPacketSize (150);
+  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (appStopTime);
+
+  // Network server
+  NodeContainer networkServer;
+  networkServer.Create (1);
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  nsHelper.Install (networkServer);
+  forHelper.Install (gateways);
+
+  Simulator::Stop (appStopTime + Hours (1));
+  seconds = MeasureSeconds (&Simulator::Run);
+  Simulator::Destroy ();
+
+  LoraPacketTracker &tracker = helper.GetPacketTracker ();
+  return tracker.PrintPhyPacketsPerGw (Seconds (0), appStopTime + Hours (1),
+                                       gateways.Get (0)->GetId ()) +
+         tracker.CountMacPacketsGlobally (Seconds (0), appStopTime + Hours (1));
+}
+
+int
+main (int argc, char *argv[])
+{
+  CommandLine cmd;
+  cmd.AddValue ("nDevices", "Number of end devices to include in the simulation", nDevices);
+  cmd.AddValue ("radius", "The radius of the area to simulate", radius);
+  cmd.AddValue ("simulationTime", "The time during which devices send packets",
+                simulationTime);
+  cmd.AddValue ("appPeriod", "The period of the applications, in seconds", appPeriodSeconds);
+  cmd.Parse (argc, argv);
+
+  // Make all devices use SF7 (i.e., DR5)
+  Config::SetDefault ("ns3::EndDeviceLorawanMac::DataRate", UintegerValue (5));
+  LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+
+  // Without tables first, so that the second run starts from empty tables
+  double formulaSeconds;
+  LoraPhy::EnableOnAirTimeTables (false);
+  std::string formulaCounts = RunScenario (formulaSeconds);
+
+  double tableSeconds;
+  LoraPhy::EnableOnAirTimeTables (true);
+  std::string tableCounts = RunScenario (tableSeconds);
+
+  int mismatches = formulaCounts != tableCounts;
+
+  PrintRow ("devices", "formulaS", "tablesS", "speedup", "mismatches");
+  PrintRow (nDevices, formulaSeconds, tableSeconds, formulaSeconds / tableSeconds, mismatches);
+
+  return BenchmarkExitCode (mismatches);
+}
@@ -20,7 +20,14 @@
 
 #include "ns3/lora-helper.h"
 #include "ns3/log.h"
-
+#include "ns3/constant-position-mobility-model.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include "ns3/distributed-simulator-impl.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 namespace ns3 {
@@ -30,7 +37,8 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
 
   LoraHelper::LoraHelper () :
     m_lastPhyPerformanceUpdate (Seconds (0)),
-    m_lastGlobalPerformanceUpdate (Seconds (0))
+    m_lastGlobalPerformanceUpdate (Seconds (0)),
+    m_binaryTraceOutput (false)
   {
   }
 
@@ -141,6 +149,17 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
 
       node->AddDevice (device);
       devices.Add (device);
+
+#ifdef NS3_MPI
+      // In distributed simulations, local devices need to be reachable by
+      // transmissions coming from other ranks
+      if (MpiInterface::IsEnabled ()
+          && node->GetSystemId () == MpiInterface::GetSystemId ())
+        {
+          phy->GetChannel ()->EnableRemoteReception (device);
+        }
+#endif
+
       NS_LOG_DEBUG ("node=" << node << ", mob=" << node->GetObject<MobilityModel> ()->GetPosition ());
     }
   return devices;
@@ -154,6 +173,90 @@ LoraHelper::Install ( const LoraPhyHelper &phy,
   return Install (phy, mac, NodeContainer (node));
 }
 
+NodeContainer
+LoraHelper::CreatePartitionedNodes (uint32_t nNodes,
+                                    Ptr<PositionAllocator> allocator,
+                                    uint32_t nPartitions, double xMin,
+                                    double xMax, double guardBand) const
+{
+  NS_LOG_FUNCTION (this << nNodes << allocator << nPartitions << xMin << xMax <<
+                   guardBand);
+
+  NS_ASSERT (nPartitions > 0 && xMax > xMin);
+  NS_ABORT_MSG_IF (guardBand < 0 || guardBand >= (xMax - xMin) / nPartitions,
+                   "The guard band must be non-negative and narrower than a strip");
+
+  double width = (xMax - xMin) / nPartitions;
+
+  NodeContainer nodes;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      // Draw positions until one falls outside of the guard bands around the
+      // boundaries between strips
+      Vector position = allocator->GetNext ();
+      uint32_t attempts = 1;
+      while (IsInGuardBand (position.x, nPartitions, xMin, width, guardBand))
+        {
+          NS_ABORT_MSG_IF (attempts == 1000,
+                           "Could not draw a position outside of the guard bands. "
+                           "Is the allocator covering the whole area?");
+          position = allocator->GetNext ();
+          attempts++;
+        }
+
+      // Find the strip this position falls into
+      double strip = (position.x - xMin) / width;
+      uint32_t systemId = uint32_t (std::min (std::max (strip, 0.0),
+                                              double (nPartitions - 1)));
+
+      Ptr<Node> node = CreateObject<Node> (systemId);
+      Ptr<ConstantPositionMobilityModel> mobility =
+        CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (position);
+      node->AggregateObject (mobility);
+
+      NS_LOG_DEBUG ("Node " << node->GetId () << " at " << position <<
+                    " assigned to system " << systemId);
+
+      nodes.Add (node);
+    }
+
+  return nodes;
+}
+
+bool
+LoraHelper::IsInGuardBand (double x, uint32_t nPartitions, double xMin,
+                           double width, double guardBand)
+{
+  // Only the boundaries between strips are surrounded by a guard band
+  for (uint32_t k = 1; k < nPartitions; k++)
+    {
+      if (std::abs (x - (xMin + k * width)) < guardBand / 2)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+LoraHelper::BoundLookAhead (Ptr<LoraChannel> channel, double guardBand) const
+{
+  NS_LOG_FUNCTION (this << channel << guardBand);
+
+#ifdef NS3_MPI
+  if (MpiInterface::IsEnabled ())
+    {
+      Time lookAhead = channel->GetLookAhead (guardBand);
+      NS_LOG_INFO ("Bounding the lookahead to " << lookAhead);
+      DistributedSimulatorImpl::BoundLookAhead (lookAhead);
+      return;
+    }
+#endif
+
+  NS_LOG_INFO ("Simulation is not distributed, not bounding the lookahead");
+}
+
 void
 LoraHelper::EnablePacketTracking ()
 {
@@ -195,10 +298,78 @@ LoraHelper::EnablePeriodicDeviceStatusPrinting (NodeContainer endDevices,
                        endDevices, gateways, filename, interval);
 }
 
+void
+LoraHelper::EnableBinaryTraceOutput (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_binaryTraceOutput = true;
+}
+
+void
+LoraHelper::EnableStreamingStatistics (Time interval)
+{
+  // Periodic reports count the packets sent since the previous one, so the
+  // tracker only needs counters with the granularity of the intervals,
+  // instead of going through all tracked packets at every report. Buckets
+  // are as wide as the greatest common divisor of all intervals.
+  int64_t width = interval.GetTimeStep ();
+  int64_t other = m_packetTracker->GetStreamingStatisticsBucketWidth ().GetTimeStep ();
+  while (other != 0)
+    {
+      int64_t remainder = width % other;
+      width = other;
+      other = remainder;
+    }
+
+  if (TimeStep (width) != m_packetTracker->GetStreamingStatisticsBucketWidth ())
+    {
+      NS_LOG_INFO ("Counting packets in buckets of " << TimeStep (width));
+      m_packetTracker->EnableStreamingStatistics (TimeStep (width));
+    }
+}
+
+Ptr<LoraTraceWriter>
+LoraHelper::GetTraceWriter (std::string filename)
+{
+  auto it = m_traceWriters.find (filename);
+  if (it != m_traceWriters.end ())
+    {
+      return it->second;
+    }
+
+  Ptr<LoraTraceWriter> writer = Create<LoraTraceWriter> (filename);
+  m_traceWriters[filename] = writer;
+
+  // Make sure all records are on file once the simulation is over
+  Simulator::ScheduleDestroy (&LoraTraceWriter::Flush, writer);
+
+  return writer;
+}
+
 void
 LoraHelper::DoPrintDeviceStatus (NodeContainer endDevices, NodeContainer gateways,
                                  std::string filename)
 {
+  if (m_binaryTraceOutput)
+    {
+      Ptr<LoraTraceWriter> writer = GetTraceWriter (filename);
+      for (NodeContainer::Iterator j = endDevices.Begin (); j != endDevices.End (); ++j)
+        {
+          Ptr<Node> object = *j;
+          Ptr<MobilityModel> position = object->GetObject<MobilityModel> ();
+          NS_ASSERT (position != 0);
+          Ptr<LoraNetDevice> loraNetDevice = object->GetDevice (0)->GetObject<LoraNetDevice> ();
+          NS_ASSERT (loraNetDevice != 0);
+          Ptr<ClassAEndDeviceLorawanMac> mac =
+            loraNetDevice->GetMac ()->GetObject<ClassAEndDeviceLorawanMac> ();
+          writer->WriteDeviceStatus (Simulator::Now (), object->GetId (),
+                                     position->GetPosition (), mac->GetDataRate (),
+                                     uint8_t (mac->GetTransmissionPower ()));
+        }
+      return;
+    }
+
   const char * c = filename.c_str ();
   std::ofstream outputFile;
   if (Simulator::Now () == Seconds (0))
@@ -250,6 +421,7 @@ LoraHelper::EnablePeriodicPhyPerformancePrinting (NodeContainer gateways,
 {
   NS_LOG_FUNCTION (this);
 
+  EnableStreamingStatistics (interval);
   DoPrintPhyPerformance (gateways, filename);
 
   Simulator::Schedule (interval,
@@ -264,6 +436,21 @@ LoraHelper::DoPrintPhyPerformance (NodeContainer gateways,
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_binaryTraceOutput)
+    {
+      Ptr<LoraTraceWriter> writer = GetTraceWriter (filename);
+      for (auto it = gateways.Begin (); it != gateways.End (); ++it)
+        {
+          int systemId = (*it)->GetId ();
+          writer->WritePhyPerformance (Simulator::Now (), systemId,
+                                       m_packetTracker->CountPhyPacketsPerGw
+                                         (m_lastPhyPerformanceUpdate, Simulator::Now (),
+                                         systemId));
+        }
+      m_lastPhyPerformanceUpdate = Simulator::Now ();
+      return;
+    }
+
   const char * c = filename.c_str ();
   std::ofstream outputFile;
   if (Simulator::Now () == Seconds (0))
@@ -298,6 +485,7 @@ LoraHelper::EnablePeriodicGlobalPerformancePrinting (std::string filename,
 {
   NS_LOG_FUNCTION (this << filename << interval);
 
+  EnableStreamingStatistics (interval);
   DoPrintGlobalPerformance (filename);
 
   Simulator::Schedule (interval,
@@ -311,6 +499,17 @@ LoraHelper::DoPrintGlobalPerformance (std::string filename)
 {
   NS_LOG_FUNCTION (this);
 
+  if (m_binaryTraceOutput)
+    {
+      std::vector<int> counts =
+        m_packetTracker->CountMacPacketsGloballyValues (m_lastGlobalPerformanceUpdate,
+                                                        Simulator::Now ());
+      GetTraceWriter (filename)->WriteGlobalPerformance (Simulator::Now (), counts.at (0),
+                                                         counts.at (1));
+      m_lastGlobalPerformanceUpdate = Simulator::Now ();
+      return;
+    }
+
   const char * c = filename.c_str ();
   std::ofstream outputFile;
   if (Simulator::Now () == Seconds (0))
@@ -324,10 +523,12 @@ LoraHelper::DoPrintGlobalPerformance (std::string filename)
       outputFile.open (c, std::ofstream::out | std::ofstream::app);
     }
 
+  std::vector<int> counts =
+    m_packetTracker->CountMacPacketsGloballyValues (m_lastGlobalPerformanceUpdate,
+                                                    Simulator::Now ());
   outputFile << Simulator::Now ().GetSeconds () << " " <<
-    m_packetTracker->CountMacPacketsGlobally (m_lastGlobalPerformanceUpdate,
-                                              Simulator::Now ()) <<
-    std::endl;
+    std::to_string (double (counts.at (0))) << " " <<
+    std::to_string (double (counts.at (1))) << std::endl;
 
   m_lastGlobalPerformanceUpdate = Simulator::Now ();
 
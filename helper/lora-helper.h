@@ -28,8 +28,11 @@
 #include "ns3/net-device.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-packet-tracker.h"
+#include "ns3/lora-trace-writer.h"
+#include "ns3/position-allocator.h"
 
 #include <ctime>
+#include <map>
 
 namespace ns3 {
 namespace lorawan {
@@ -73,6 +76,52 @@ public:
                                       const LorawanMacHelper &macHelper,
                                       Ptr<Node> node) const;
 
+  /**
+   * Create nodes whose system id depends on their position, for use in
+   * distributed simulations.
+   *
+   * The [xMin, xMax] interval is split in nPartitions strips of equal width,
+   * and nodes are assigned the system id of the strip they fall into. Each
+   * node is given a ConstantPositionMobilityModel at the position drawn from
+   * the allocator. LoraChannel can then deliver transmissions towards nodes
+   * of other strips through MPI, using the distance between strips to bound
+   * the lookahead (see BoundLookAhead).
+   *
+   * Each boundary between strips is surrounded by an empty guard band of the
+   * given width: positions drawn inside it are discarded, and a new one is
+   * drawn from the allocator. Without a guard band, nodes can sit on both
+   * sides of a boundary, and the lookahead is close to zero. Nodes that are
+   * not created by this method, gateways included, must be kept out of the
+   * guard bands too.
+   *
+   * \param nNodes The number of nodes to create.
+   * \param allocator The allocator to draw node positions from.
+   * \param nPartitions The number of strips, i.e., of system ids.
+   * \param xMin The left edge of the area to partition.
+   * \param xMax The right edge of the area to partition.
+   * \param guardBand The width of the guard bands, in meters.
+   * \returns The created nodes.
+   */
+  NodeContainer CreatePartitionedNodes (uint32_t nNodes,
+                                        Ptr<PositionAllocator> allocator,
+                                        uint32_t nPartitions, double xMin,
+                                        double xMax, double guardBand = 0) const;
+
+  /**
+   * Bound the lookahead of the distributed simulator to the propagation delay
+   * across the guard band between partitions.
+   *
+   * This method should be called after all devices have been installed, and
+   * before the simulation is started. It aborts if PHYs of different
+   * partitions are closer than the guard band (see
+   * LoraChannel::GetLookAhead). It has no effect if the simulation is not
+   * distributed.
+   *
+   * \param channel The channel connecting the PHYs.
+   * \param guardBand The guard band used to create the nodes, in meters.
+   */
+  void BoundLookAhead (Ptr<LoraChannel> channel, double guardBand) const;
+
   /**
    * Enable tracking of packets via trace sources.
    *
@@ -96,6 +145,10 @@ public:
 
   /**
    * Periodically prints PHY-level performance at every gateway in the container.
+   *
+   * This enables streaming statistics in the packet tracker (see
+   * LoraPacketTracker::EnableStreamingStatistics), so it should be called
+   * before the simulation starts.
    */
   void EnablePeriodicPhyPerformancePrinting (NodeContainer gateways,
                                              std::string filename,
@@ -105,12 +158,26 @@ public:
 
   /**
    * Periodically prints global performance.
+   *
+   * This enables streaming statistics in the packet tracker (see
+   * LoraPacketTracker::EnableStreamingStatistics), so it should be called
+   * before the simulation starts.
    */
   void EnablePeriodicGlobalPerformancePrinting (std::string filename,
                                                 Time interval);
 
   void DoPrintGlobalPerformance (std::string filename);
 
+  /**
+   * Make the periodic printing functions write binary traces instead of text.
+   *
+   * Each file passed to the EnablePeriodic*Printing methods is written by a
+   * LoraTraceWriter, which is kept open for the whole simulation and
+   * flushed when the simulation is destroyed. LoraTraceReader can convert
+   * the resulting files to CSV.
+   */
+  void EnableBinaryTraceOutput (void);
+
   LoraPacketTracker& GetPacketTracker (void);
 
   LoraPacketTracker* m_packetTracker = 0;
@@ -130,8 +197,31 @@ private:
    */
   void DoPrintSimulationTime (Time interval);
 
+  /**
+   * Check whether a position falls within the guard band around one of the
+   * boundaries between strips (see CreatePartitionedNodes).
+   */
+  static bool IsInGuardBand (double x, uint32_t nPartitions, double xMin,
+                             double width, double guardBand);
+
+  /**
+   * Make the packet tracker count packets in time buckets, whose width
+   * divides the intervals of all the periodic performance printers.
+   *
+   * \param interval The interval of a periodic printer.
+   */
+  void EnableStreamingStatistics (Time interval);
+
+  /**
+   * Get the binary trace writer for a file, creating it the first time.
+   */
+  Ptr<LoraTraceWriter> GetTraceWriter (std::string filename);
+
   Time m_lastPhyPerformanceUpdate;
   Time m_lastGlobalPerformanceUpdate;
+
+  bool m_binaryTraceOutput; //!< Whether to write binary traces
+  std::map<std::string, Ptr<LoraTraceWriter> > m_traceWriters; //!< Open traces
 };
 
 } //namespace ns3
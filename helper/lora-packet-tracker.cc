@@ -22,6 +22,7 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/lorawan-mac-header.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 
@@ -39,6 +40,127 @@ LoraPacketTracker::~LoraPacketTracker ()
   NS_LOG_FUNCTION (this);
 }
 
+template <typename T>
+int64_t
+LoraPacketTracker::FindRecord (PacketRecords<T> &data, Ptr<Packet const> packet)
+{
+  uint64_t *sequenceNumber = data.index.Find (packet->GetUid ());
+  if (sequenceNumber == 0)
+    {
+      return -1;
+    }
+  return *sequenceNumber - data.firstSequenceNumber;
+}
+
+std::size_t
+LoraPacketTracker::GetGatewayIndex (uint32_t gwId)
+{
+  std::size_t *index = m_gwIndices.Find (gwId);
+  if (index != 0)
+    {
+      return *index;
+    }
+
+  NS_LOG_DEBUG ("Adding outcome columns for gateway " << gwId);
+
+  m_gwIndices.Insert (gwId, m_gwIds.size ());
+  m_gwIds.push_back (gwId);
+  m_phyOutcomes.push_back (std::deque<uint8_t> (m_packetTracker.records.size (), UNSET));
+  m_outcomeBuckets.push_back (std::vector<std::array<uint32_t, 5> >
+                                (m_buckets.size (), std::array<uint32_t, 5> ()));
+  return m_gwIds.size () - 1;
+}
+
+void
+LoraPacketTracker::SetHorizon (Time horizon)
+{
+  NS_LOG_FUNCTION (this << horizon);
+
+  m_horizon = horizon;
+}
+
+void
+LoraPacketTracker::EnableStreamingStatistics (Time bucketWidth)
+{
+  NS_LOG_FUNCTION (this << bucketWidth);
+
+  NS_ASSERT (bucketWidth.IsStrictlyPositive ());
+  NS_ASSERT_MSG (m_buckets.empty () || bucketWidth == m_bucketWidth,
+                 "The bucket width can't change once packets were counted");
+  m_bucketWidth = bucketWidth;
+}
+
+Time
+LoraPacketTracker::GetStreamingStatisticsBucketWidth (void) const
+{
+  return m_bucketWidth;
+}
+
+std::size_t
+LoraPacketTracker::GetBucketIndex (Time time)
+{
+  std::size_t index = time.GetTimeStep () / m_bucketWidth.GetTimeStep ();
+  if (index >= m_buckets.size ())
+    {
+      m_buckets.resize (index + 1);
+      for (auto &column : m_outcomeBuckets)
+        {
+          column.resize (index + 1);
+        }
+    }
+  return index;
+}
+
+void
+LoraPacketTracker::GetBucketRange (Time startTime, Time stopTime,
+                                   std::size_t &first, std::size_t &last) const
+{
+  int64_t width = m_bucketWidth.GetTimeStep ();
+  first = std::min<std::size_t> (std::max<int64_t> (startTime.GetTimeStep (), 0) / width,
+                                 m_buckets.size ());
+  last = std::min<std::size_t> (std::max<int64_t> (stopTime.GetTimeStep (), 0) / width,
+                                m_buckets.size ());
+  last = std::max (first, last);
+}
+
+void
+LoraPacketTracker::RetireOldRecords (void)
+{
+  if (m_horizon.IsZero () || Simulator::Now () < m_horizon)
+    {
+      return;
+    }
+  Time threshold = Simulator::Now () - m_horizon;
+
+  while (!m_packetTracker.records.empty ()
+         && m_packetTracker.records.front ().sendTime < threshold)
+    {
+      m_packetTracker.index.Erase (m_packetTracker.records.front ().uid);
+      m_packetTracker.records.pop_front ();
+      m_packetTracker.firstSequenceNumber++;
+      for (auto &column : m_phyOutcomes)
+        {
+          column.pop_front ();
+        }
+    }
+
+  while (!m_macPacketTracker.records.empty ()
+         && m_macPacketTracker.records.front ().sendTime < threshold)
+    {
+      m_macPacketTracker.index.Erase (m_macPacketTracker.records.front ().uid);
+      m_macPacketTracker.records.pop_front ();
+      m_macPacketTracker.firstSequenceNumber++;
+    }
+
+  while (!m_reTransmissionTracker.records.empty ()
+         && m_reTransmissionTracker.records.front ().finishTime < threshold)
+    {
+      m_reTransmissionTracker.index.Erase (m_reTransmissionTracker.records.front ().uid);
+      m_reTransmissionTracker.records.pop_front ();
+      m_reTransmissionTracker.firstSequenceNumber++;
+    }
+}
+
 /////////////////
 // MAC metrics //
 /////////////////
@@ -50,14 +172,23 @@ LoraPacketTracker::MacTransmissionCallback (Ptr<Packet const> packet)
     {
       NS_LOG_INFO ("A new packet was sent by the MAC layer");
 
-      MacPacketStatus status;
-      status.packet = packet;
-      status.sendTime = Simulator::Now ();
-      status.senderId = Simulator::GetContext ();
-      status.receivedTime = Time::Max ();
+      RetireOldRecords ();
 
-      m_macPacketTracker.insert (std::pair<Ptr<Packet const>, MacPacketStatus>
-                                   (packet, status));
+      uint64_t sequenceNumber = m_macPacketTracker.firstSequenceNumber +
+        m_macPacketTracker.records.size ();
+      if (m_macPacketTracker.index.Insert (packet->GetUid (), sequenceNumber))
+        {
+          MacPacketStatus status;
+          status.uid = packet->GetUid ();
+          status.sendTime = Simulator::Now ();
+          status.senderId = Simulator::GetContext ();
+          status.receivedTime = Time::Max ();
+          m_macPacketTracker.records.push_back (status);
+          if (!m_bucketWidth.IsZero ())
+            {
+              m_buckets[GetBucketIndex (status.sendTime)].macSent++;
+            }
+        }
     }
 }
 
@@ -71,38 +202,55 @@ LoraPacketTracker::RequiredTransmissionsCallback (uint8_t reqTx, bool success,
                 ", succ: " << success << ", firstAttempt: " <<
                 firstAttempt.GetSeconds ());
 
-  RetransmissionStatus entry;
-  entry.firstAttempt = firstAttempt;
-  entry.finishTime = Simulator::Now ();
-  entry.reTxAttempts = reqTx;
-  entry.successful = success;
+  RetireOldRecords ();
 
-  m_reTransmissionTracker.insert (std::pair<Ptr<Packet>, RetransmissionStatus>
-                                    (packet, entry));
+  uint64_t sequenceNumber = m_reTransmissionTracker.firstSequenceNumber +
+    m_reTransmissionTracker.records.size ();
+  if (m_reTransmissionTracker.index.Insert (packet->GetUid (), sequenceNumber))
+    {
+      RetransmissionStatus entry;
+      entry.uid = packet->GetUid ();
+      entry.firstAttempt = firstAttempt;
+      entry.finishTime = Simulator::Now ();
+      entry.reTxAttempts = reqTx;
+      entry.successful = success;
+      m_reTransmissionTracker.records.push_back (entry);
+      if (!m_bucketWidth.IsZero ())
+        {
+          StatisticsBucket &bucket = m_buckets[GetBucketIndex (firstAttempt)];
+          bucket.cpsrSent++;
+          bucket.cpsrReceived += success;
+        }
+    }
 }
 
 void
 LoraPacketTracker::MacGwReceptionCallback (Ptr<Packet const> packet)
 {
-  if (IsUplink (packet))
+  // Downlink packets are never tracked, so there is no need to check the
+  // direction of the packet before looking it up
+  int64_t position = FindRecord (m_macPacketTracker, packet);
+  if (position >= 0)
     {
       NS_LOG_INFO ("A packet was successfully received" <<
                    " at the MAC layer of gateway " <<
                    Simulator::GetContext ());
 
-      // Find the received packet in the m_macPacketTracker
-      auto it = m_macPacketTracker.find (packet);
-      if (it != m_macPacketTracker.end ())
-        {
-          (*it).second.receptionTimes.insert (std::pair<int, Time>
-                                                (Simulator::GetContext (),
-                                                Simulator::Now ()));
-        }
-      else
+      MacPacketStatus &status = m_macPacketTracker.records[position];
+      if (status.receivedTime == Time::Max ())
         {
-          NS_ABORT_MSG ("Packet not found in tracker");
+          status.receivedTime = Simulator::Now ();
+          if (!m_bucketWidth.IsZero ())
+            {
+              m_buckets[GetBucketIndex (status.sendTime)].macReceived++;
+            }
         }
     }
+  else
+    {
+      NS_ABORT_MSG_IF (m_horizon.IsZero () && IsUplink (packet),
+                       "Packet not found in tracker");
+    }
 }
 
 /////////////////
@@ -117,89 +265,101 @@ LoraPacketTracker::TransmissionCallback (Ptr<Packet const> packet, uint32_t edId
       NS_LOG_INFO ("PHY packet " << packet
                                  << " was transmitted by device "
                                  << edId);
-      // Create a packetStatus
-      PacketStatus status;
-      status.packet = packet;
-      status.sendTime = Simulator::Now ();
-      status.senderId = edId;
 
-      m_packetTracker.insert (std::pair<Ptr<Packet const>, PacketStatus> (packet, status));
+      RetireOldRecords ();
+
+      uint64_t sequenceNumber = m_packetTracker.firstSequenceNumber +
+        m_packetTracker.records.size ();
+      if (m_packetTracker.index.Insert (packet->GetUid (), sequenceNumber))
+        {
+          PacketStatus status;
+          status.uid = packet->GetUid ();
+          status.sendTime = Simulator::Now ();
+          status.senderId = edId;
+          m_packetTracker.records.push_back (status);
+          for (auto &column : m_phyOutcomes)
+            {
+              column.push_back (UNSET);
+            }
+          if (!m_bucketWidth.IsZero ())
+            {
+              m_buckets[GetBucketIndex (status.sendTime)].phySent++;
+            }
+        }
     }
 }
 
 void
-LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t gwId)
+LoraPacketTracker::SetPhyOutcome (Ptr<Packet const> packet, uint32_t gwId,
+                                  enum PhyPacketOutcome outcome)
 {
-  if (IsUplink (packet))
+  // Downlink packets are never tracked, so there is no need to check the
+  // direction of the packet before looking it up
+  int64_t position = FindRecord (m_packetTracker, packet);
+  if (position >= 0)
     {
-      // Remove the successfully received packet from the list of sent ones
-      NS_LOG_INFO ("PHY packet " << packet
-                                 << " was successfully received at gateway "
-                                 << gwId);
-
-      std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
-      (*it).second.outcomes.insert (std::pair<int, enum PhyPacketOutcome> (gwId,
-                                                                           RECEIVED));
+      std::size_t gwIndex = GetGatewayIndex (gwId);
+      uint8_t &entry = m_phyOutcomes[gwIndex][position];
+      if (entry == UNSET)
+        {
+          entry = outcome;
+          if (!m_bucketWidth.IsZero ())
+            {
+              Time sendTime = m_packetTracker.records[position].sendTime;
+              m_outcomeBuckets[gwIndex][GetBucketIndex (sendTime)][outcome]++;
+            }
+        }
     }
 }
 
+void
+LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t gwId)
+{
+  NS_LOG_INFO ("PHY packet " << packet
+                             << " was successfully received at gateway "
+                             << gwId);
+
+  SetPhyOutcome (packet, gwId, RECEIVED);
+}
+
 void
 LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
-  if (IsUplink (packet))
-    {
-      NS_LOG_INFO ("PHY packet " << packet
-                                 << " was interfered at gateway "
-                                 << gwId);
+  NS_LOG_INFO ("PHY packet " << packet
+                             << " was interfered at gateway "
+                             << gwId);
 
-      std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
-      (*it).second.outcomes.insert (std::pair<int, enum PhyPacketOutcome> (gwId,
-                                                                           INTERFERED));
-    }
+  SetPhyOutcome (packet, gwId, INTERFERED);
 }
 
 void
 LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
-  if (IsUplink (packet))
-    {
-      NS_LOG_INFO ("PHY packet " << packet
-                                 << " was lost because no more receivers at gateway "
-                                 << gwId);
-      std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
-      (*it).second.outcomes.insert (std::pair<int, enum PhyPacketOutcome> (gwId,
-                                                                           NO_MORE_RECEIVERS));
-    }
+  NS_LOG_INFO ("PHY packet " << packet
+                             << " was lost because no more receivers at gateway "
+                             << gwId);
+
+  SetPhyOutcome (packet, gwId, NO_MORE_RECEIVERS);
 }
 
 void
 LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
-  if (IsUplink (packet))
-    {
-      NS_LOG_INFO ("PHY packet " << packet
-                                 << " was lost because under sensitivity at gateway "
-                                 << gwId);
+  NS_LOG_INFO ("PHY packet " << packet
+                             << " was lost because under sensitivity at gateway "
+                             << gwId);
 
-      std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
-      (*it).second.outcomes.insert (std::pair<int, enum PhyPacketOutcome> (gwId,
-                                                                           UNDER_SENSITIVITY));
-    }
+  SetPhyOutcome (packet, gwId, UNDER_SENSITIVITY);
 }
 
 void
 LoraPacketTracker::LostBecauseTxCallback (Ptr<Packet const> packet, uint32_t gwId)
 {
-  if (IsUplink (packet))
-    {
-      NS_LOG_INFO ("PHY packet " << packet
-                                 << " was lost because of GW transmission at gateway "
-                                 << gwId);
+  NS_LOG_INFO ("PHY packet " << packet
+                             << " was lost because of GW transmission at gateway "
+                             << gwId);
 
-      std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
-      (*it).second.outcomes.insert (std::pair<int, enum PhyPacketOutcome> (gwId,
-                                                                           LOST_BECAUSE_TX));
-    }
+  SetPhyOutcome (packet, gwId, LOST_BECAUSE_TX);
 }
 
 bool
@@ -227,83 +387,44 @@ LoraPacketTracker::CountPhyPacketsPerGw (Time startTime, Time stopTime,
 
   std::vector<int> packetCounts (6, 0);
 
-  for (auto itPhy = m_packetTracker.begin ();
-       itPhy != m_packetTracker.end ();
-       ++itPhy)
+  std::size_t *gwIndex = m_gwIndices.Find (gwId);
+
+  if (!m_bucketWidth.IsZero ())
     {
-      if ((*itPhy).second.sendTime >= startTime && (*itPhy).second.sendTime <= stopTime)
+      std::size_t first, last;
+      GetBucketRange (startTime, stopTime, first, last);
+      for (std::size_t b = first; b < last; b++)
         {
-          packetCounts.at (0)++;
-
-          NS_LOG_DEBUG ("Dealing with packet " << (*itPhy).second.packet);
-          NS_LOG_DEBUG ("This packet was received by " <<
-                        (*itPhy).second.outcomes.size () << " gateways");
-
-          if ((*itPhy).second.outcomes.count (gwId) > 0)
+          packetCounts.at (0) += m_buckets[b].phySent;
+          if (gwIndex != 0)
             {
-              switch ((*itPhy).second.outcomes.at (gwId))
+              for (int outcome = RECEIVED; outcome <= LOST_BECAUSE_TX; outcome++)
                 {
-                case RECEIVED:
-                  {
-                    packetCounts.at (1)++;
-                    break;
-                  }
-                case INTERFERED:
-                  {
-                    packetCounts.at (2)++;
-                    break;
-                  }
-                case NO_MORE_RECEIVERS:
-                  {
-                    packetCounts.at (3)++;
-                    break;
-                  }
-                case UNDER_SENSITIVITY:
-                  {
-                    packetCounts.at (4)++;
-                    break;
-                  }
-                case LOST_BECAUSE_TX:
-                  {
-                    packetCounts.at (5)++;
-                    break;
-                  }
-                case UNSET:
-                  {
-                    break;
-                  }
+                  packetCounts.at (outcome + 1) += m_outcomeBuckets[*gwIndex][b][outcome];
                 }
             }
         }
+      return packetCounts;
     }
 
-  return packetCounts;
-}
-std::string
-LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
-                                         int gwId)
-{
-  // Vector packetCounts will contain - for the interval given in the input of
-  // the function, the following fields: totPacketsSent receivedPackets
-  // interferedPackets noMoreGwPackets underSensitivityPackets lostBecauseTxPackets
-
-  std::vector<int> packetCounts (6, 0);
+  const std::deque<uint8_t> *outcomes = 0;
+  if (gwIndex != 0)
+    {
+      outcomes = &m_phyOutcomes[*gwIndex];
+    }
 
-  for (auto itPhy = m_packetTracker.begin ();
-       itPhy != m_packetTracker.end ();
-       ++itPhy)
+  for (std::size_t i = 0; i < m_packetTracker.records.size (); i++)
     {
-      if ((*itPhy).second.sendTime >= startTime && (*itPhy).second.sendTime <= stopTime)
+      const PacketStatus &status = m_packetTracker.records[i];
+      if (status.sendTime >= startTime && status.sendTime <= stopTime)
         {
           packetCounts.at (0)++;
 
-          NS_LOG_DEBUG ("Dealing with packet " << (*itPhy).second.packet);
-          NS_LOG_DEBUG ("This packet was received by " <<
-                        (*itPhy).second.outcomes.size () << " gateways");
+          NS_LOG_DEBUG ("Dealing with packet " << status.uid);
 
-          if ((*itPhy).second.outcomes.count (gwId) > 0)
+          if (outcomes != 0)
             {
-              switch ((*itPhy).second.outcomes.at (gwId))
+              switch ((*outcomes)[i])
                 {
                 case RECEIVED:
                   {
@@ -330,7 +451,7 @@ LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
                     packetCounts.at (5)++;
                     break;
                   }
-                case UNSET:
+                default:
                   {
                     break;
                   }
@@ -339,6 +460,15 @@ LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
         }
     }
 
+  return packetCounts;
+}
+
+std::string
+LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
+                                         int gwId)
+{
+  std::vector<int> packetCounts = CountPhyPacketsPerGw (startTime, stopTime, gwId);
+
   std::string output ("");
   for (int i = 0; i < 6; ++i)
     {
@@ -353,24 +483,44 @@ LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
   {
     NS_LOG_FUNCTION (this << startTime << stopTime);
 
-    double sent = 0;
-    double received = 0;
-    for (auto it = m_macPacketTracker.begin ();
-         it != m_macPacketTracker.end ();
-         ++it)
+    std::vector<int> packetCounts = CountMacPacketsGloballyValues (startTime, stopTime);
+
+    return std::to_string (double (packetCounts.at (0))) + " " +
+      std::to_string (double (packetCounts.at (1)));
+  }
+
+  std::vector<int>
+  LoraPacketTracker::CountMacPacketsGloballyValues (Time startTime, Time stopTime)
+  {
+    NS_LOG_FUNCTION (this << startTime << stopTime);
+
+    std::vector<int> packetCounts (2, 0);
+
+    if (!m_bucketWidth.IsZero ())
       {
-        if ((*it).second.sendTime >= startTime && (*it).second.sendTime <= stopTime)
+        std::size_t first, last;
+        GetBucketRange (startTime, stopTime, first, last);
+        for (std::size_t b = first; b < last; b++)
           {
-            sent++;
-            if ((*it).second.receptionTimes.size ())
+            packetCounts.at (0) += m_buckets[b].macSent;
+            packetCounts.at (1) += m_buckets[b].macReceived;
+          }
+        return packetCounts;
+      }
+
+    for (auto &status : m_macPacketTracker.records)
+      {
+        if (status.sendTime >= startTime && status.sendTime <= stopTime)
+          {
+            packetCounts.at (0)++;
+            if (status.receivedTime != Time::Max ())
               {
-                received++;
+                packetCounts.at (1)++;
               }
           }
       }
 
-    return std::to_string (sent) + " " +
-      std::to_string (received);
+    return packetCounts;
   }
 
   std::string
@@ -380,17 +530,29 @@ LoraPacketTracker::PrintPhyPacketsPerGw (Time startTime, Time stopTime,
 
     double sent = 0;
     double received = 0;
-    for (auto it = m_reTransmissionTracker.begin ();
-         it != m_reTransmissionTracker.end ();
-         ++it)
+
+    if (!m_bucketWidth.IsZero ())
+      {
+        std::size_t first, last;
+        GetBucketRange (startTime, stopTime, first, last);
+        for (std::size_t b = first; b < last; b++)
+          {
+            sent += m_buckets[b].cpsrSent;
+            received += m_buckets[b].cpsrReceived;
+          }
+        return std::to_string (sent) + " " +
+          std::to_string (received);
+      }
+
+    for (auto &entry : m_reTransmissionTracker.records)
       {
-        if ((*it).second.firstAttempt >= startTime && (*it).second.firstAttempt <= stopTime)
+        if (entry.firstAttempt >= startTime && entry.firstAttempt <= stopTime)
           {
             sent++;
             NS_LOG_DEBUG ("Found a packet");
-            NS_LOG_DEBUG ("Number of attempts: " << unsigned(it->second.reTxAttempts) <<
-                          ", successful: " << it->second.successful);
-            if (it->second.successful)
+            NS_LOG_DEBUG ("Number of attempts: " << unsigned(entry.reTxAttempts) <<
+                          ", successful: " << entry.successful);
+            if (entry.successful)
               {
                 received++;
               }
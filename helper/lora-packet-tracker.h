@@ -23,9 +23,12 @@
 
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
+#include "ns3/uid-hash-map.h"
 
-#include <map>
+#include <array>
+#include <deque>
 #include <string>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -42,32 +45,44 @@ enum PhyPacketOutcome
 
 struct PacketStatus
 {
-  Ptr<Packet const> packet;
+  uint64_t uid;
   uint32_t senderId;
   Time sendTime;
-  std::map<int, enum PhyPacketOutcome> outcomes;
 };
 
 struct MacPacketStatus
 {
-  Ptr<Packet const> packet;
+  uint64_t uid;
   uint32_t senderId;
   Time sendTime;
   Time receivedTime;
-  std::map<int, Time> receptionTimes;
 };
 
 struct RetransmissionStatus
 {
+  uint64_t uid;
   Time firstAttempt;
   Time finishTime;
   uint8_t reTxAttempts;
   bool successful;
 };
 
-typedef std::map<Ptr<Packet const>, MacPacketStatus> MacPacketData;
-typedef std::map<Ptr<Packet const>, PacketStatus> PhyPacketData;
-typedef std::map<Ptr<Packet const>, RetransmissionStatus> RetransmissionData;
+/**
+ * Tracked packets, in the order in which they were inserted. The record with
+ * sequence number n is at position n - firstSequenceNumber, and it can be
+ * looked up by packet UID through the index.
+ */
+template <typename T>
+struct PacketRecords
+{
+  std::deque<T> records;
+  uint64_t firstSequenceNumber = 0;
+  UidHashMap<uint64_t> index;
+};
+
+typedef PacketRecords<MacPacketStatus> MacPacketData;
+typedef PacketRecords<PacketStatus> PhyPacketData;
+typedef PacketRecords<RetransmissionStatus> RetransmissionData;
 
 
 class LoraPacketTracker
@@ -149,6 +164,15 @@ public:
    */
   std::string CountMacPacketsGlobally (Time startTime, Time stopTime);
 
+  /**
+   * Count packets to evaluate the global performance at MAC level of the whole
+   * network, like CountMacPacketsGlobally does.
+   *
+   * This returns a vector containing the number of sent packets and the
+   * number of packets that were received by at least one gateway.
+   */
+  std::vector<int> CountMacPacketsGloballyValues (Time startTime, Time stopTime);
+
   /**
    * Count packets to evaluate the global performance at MAC level of the whole
    * network. In this case, a MAC layer packet is labeled as successful if it
@@ -159,10 +183,116 @@ public:
    * of packets that generated a successful acknowledgment.
    */
   std::string CountMacPacketsGloballyCpsr (Time startTime, Time stopTime);
+
+  /**
+   * Only keep track of packets for a limited amount of time.
+   *
+   * Packets that were sent more than horizon ago are forgotten, so that the
+   * memory used by the tracker does not grow with the simulation time.
+   * Counting functions will only take into account the packets that are
+   * still tracked, so the horizon should be larger than the intervals that
+   * are passed to them, plus the time it takes for a packet to be received
+   * and acknowledged.
+   *
+   * \param horizon The time for which packets are tracked, or zero to track
+   * them for the whole simulation (the default).
+   */
+  void SetHorizon (Time horizon);
+
+  /**
+   * Keep counters of packets and outcomes, aggregated in time buckets.
+   *
+   * Counters are updated as trace sources fire, in the bucket of the time a
+   * packet was sent (or, for retransmission statistics, of the time of its
+   * first transmission attempt). Counting functions then sum the buckets
+   * that fall in the requested interval instead of going through all the
+   * tracked packets, so that periodic reports don't get slower as the
+   * simulation goes on, and they are not limited by the horizon set with
+   * SetHorizon.
+   *
+   * Since counters have the granularity of a bucket, the interval passed to
+   * counting functions becomes [startTime, stopTime), with both ends rounded
+   * down to a multiple of the bucket width. This method should be called
+   * before any packet is sent. LoraHelper calls it when periodic performance
+   * printing is enabled.
+   *
+   * \param bucketWidth The width of the time buckets.
+   */
+  void EnableStreamingStatistics (Time bucketWidth);
+
+  /**
+   * \return The width of the time buckets, or zero if streaming statistics
+   * are not enabled.
+   */
+  Time GetStreamingStatisticsBucketWidth (void) const;
+
 private:
+  /**
+   * Counters of the packets sent in a time bucket.
+   */
+  struct StatisticsBucket
+  {
+    uint32_t phySent = 0;
+    uint32_t macSent = 0;
+    uint32_t macReceived = 0;
+    uint32_t cpsrSent = 0;
+    uint32_t cpsrReceived = 0;
+  };
+
+  /**
+   * Get the index of the bucket containing a certain time, creating all
+   * buckets up to it if necessary.
+   */
+  std::size_t GetBucketIndex (Time time);
+
+  /**
+   * Get the range of buckets to sum to answer a query over an interval.
+   */
+  void GetBucketRange (Time startTime, Time stopTime, std::size_t &first,
+                       std::size_t &last) const;
+
+  /**
+   * Get the position of a gateway in the outcome columns, adding a column
+   * for it if it was not seen before.
+   */
+  std::size_t GetGatewayIndex (uint32_t gwId);
+
+  /**
+   * Find the position of a tracked packet.
+   *
+   * \return The position, or -1 if the packet is not tracked.
+   */
+  template <typename T>
+  int64_t FindRecord (PacketRecords<T> &data, Ptr<Packet const> packet);
+
+  /**
+   * Set the outcome of a PHY packet at a gateway, unless one was already set.
+   */
+  void SetPhyOutcome (Ptr<Packet const> packet, uint32_t gwId,
+                      enum PhyPacketOutcome outcome);
+
+  /**
+   * Forget about packets that were tracked more than m_horizon ago.
+   */
+  void RetireOldRecords (void);
+
   PhyPacketData m_packetTracker;
   MacPacketData m_macPacketTracker;
   RetransmissionData m_reTransmissionTracker;
+
+  std::vector<uint32_t> m_gwIds; //!< The gateway of each outcome column
+  UidHashMap<std::size_t> m_gwIndices; //!< Column of each gateway
+
+  // Per-gateway columns, parallel to the PHY records, holding the outcome of
+  // each packet at the gateway
+  std::vector<std::deque<uint8_t> > m_phyOutcomes;
+
+  Time m_bucketWidth; //!< Width of statistics buckets, or zero if disabled
+  std::vector<StatisticsBucket> m_buckets; //!< Statistics over time
+  // Per-gateway PHY outcome counters of each bucket
+  std::vector<std::vector<std::array<uint32_t, 5> > > m_outcomeBuckets;
+
+  Time m_horizon; //!< How long packets are tracked for, or zero for ever
 };
 }
 }
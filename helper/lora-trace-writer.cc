@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lora-trace-writer.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include <cstring>
+#include <iomanip>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraTraceWriter");
+
+const char LoraTraceWriter::m_magic[8] = {'L', 'O', 'R', 'A', 'T', 'R', 'C', '1'};
+
+// Used to detect traces written on machines with a different byte order
+static const uint16_t byteOrderMark = 0x0102;
+
+// The names used in CSV files for each record type
+static const char *recordTypeNames[LoraTraceWriter::N_RECORD_TYPES] =
+  {"device-status", "phy-performance", "global-performance"};
+
+LoraTraceWriter::LoraTraceWriter (std::string filename, uint32_t blockSize) :
+  m_blockSize (blockSize)
+{
+  NS_LOG_FUNCTION (this << filename << blockSize);
+
+  NS_ASSERT (blockSize > 0);
+
+  m_file.open (filename.c_str (), std::ofstream::out | std::ofstream::trunc |
+               std::ofstream::binary);
+  NS_ABORT_MSG_IF (!m_file.is_open (), "Unable to open " << filename);
+  m_file.write (m_magic, sizeof (m_magic));
+  m_file.write (reinterpret_cast<const char *> (&byteOrderMark), sizeof (byteOrderMark));
+
+  for (int type = 0; type < N_RECORD_TYPES; type++)
+    {
+      const std::vector<Column> &schema = GetSchema (RecordType (type));
+      m_blocks[type].columns.resize (schema.size ());
+      for (std::size_t c = 0; c < schema.size (); c++)
+        {
+          m_blocks[type].columns[c].reserve (blockSize * GetSize (schema[c].type));
+        }
+      m_blocks[type].nRecords = 0;
+    }
+}
+
+LoraTraceWriter::~LoraTraceWriter ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Flush ();
+  m_file.close ();
+}
+
+const std::vector<LoraTraceWriter::Column> &
+LoraTraceWriter::GetSchema (RecordType type)
+{
+  static const std::vector<Column> schemas[N_RECORD_TYPES] = {
+    {{"time", DOUBLE}, {"nodeId", UINT32}, {"x", DOUBLE}, {"y", DOUBLE},
+     {"dataRate", UINT8}, {"txPower", UINT8}},
+    {{"time", DOUBLE}, {"gwId", UINT32}, {"sent", UINT32}, {"received", UINT32},
+     {"interfered", UINT32}, {"noMoreReceivers", UINT32},
+     {"underSensitivity", UINT32}, {"lostBecauseTx", UINT32}},
+    {{"time", DOUBLE}, {"sent", UINT32}, {"received", UINT32}}};
+
+  NS_ASSERT (type < N_RECORD_TYPES);
+  return schemas[type];
+}
+
+std::size_t
+LoraTraceWriter::GetSize (ColumnType type)
+{
+  switch (type)
+    {
+    case DOUBLE:
+      return sizeof (double);
+    case UINT32:
+      return sizeof (uint32_t);
+    case UINT8:
+      return sizeof (uint8_t);
+    }
+  return 0;
+}
+
+template <typename T>
+void
+LoraTraceWriter::Append (RecordType type, std::size_t column, T value)
+{
+  std::vector<char> &data = m_blocks[type].columns[column];
+  NS_ASSERT (GetSize (GetSchema (type)[column].type) == sizeof (T));
+  std::size_t offset = data.size ();
+  data.resize (offset + sizeof (T));
+  std::memcpy (&data[offset], &value, sizeof (T));
+}
+
+void
+LoraTraceWriter::EndRecord (RecordType type)
+{
+  if (++m_blocks[type].nRecords == m_blockSize)
+    {
+      WriteBlock (type);
+    }
+}
+
+void
+LoraTraceWriter::WriteBlock (RecordType type)
+{
+  Block &block = m_blocks[type];
+  if (block.nRecords == 0)
+    {
+      return;
+    }
+
+  NS_LOG_DEBUG ("Writing a block of " << block.nRecords << " records of type " << type);
+
+  uint8_t recordType = type;
+  m_file.write (reinterpret_cast<const char *> (&recordType), sizeof (recordType));
+  m_file.write (reinterpret_cast<const char *> (&block.nRecords), sizeof (block.nRecords));
+  for (auto &column : block.columns)
+    {
+      m_file.write (column.data (), column.size ());
+      column.clear ();
+    }
+  block.nRecords = 0;
+}
+
+void
+LoraTraceWriter::WriteDeviceStatus (Time time, uint32_t nodeId, Vector position,
+                                    uint8_t dataRate, uint8_t txPowerDbm)
+{
+  Append (DEVICE_STATUS, 0, time.GetSeconds ());
+  Append (DEVICE_STATUS, 1, nodeId);
+  Append (DEVICE_STATUS, 2, position.x);
+  Append (DEVICE_STATUS, 3, position.y);
+  Append (DEVICE_STATUS, 4, dataRate);
+  Append (DEVICE_STATUS, 5, txPowerDbm);
+  EndRecord (DEVICE_STATUS);
+}
+
+void
+LoraTraceWriter::WritePhyPerformance (Time time, uint32_t gwId,
+                                      const std::vector<int> &packetCounts)
+{
+  NS_ASSERT (packetCounts.size () == 6);
+
+  Append (PHY_PERFORMANCE, 0, time.GetSeconds ());
+  Append (PHY_PERFORMANCE, 1, gwId);
+  for (std::size_t i = 0; i < 6; i++)
+    {
+      Append (PHY_PERFORMANCE, i + 2, uint32_t (packetCounts[i]));
+    }
+  EndRecord (PHY_PERFORMANCE);
+}
+
+void
+LoraTraceWriter::WriteGlobalPerformance (Time time, uint32_t sent, uint32_t received)
+{
+  Append (GLOBAL_PERFORMANCE, 0, time.GetSeconds ());
+  Append (GLOBAL_PERFORMANCE, 1, sent);
+  Append (GLOBAL_PERFORMANCE, 2, received);
+  EndRecord (GLOBAL_PERFORMANCE);
+}
+
+void
+LoraTraceWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (int type = 0; type < N_RECORD_TYPES; type++)
+    {
+      WriteBlock (RecordType (type));
+    }
+  m_file.flush ();
+}
+
+/////////////////////
+// LoraTraceReader //
+/////////////////////
+
+int64_t
+LoraTraceReader::ConvertToCsv (std::string filename, std::string prefix)
+{
+  NS_LOG_FUNCTION (filename << prefix);
+
+  std::ifstream input (filename.c_str (), std::ifstream::in | std::ifstream::binary);
+  char magic[sizeof (LoraTraceWriter::m_magic)];
+  uint16_t mark;
+  if (!input.read (magic, sizeof (magic))
+      || std::memcmp (magic, LoraTraceWriter::m_magic, sizeof (magic)) != 0
+      || !input.read (reinterpret_cast<char *> (&mark), sizeof (mark))
+      || mark != byteOrderMark)
+    {
+      NS_LOG_ERROR ("File " << filename << " is not a trace written on this machine");
+      return -1;
+    }
+
+  std::ofstream outputs[LoraTraceWriter::N_RECORD_TYPES];
+  int64_t nRecords = 0;
+  uint8_t recordType;
+  while (input.read (reinterpret_cast<char *> (&recordType), sizeof (recordType)))
+    {
+      uint32_t blockRecords;
+      if (recordType >= LoraTraceWriter::N_RECORD_TYPES
+          || !input.read (reinterpret_cast<char *> (&blockRecords), sizeof (blockRecords)))
+        {
+          NS_LOG_ERROR ("Corrupted block in " << filename);
+          return -1;
+        }
+
+      const std::vector<LoraTraceWriter::Column> &schema =
+        LoraTraceWriter::GetSchema (LoraTraceWriter::RecordType (recordType));
+
+      // Read the columns of the block
+      std::vector<std::vector<char> > columns (schema.size ());
+      for (std::size_t c = 0; c < schema.size (); c++)
+        {
+          columns[c].resize (std::size_t (blockRecords) *
+                             LoraTraceWriter::GetSize (schema[c].type));
+          if (!input.read (columns[c].data (), columns[c].size ()))
+            {
+              NS_LOG_ERROR ("Truncated block in " << filename);
+              return -1;
+            }
+        }
+
+      // Open the CSV file of this record type the first time it is needed
+      std::ofstream &output = outputs[recordType];
+      if (!output.is_open ())
+        {
+          std::string csvName = prefix + "-" + recordTypeNames[recordType] + ".csv";
+          output.open (csvName.c_str (), std::ofstream::out | std::ofstream::trunc);
+          if (!output.is_open ())
+            {
+              NS_LOG_ERROR ("Unable to open " << csvName);
+              return -1;
+            }
+          output << std::setprecision (15);
+          for (std::size_t c = 0; c < schema.size (); c++)
+            {
+              output << (c ? "," : "") << schema[c].name;
+            }
+          output << "\n";
+        }
+
+      // Write the records of the block row by row
+      for (uint32_t r = 0; r < blockRecords; r++)
+        {
+          for (std::size_t c = 0; c < schema.size (); c++)
+            {
+              const char *value =
+                &columns[c][r * LoraTraceWriter::GetSize (schema[c].type)];
+              output << (c ? "," : "");
+              switch (schema[c].type)
+                {
+                case LoraTraceWriter::DOUBLE:
+                  {
+                    double v;
+                    std::memcpy (&v, value, sizeof (v));
+                    output << v;
+                    break;
+                  }
+                case LoraTraceWriter::UINT32:
+                  {
+                    uint32_t v;
+                    std::memcpy (&v, value, sizeof (v));
+                    output << v;
+                    break;
+                  }
+                case LoraTraceWriter::UINT8:
+                  {
+                    output << unsigned (uint8_t (*value));
+                    break;
+                  }
+                }
+            }
+          output << "\n";
+        }
+      nRecords += blockRecords;
+    }
+
+  return nRecords;
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LORA_TRACE_WRITER_H
+#define LORA_TRACE_WRITER_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Writes the periodic reports of LoraHelper to a binary file.
+ *
+ * Records of each type have a fixed schema, and are buffered column by
+ * column: once a block of records is complete, each column is written as a
+ * contiguous array of values. The file starts with a header containing a
+ * magic string and a byte order mark, followed by blocks, each made of the
+ * record type (one byte), the number of records (four bytes) and the
+ * columns, in the order given by GetSchema. Values are written in the byte
+ * order of the machine running the simulation.
+ *
+ * LoraTraceReader can be used to convert these files to CSV.
+ */
+class LoraTraceWriter : public SimpleRefCount<LoraTraceWriter>
+{
+public:
+  /**
+   * The types of records that can be written.
+   */
+  enum RecordType
+  {
+    DEVICE_STATUS,
+    PHY_PERFORMANCE,
+    GLOBAL_PERFORMANCE,
+    N_RECORD_TYPES
+  };
+
+  /**
+   * The types of values a column can hold.
+   */
+  enum ColumnType
+  {
+    DOUBLE,
+    UINT32,
+    UINT8
+  };
+
+  /**
+   * The description of a column of a record type.
+   */
+  struct Column
+  {
+    const char *name;
+    ColumnType type;
+  };
+
+  /**
+   * Create a writer, truncating the file if it exists.
+   *
+   * \param filename The file to write to.
+   * \param blockSize The number of records of a type to buffer before
+   * writing them out.
+   */
+  LoraTraceWriter (std::string filename, uint32_t blockSize = 4096);
+
+  ~LoraTraceWriter ();
+
+  /**
+   * Write the status of an end device.
+   */
+  void WriteDeviceStatus (Time time, uint32_t nodeId, Vector position,
+                          uint8_t dataRate, uint8_t txPowerDbm);
+
+  /**
+   * Write the PHY performance at a gateway, as returned by
+   * LoraPacketTracker::CountPhyPacketsPerGw.
+   */
+  void WritePhyPerformance (Time time, uint32_t gwId,
+                            const std::vector<int> &packetCounts);
+
+  /**
+   * Write the global MAC performance of the network.
+   */
+  void WriteGlobalPerformance (Time time, uint32_t sent, uint32_t received);
+
+  /**
+   * Write out all buffered records.
+   */
+  void Flush (void);
+
+  /**
+   * Get the columns of a record type.
+   */
+  static const std::vector<Column> &GetSchema (RecordType type);
+
+  /**
+   * Get the size in bytes of a value of a column type.
+   */
+  static std::size_t GetSize (ColumnType type);
+
+  /**
+   * The string at the beginning of files written by this class.
+   */
+  static const char m_magic[8];
+
+private:
+  /**
+   * The buffered records of a type, column by column.
+   */
+  struct Block
+  {
+    std::vector<std::vector<char> > columns;
+    uint32_t nRecords;
+  };
+
+  /**
+   * Append a value to a column of the block of a record type.
+   */
+  template <typename T>
+  void Append (RecordType type, std::size_t column, T value);
+
+  /**
+   * Mark the end of a record, writing out the block if it is full.
+   */
+  void EndRecord (RecordType type);
+
+  /**
+   * Write out the block of a record type, if it holds any record.
+   */
+  void WriteBlock (RecordType type);
+
+  std::ofstream m_file; //!< The output file
+  uint32_t m_blockSize; //!< The number of records in a full block
+  Block m_blocks[N_RECORD_TYPES]; //!< The blocks being filled
+};
+
+/**
+ * Converts files written by LoraTraceWriter to CSV.
+ */
+class LoraTraceReader
+{
+public:
+  /**
+   * Convert a binary trace to CSV files, one per record type found in the
+   * trace. Each CSV file is named after the prefix and the record type
+   * (e.g., prefix-device-status.csv), and starts with a line containing
+   * the names of the columns.
+   *
+   * \param filename The binary trace to read.
+   * \param prefix The prefix of the CSV files to write.
+   * \return The number of records that were converted, or -1 if the file
+   * could not be read.
+   */
+  static int64_t ConvertToCsv (std::string filename, std::string prefix);
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORA_TRACE_WRITER_H */
@@ -224,19 +224,23 @@ LorawanMacHelper::ApplyCommonAlohaConfigurations (Ptr<LorawanMac> lorawanMac) co
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  //////////////
-  // SubBands //
-  //////////////
+  // The channel plan is created once, and shared by all devices
+  if (!m_alohaPlan)
+    {
+      //////////////
+      // SubBands //
+      //////////////
 
-  LogicalLoraChannelHelper channelHelper;
-  channelHelper.AddSubBand (868, 868.6, 1, 14);
+      m_alohaPlan = Create<RegionalChannelPlan> ();
+      m_alohaPlan->AddSubBand (Create<SubBand> (868, 868.6, 1, 14));
 
-  //////////////////////
-  // Default channels //
-  //////////////////////
-  Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel> (868.1, 0, 5);
-  channelHelper.AddChannel (lc1);
+      //////////////////////
+      // Default channels //
+      //////////////////////
+      m_alohaPlan->AddChannel (CreateObject<LogicalLoraChannel> (868.1, 0, 5));
+    }
 
+  LogicalLoraChannelHelper channelHelper (m_alohaPlan);
   lorawanMac->SetLogicalLoraChannelHelper (channelHelper);
 
   ///////////////////////////////////////////////
@@ -326,25 +330,27 @@ LorawanMacHelper::ApplyCommonEuConfigurations (Ptr<LorawanMac> lorawanMac) const
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  //////////////
-  // SubBands //
-  //////////////
-
-  LogicalLoraChannelHelper channelHelper;
-  channelHelper.AddSubBand (868, 868.6, 0.01, 14);
-  channelHelper.AddSubBand (868.7, 869.2, 0.001, 14);
-  channelHelper.AddSubBand (869.4, 869.65, 0.1, 27);
-
-  //////////////////////
-  // Default channels //
-  //////////////////////
-  Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel> (868.1, 0, 5);
-  Ptr<LogicalLoraChannel> lc2 = CreateObject<LogicalLoraChannel> (868.3, 0, 5);
-  Ptr<LogicalLoraChannel> lc3 = CreateObject<LogicalLoraChannel> (868.5, 0, 5);
-  channelHelper.AddChannel (lc1);
-  channelHelper.AddChannel (lc2);
-  channelHelper.AddChannel (lc3);
+  // The channel plan is created once, and shared by all devices
+  if (!m_euPlan)
+    {
+      //////////////
+      // SubBands //
+      //////////////
+
+      m_euPlan = Create<RegionalChannelPlan> ();
+      m_euPlan->AddSubBand (Create<SubBand> (868, 868.6, 0.01, 14));
+      m_euPlan->AddSubBand (Create<SubBand> (868.7, 869.2, 0.001, 14));
+      m_euPlan->AddSubBand (Create<SubBand> (869.4, 869.65, 0.1, 27));
+
+      //////////////////////
+      // Default channels //
+      //////////////////////
+      m_euPlan->AddChannel (CreateObject<LogicalLoraChannel> (868.1, 0, 5));
+      m_euPlan->AddChannel (CreateObject<LogicalLoraChannel> (868.3, 0, 5));
+      m_euPlan->AddChannel (CreateObject<LogicalLoraChannel> (868.5, 0, 5));
+    }
 
+  LogicalLoraChannelHelper channelHelper (m_euPlan);
   lorawanMac->SetLogicalLoraChannelHelper (channelHelper);
 
   ///////////////////////////////////////////////
@@ -434,21 +440,25 @@ LorawanMacHelper::ApplyCommonSingleChannelConfigurations (Ptr<LorawanMac> lorawa
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  //////////////
-  // SubBands //
-  //////////////
-
-  LogicalLoraChannelHelper channelHelper;
-  channelHelper.AddSubBand (868, 868.6, 0.01, 14);
-  channelHelper.AddSubBand (868.7, 869.2, 0.001, 14);
-  channelHelper.AddSubBand (869.4, 869.65, 0.1, 27);
-
-  //////////////////////
-  // Default channels //
-  //////////////////////
-  Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel> (868.1, 0, 5);
-  channelHelper.AddChannel (lc1);
+  // The channel plan is created once, and shared by all devices
+  if (!m_singleChannelPlan)
+    {
+      //////////////
+      // SubBands //
+      //////////////
+
+      m_singleChannelPlan = Create<RegionalChannelPlan> ();
+      m_singleChannelPlan->AddSubBand (Create<SubBand> (868, 868.6, 0.01, 14));
+      m_singleChannelPlan->AddSubBand (Create<SubBand> (868.7, 869.2, 0.001, 14));
+      m_singleChannelPlan->AddSubBand (Create<SubBand> (869.4, 869.65, 0.1, 27));
+
+      //////////////////////
+      // Default channels //
+      //////////////////////
+      m_singleChannelPlan->AddChannel (CreateObject<LogicalLoraChannel> (868.1, 0, 5));
+    }
 
+  LogicalLoraChannelHelper channelHelper (m_singleChannelPlan);
   lorawanMac->SetLogicalLoraChannelHelper (channelHelper);
 
   ///////////////////////////////////////////////
@@ -176,6 +176,11 @@ private:
   Ptr<LoraDeviceAddressGenerator> m_addrGen; //!< Pointer to the address generator to use
   enum DeviceType m_deviceType; //!< The kind of device to install
   enum Regions m_region; //!< The region in which the device will operate
+
+  // The channel plans shared by the configured devices, created on first use
+  mutable Ptr<RegionalChannelPlan> m_euPlan; //!< The EU channel plan
+  mutable Ptr<RegionalChannelPlan> m_singleChannelPlan; //!< The single channel plan
+  mutable Ptr<RegionalChannelPlan> m_alohaPlan; //!< The ALOHA channel plan
 };
 
 } // namespace lorawan
@@ -79,11 +79,16 @@ AdrComponent::~AdrComponent ()
 {
 }
 
-void AdrComponent::OnReceivedPacket (Ptr<const Packet> packet,
+void AdrComponent::OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                                      Ptr<EndDeviceStatus> status,
                                      Ptr<NetworkStatus> networkStatus)
 {
-  NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
+  NS_LOG_FUNCTION (this->GetTypeId () << uplink->GetPacket () << networkStatus);
+
+  // Make sure the statistics of the device cover the packets used by the
+  // algorithm
+  status->SetMinHistoryLength (historyRange);
+  status->GetRxPowerStatistics ().SetWindowLength (historyRange);
 
   // We will only act just before reply, when all Gateways will have received
   // the packet, since we need their respective received power.
@@ -95,19 +100,13 @@ AdrComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-
   //Execute the ADR algotithm only if the request bit is set
-  if (fHdr.GetAdr ())
+  if (status->GetLastReceivedUplink ()->GetAdr ())
     {
-      if (int(status->GetReceivedPacketList ().size ()) < historyRange)
+      std::size_t nPackets = status->GetRxPowerStatistics ().GetPacketCount ();
+      if (int(nPackets) < historyRange)
         {
-          NS_LOG_ERROR ("Not enough packets received by this device (" << status->GetReceivedPacketList ().size () << ") for the algorithm to work (need " << historyRange << ")");
+          NS_LOG_ERROR ("Not enough packets received by this device (" << nPackets << ") for the algorithm to work (need " << historyRange << ")");
         }
       else
         {
@@ -178,22 +177,14 @@ void AdrComponent::AdrImplementation (uint8_t *newDataRate,
                                       uint8_t *newTxPower,
                                       Ptr<EndDeviceStatus> status)
 {
-  //Compute the maximum or median SNR, based on the boolean value historyAveraging
-  double m_SNR = 0;
-  switch (historyAveraging)
-    {
-    case AdrComponent::AVERAGE:
-      m_SNR = GetAverageSNR (status->GetReceivedPacketList (),
-                             historyRange);
-      break;
-    case AdrComponent::MAXIMUM:
-      m_SNR = GetMaxSNR (status->GetReceivedPacketList (),
-                         historyRange);
-      break;
-    case AdrComponent::MINIMUM:
-      m_SNR = GetMinSNR (status->GetReceivedPacketList (),
-                         historyRange);
-    }
+  //Compute the average, maximum or minimum SNR, based on historyAveraging.
+  //The received power of each packet is combined over the gateways based on
+  //tpAveraging, and since the SNR is an increasing affine function of the
+  //power, the SNR statistics follow from the power ones.
+  double rxPower = status->GetRxPowerStatistics ().GetRxPower (
+      RxPowerStatistics::CombiningMethod (tpAveraging),
+      RxPowerStatistics::CombiningMethod (historyAveraging));
+  double m_SNR = RxPowerToSNR (rxPower);
 
   NS_LOG_DEBUG ("m_SNR = " << m_SNR);
 
@@ -287,154 +278,6 @@ double AdrComponent::RxPowerToSNR (double transmissionPower)
   return transmissionPower + 174 - 10 * log10 (B) - NF;
 }
 
-//Get the maximum received power (it considers the values in dB!)
-double AdrComponent::GetMinTxFromGateways (EndDeviceStatus::GatewayList gwList)
-{
-  EndDeviceStatus::GatewayList::iterator it = gwList.begin ();
-  double min = it->second.rxPower;
-
-  for (; it != gwList.end (); it++)
-    {
-      if (it->second.rxPower < min)
-        {
-          min = it->second.rxPower;
-        }
-    }
-
-  return min;
-}
-
-//Get the maximum received power (it considers the values in dB!)
-double AdrComponent::GetMaxTxFromGateways (EndDeviceStatus::GatewayList gwList)
-{
-  EndDeviceStatus::GatewayList::iterator it = gwList.begin ();
-  double max = it->second.rxPower;
-
-  for (; it != gwList.end (); it++)
-    {
-      if (it->second.rxPower > max)
-        {
-          max = it->second.rxPower;
-        }
-    }
-
-  return max;
-}
-
-//Get the maximum received power
-double AdrComponent::GetAverageTxFromGateways (EndDeviceStatus::GatewayList gwList)
-{
-  double sum = 0;
-
-  for (EndDeviceStatus::GatewayList::iterator it = gwList.begin (); it != gwList.end (); it++)
-    {
-      NS_LOG_DEBUG ("Gateway at " << it->first << " has TP " << it->second.rxPower);
-      sum += it->second.rxPower;
-    }
-
-  double average = sum / gwList.size ();
-
-  NS_LOG_DEBUG ("TP (average) = " << average);
-
-  return average;
-}
-
-double
-AdrComponent::GetReceivedPower (EndDeviceStatus::GatewayList gwList)
-{
-  switch (tpAveraging)
-    {
-    case AdrComponent::AVERAGE:
-      return GetAverageTxFromGateways (gwList);
-    case AdrComponent::MAXIMUM:
-      return GetMaxTxFromGateways (gwList);
-    case AdrComponent::MINIMUM:
-      return GetMinTxFromGateways (gwList);
-    default:
-      return -1;
-    }
-}
-
-// TODO Make this more elegant
-double AdrComponent::GetMinSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                                int historyRange)
-{
-  double m_SNR;
-
-  //Take elements from the list starting at the end
-  auto it = packetList.rbegin ();
-  double min = RxPowerToSNR (GetReceivedPower (it->second.gwList));
-
-  for (int i = 0; i < historyRange; i++, it++)
-    {
-      m_SNR = RxPowerToSNR (GetReceivedPower (it->second.gwList));
-
-      NS_LOG_DEBUG ("Received power: " << GetReceivedPower (it->second.gwList));
-      NS_LOG_DEBUG ("m_SNR = " << m_SNR);
-
-      if (m_SNR < min)
-        {
-          min = m_SNR;
-        }
-    }
-
-  NS_LOG_DEBUG ("SNR (min) = " << min);
-
-  return min;
-}
-
-double AdrComponent::GetMaxSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                                int historyRange)
-{
-  double m_SNR;
-
-  //Take elements from the list starting at the end
-  auto it = packetList.rbegin ();
-  double max = RxPowerToSNR (GetReceivedPower (it->second.gwList));
-
-  for (int i = 0; i < historyRange; i++, it++)
-    {
-      m_SNR = RxPowerToSNR (GetReceivedPower (it->second.gwList));
-
-      NS_LOG_DEBUG ("Received power: " << GetReceivedPower (it->second.gwList));
-      NS_LOG_DEBUG ("m_SNR = " << m_SNR);
-
-      if (m_SNR > max)
-        {
-          max = m_SNR;
-        }
-    }
-
-  NS_LOG_DEBUG ("SNR (max) = " << max);
-
-  return max;
-}
-
-double AdrComponent::GetAverageSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                                    int historyRange)
-{
-  double sum = 0;
-  double m_SNR;
-
-  //Take elements from the list starting at the end
-  auto it = packetList.rbegin ();
-  for (int i = 0; i < historyRange; i++, it++)
-    {
-      m_SNR = RxPowerToSNR (GetReceivedPower (it->second.gwList));
-
-      NS_LOG_DEBUG ("Received power: " << GetReceivedPower (it->second.gwList));
-      NS_LOG_DEBUG ("m_SNR = " << m_SNR);
-
-      sum += m_SNR;
-    }
-
-  double average = sum / historyRange;
-
-  NS_LOG_DEBUG ("SNR (average) = " << average);
-
-  return average;
-}
-
 int AdrComponent::GetTxPowerIndex (int txPower)
 {
   if (txPower >= 16)
@@ -36,11 +36,12 @@ namespace lorawan {
 
 class AdrComponent : public NetworkControllerComponent
 {
+  // The values match the ones of RxPowerStatistics
   enum CombiningMethod
   {
-    AVERAGE,
-    MAXIMUM,
-    MINIMUM,
+    AVERAGE = RxPowerStatistics::AVERAGE,
+    MAXIMUM = RxPowerStatistics::MAXIMUM,
+    MINIMUM = RxPowerStatistics::MINIMUM,
   };
 
 public:
@@ -51,7 +52,7 @@ public:
   //Destructor
   virtual ~AdrComponent ();
 
-  void OnReceivedPacket (Ptr<const Packet> packet,
+  void OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                          Ptr<EndDeviceStatus> status,
                          Ptr<NetworkStatus> networkStatus);
 
@@ -69,23 +70,6 @@ private:
 
   double RxPowerToSNR (double transmissionPower);
 
-  double GetMinTxFromGateways (EndDeviceStatus::GatewayList gwList);
-
-  double GetMaxTxFromGateways (EndDeviceStatus::GatewayList gwList);
-
-  double GetAverageTxFromGateways (EndDeviceStatus::GatewayList gwList);
-
-  double GetReceivedPower (EndDeviceStatus::GatewayList gwList);
-
-  double GetMinSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                    int historyRange);
-
-  double GetMaxSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                    int historyRange);
-
-  double GetAverageSNR (EndDeviceStatus::ReceivedPacketList packetList,
-                        int historyRange);
-
   int GetTxPowerIndex (int txPower);
 
   //TX power from gateways policy
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DEVICE_ADDRESS_TABLE_H
+#define DEVICE_ADDRESS_TABLE_H
+
+#include "ns3/lora-device-address.h"
+#include "ns3/uid-hash-map.h"
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A map from device addresses to values, optimized for addresses that are
+ * handed out sequentially in each network (like the ones of
+ * LoraDeviceAddressGenerator).
+ *
+ * Each NwkID has an array indexed directly by NwkAddr, which holds the
+ * values of the devices whose NwkAddr is low enough for the array to stay
+ * dense. The values of other devices are kept in a UidHashMap. Both cases
+ * need no pointer chasing, and lookups take constant time.
+ */
+template <typename T>
+class DeviceAddressTable
+{
+public:
+  DeviceAddressTable () : m_size (0)
+  {
+  }
+
+  /**
+   * Find the value associated to an address.
+   *
+   * \param address The address to look for.
+   * \return A pointer to the value, or 0 if the address is not in the table.
+   * The pointer is invalidated by the next insertion.
+   */
+  T *
+  Find (LoraDeviceAddress address)
+  {
+    uint32_t key = address.Get ();
+    uint32_t nwkId = key >> NWK_ADDR_BITS;
+    uint32_t nwkAddr = key & NWK_ADDR_MASK;
+    if (nwkId < m_dense.size () && nwkAddr < m_dense[nwkId].slots.size ())
+      {
+        Slot &slot = m_dense[nwkId].slots[nwkAddr];
+        if (slot.used)
+          {
+            return &slot.value;
+          }
+      }
+    return m_sparse.Find (key);
+  }
+
+  /**
+   * Insert a value in the table, if its address is not already present.
+   *
+   * \param address The address of the value.
+   * \param value The value to insert.
+   * \return True if the value was inserted, false if the address was already
+   * present (in which case the table is left untouched).
+   */
+  bool
+  Insert (LoraDeviceAddress address, const T &value)
+  {
+    if (Find (address) != 0)
+      {
+        return false;
+      }
+
+    uint32_t key = address.Get ();
+    uint32_t nwkId = key >> NWK_ADDR_BITS;
+    uint32_t nwkAddr = key & NWK_ADDR_MASK;
+    if (m_dense.empty ())
+      {
+        m_dense.resize (std::size_t (1) << NWK_ID_BITS);
+      }
+
+    // Only grow the array of the network if at least half of it would be
+    // used, apart from a first chunk of addresses that is always allowed
+    DenseTable &table = m_dense[nwkId];
+    if (nwkAddr >= table.slots.size ())
+      {
+        if (nwkAddr >= 2 * table.count + MIN_DENSE_SIZE)
+          {
+            m_size++;
+            return m_sparse.Insert (key, value);
+          }
+        std::size_t size = table.slots.size () * 2;
+        table.slots.resize (size > nwkAddr ? size : nwkAddr + 1);
+      }
+    table.slots[nwkAddr].value = value;
+    table.slots[nwkAddr].used = true;
+    table.count++;
+    m_size++;
+    return true;
+  }
+
+  /**
+   * \return The number of entries in the table.
+   */
+  std::size_t
+  GetSize (void) const
+  {
+    return m_size;
+  }
+
+private:
+  static const uint32_t NWK_ID_BITS = 7;  //!< The bits of the NwkID
+  static const uint32_t NWK_ADDR_BITS = 25;  //!< The bits of the NwkAddr
+  static const uint32_t NWK_ADDR_MASK = (1u << 25) - 1; //!< The NwkAddr bits
+  static const uint32_t MIN_DENSE_SIZE = 1 << 16; //!< Always dense addresses
+
+  /**
+   * An entry of a dense array.
+   */
+  struct Slot
+  {
+    Slot () : value (), used (false)
+    {
+    }
+
+    T value;
+    bool used;
+  };
+
+  /**
+   * The dense array of a network.
+   */
+  struct DenseTable
+  {
+    DenseTable () : count (0)
+    {
+    }
+
+    std::vector<Slot> slots; //!< The entries, indexed by NwkAddr
+    std::size_t count; //!< The number of used entries
+  };
+
+  std::vector<DenseTable> m_dense; //!< The dense arrays, indexed by NwkID
+  UidHashMap<T> m_sparse; //!< The other entries, indexed by address
+  std::size_t m_size; //!< The number of entries
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* DEVICE_ADDRESS_TABLE_H */
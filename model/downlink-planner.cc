@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/downlink-planner.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("DownlinkPlanner");
+
+NS_OBJECT_ENSURE_REGISTERED (DownlinkPlanner);
+
+const uint32_t DownlinkPlanner::NO_GATEWAY;
+
+TypeId
+DownlinkPlanner::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DownlinkPlanner")
+    .SetParent<Object> ()
+    .SetGroupName ("lorawan");
+  return tid;
+}
+
+DownlinkPlanner::DownlinkPlanner ()
+{
+}
+
+DownlinkPlanner::~DownlinkPlanner ()
+{
+}
+
+///////////////////////////
+// GreedyDownlinkPlanner //
+///////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (GreedyDownlinkPlanner);
+
+TypeId
+GreedyDownlinkPlanner::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GreedyDownlinkPlanner")
+    .SetParent<DownlinkPlanner> ()
+    .AddConstructor<GreedyDownlinkPlanner> ()
+    .SetGroupName ("lorawan");
+  return tid;
+}
+
+GreedyDownlinkPlanner::GreedyDownlinkPlanner ()
+{
+}
+
+GreedyDownlinkPlanner::~GreedyDownlinkPlanner ()
+{
+}
+
+void
+GreedyDownlinkPlanner::Plan (std::vector<Request> &requests, uint32_t nGateways)
+{
+  NS_LOG_FUNCTION (this << requests.size () << nGateways);
+
+  m_taken.assign (nGateways, false);
+  for (auto &request : requests)
+    {
+      request.gateway = NO_GATEWAY;
+      for (uint32_t gateway : request.gateways)
+        {
+          NS_ASSERT (gateway < nGateways);
+          if (!m_taken[gateway])
+            {
+              m_taken[gateway] = true;
+              request.gateway = gateway;
+              break;
+            }
+        }
+    }
+}
+
+/////////////////////////////
+// MatchingDownlinkPlanner //
+/////////////////////////////
+
+NS_OBJECT_ENSURE_REGISTERED (MatchingDownlinkPlanner);
+
+TypeId
+MatchingDownlinkPlanner::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MatchingDownlinkPlanner")
+    .SetParent<DownlinkPlanner> ()
+    .AddConstructor<MatchingDownlinkPlanner> ()
+    .SetGroupName ("lorawan");
+  return tid;
+}
+
+MatchingDownlinkPlanner::MatchingDownlinkPlanner () :
+  m_search (0)
+{
+}
+
+MatchingDownlinkPlanner::~MatchingDownlinkPlanner ()
+{
+}
+
+void
+MatchingDownlinkPlanner::Plan (std::vector<Request> &requests, uint32_t nGateways)
+{
+  NS_LOG_FUNCTION (this << requests.size () << nGateways);
+
+  const std::size_t noRequest = requests.size ();
+  m_owner.assign (nGateways, noRequest);
+  m_visited.assign (nGateways, 0);
+  m_search = 0;
+
+  // Start from the greedy assignment, which is already complete if requests
+  // don't compete for gateways
+  bool complete = true;
+  for (std::size_t i = 0; i < requests.size (); i++)
+    {
+      requests[i].gateway = NO_GATEWAY;
+      for (uint32_t gateway : requests[i].gateways)
+        {
+          NS_ASSERT (gateway < nGateways);
+          if (m_owner[gateway] == noRequest)
+            {
+              m_owner[gateway] = i;
+              requests[i].gateway = gateway;
+              break;
+            }
+        }
+      complete &= requests[i].gateway != NO_GATEWAY;
+    }
+  if (complete)
+    {
+      return;
+    }
+
+  // A request for which no augmenting path exists cannot get a gateway later
+  // either, so a single pass is enough to reach a maximum matching
+  for (std::size_t i = 0; i < requests.size (); i++)
+    {
+      if (requests[i].gateway == NO_GATEWAY)
+        {
+          m_search++;
+          Augment (requests, i);
+        }
+    }
+}
+
+bool
+MatchingDownlinkPlanner::Augment (std::vector<Request> &requests, std::size_t request)
+{
+  const std::size_t noRequest = requests.size ();
+  for (uint32_t gateway : requests[request].gateways)
+    {
+      if (m_visited[gateway] == m_search)
+        {
+          continue;
+        }
+      m_visited[gateway] = m_search;
+
+      // Take the gateway if it is free, or if its owner can move to another
+      if (m_owner[gateway] == noRequest || Augment (requests, m_owner[gateway]))
+        {
+          m_owner[gateway] = request;
+          requests[request].gateway = gateway;
+          return true;
+        }
+    }
+  return false;
+}
+
+} // namespace lorawan
+} // namespace ns3
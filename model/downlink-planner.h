@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DOWNLINK_PLANNER_H
+#define DOWNLINK_PLANNER_H
+
+#include "ns3/object.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+////////////////
+// Base class //
+////////////////
+
+/**
+ * Generic class describing a strategy to assign gateways to the replies that
+ * the NetworkScheduler needs to send in the same receive window interval.
+ *
+ * A gateway can only send one packet at a time, so the replies of a batch
+ * compete for the gateways that can reach their devices. Planners decide
+ * which replies are sent, and through which gateway.
+ */
+class DownlinkPlanner : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  DownlinkPlanner ();
+  virtual ~DownlinkPlanner ();
+
+  /**
+   * The gateway of a request that could not be given one.
+   */
+  static const uint32_t NO_GATEWAY = 0xffffffff;
+
+  /**
+   * A reply that needs to be sent.
+   */
+  struct Request
+  {
+    std::vector<uint32_t> gateways; //!< The gateways that can send it, best first
+    uint32_t gateway;               //!< The assigned gateway, or NO_GATEWAY
+  };
+
+  /**
+   * Assign gateways to a batch of requests, so that no gateway is used by
+   * more than one request.
+   *
+   * \param requests The requests, whose gateway field is set by the planner.
+   * \param nGateways The number of gateways of the network. Gateway indices
+   * are smaller than this.
+   */
+  virtual void Plan (std::vector<Request> &requests, uint32_t nGateways) = 0;
+};
+
+////////////
+// Greedy //
+////////////
+
+/**
+ * Give each request, in order, the best of its gateways that was not taken
+ * by the previous ones.
+ */
+class GreedyDownlinkPlanner : public DownlinkPlanner
+{
+public:
+  static TypeId GetTypeId (void);
+
+  GreedyDownlinkPlanner ();
+  virtual ~GreedyDownlinkPlanner ();
+
+  virtual void Plan (std::vector<Request> &requests, uint32_t nGateways);
+
+private:
+  std::vector<bool> m_taken; //!< Whether each gateway was assigned
+};
+
+//////////////
+// Matching //
+//////////////
+
+/**
+ * Assign gateways so that the number of requests that get one is maximum.
+ *
+ * Requests first get their best free gateway, as in GreedyDownlinkPlanner.
+ * Then, for each request left without one, augmenting paths are searched
+ * for: the requests holding the gateways it needs are moved to their next
+ * best gateways, if this frees one. Requests that do not compete for
+ * gateways keep their best one.
+ */
+class MatchingDownlinkPlanner : public DownlinkPlanner
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MatchingDownlinkPlanner ();
+  virtual ~MatchingDownlinkPlanner ();
+
+  virtual void Plan (std::vector<Request> &requests, uint32_t nGateways);
+
+private:
+  /**
+   * Look for an augmenting path starting from a request.
+   *
+   * \return True if the request was given a gateway.
+   */
+  bool Augment (std::vector<Request> &requests, std::size_t request);
+
+  std::vector<std::size_t> m_owner;  //!< The request assigned to each gateway
+  std::vector<uint32_t> m_visited;   //!< The last search that reached each gateway
+  uint32_t m_search;                 //!< The index of the current search
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* DOWNLINK_PLANNER_H */
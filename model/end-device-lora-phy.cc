@@ -119,7 +119,10 @@ EndDeviceLoraPhy::SwitchToStandby (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  bool wasTrackingInterference = IsTrackingInterference ();
+
   m_state = STANDBY;
+  UpdateInterferenceTracking (wasTrackingInterference);
 
   // Notify listeners of the state change
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -151,7 +154,10 @@ EndDeviceLoraPhy::SwitchToTx (double txPowerDbm)
 
   NS_ASSERT (m_state != RX);
 
+  bool wasTrackingInterference = IsTrackingInterference ();
+
   m_state = TX;
+  UpdateInterferenceTracking (wasTrackingInterference);
 
   // Notify listeners of the state change
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
@@ -160,6 +166,41 @@ EndDeviceLoraPhy::SwitchToTx (double txPowerDbm)
     }
 }
 
+bool
+EndDeviceLoraPhy::IsTrackingInterference (void) const
+{
+  return (m_state != SLEEP && m_state != TX) || m_channel == 0 ||
+         !m_channel->IsInterferenceShared ();
+}
+
+void
+EndDeviceLoraPhy::UpdateInterferenceTracking (bool wasTrackingInterference)
+{
+  bool trackingInterference = IsTrackingInterference ();
+  if (wasTrackingInterference && !trackingInterference)
+    {
+      m_trackingStopped = Simulator::Now ();
+    }
+  else if (!wasTrackingInterference && trackingInterference)
+    {
+      // Take the interference we did not keep track of from the channel
+      for (auto &transmission : m_channel->GetImpingingTransmissions (this, m_trackingStopped))
+        {
+          NS_LOG_DEBUG ("Adding transmission that started arriving at "
+                        << transmission.startTime.GetSeconds () << " s to the interference");
+          m_interference.Add (transmission.startTime, transmission.parameters.duration,
+                              transmission.parameters.rxPowerDbm, transmission.parameters.sf,
+                              transmission.packet, transmission.parameters.frequencyMHz);
+        }
+    }
+
+  // Tell the channel whether to notify us of transmissions
+  if (m_channel != 0 && m_channel->IsInterferenceShared ())
+    {
+      m_channel->SetListening (this, trackingInterference);
+    }
+}
+
 void
 EndDeviceLoraPhy::SwitchToSleep (void)
 {
@@ -167,7 +208,10 @@ EndDeviceLoraPhy::SwitchToSleep (void)
 
   NS_ASSERT (m_state == STANDBY);
 
+  bool wasTrackingInterference = IsTrackingInterference ();
+
   m_state = SLEEP;
+  UpdateInterferenceTracking (wasTrackingInterference);
 
   // Notify listeners of the state change
   for (Listeners::const_iterator i = m_listeners.begin (); i != m_listeners.end (); i++)
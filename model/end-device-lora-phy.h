@@ -238,6 +238,30 @@ protected:
    */
   void SwitchToTx (double txPowerDbm);
 
+  /**
+   * Whether this PHY needs to keep track of the interference of incoming
+   * transmissions in its own LoraInterferenceHelper. This is not the case in
+   * SLEEP and TX states when the channel keeps a shared log of transmissions,
+   * since the ones that are still arriving are added to the helper when the
+   * PHY switches to STANDBY.
+   *
+   * \return True if incoming transmissions need to be added to the helper.
+   */
+  bool IsTrackingInterference (void) const;
+
+  /**
+   * Handle a state change with respect to interference: remember when the
+   * PHY stops keeping track of it, take the interference it missed from the
+   * channel when it starts again, and tell the channel whether the PHY needs
+   * to be notified of transmissions.
+   *
+   * \param wasTrackingInterference Whether the PHY was keeping track of
+   * interference before the state change.
+   */
+  void UpdateInterferenceTracking (bool wasTrackingInterference);
+
+  Time m_trackingStopped; //!< When the PHY last stopped keeping track of interference
+
   /**
    * Trace source for when a packet is lost because it was using a SF different from
    * the one this EndDeviceLoraPhy was configured to listen for.
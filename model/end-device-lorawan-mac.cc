@@ -530,27 +530,11 @@ EndDeviceLorawanMac::GetNextTransmissionDelay (void)
 
   //    Check duty cycle    //
 
-  // Pick a random channel to transmit on
-  std::vector<Ptr<LogicalLoraChannel> > logicalChannels;
-  logicalChannels = m_channelHelper.GetEnabledChannelList ();                 // Use a separate list to do the shuffle
-  //logicalChannels = Shuffle (logicalChannels);
+  // Find the minimum waiting time over the enabled channels
+  Time waitingTime = m_channelHelper.GetMinimumWaitingTime ();
 
-
-  Time waitingTime = Time::Max ();
-
-  // Try every channel
-  std::vector<Ptr<LogicalLoraChannel> >::iterator it;
-  for (it = logicalChannels.begin (); it != logicalChannels.end (); ++it)
-    {
-      // Pointer to the current channel
-      Ptr<LogicalLoraChannel> logicalChannel = *it;
-      double frequency = logicalChannel->GetFrequency ();
-
-      waitingTime = std::min (waitingTime, m_channelHelper.GetWaitingTime (logicalChannel));
-
-      NS_LOG_DEBUG ("Waiting time before the next transmission in channel with frequecy " <<
-                    frequency << " is = " << waitingTime.GetSeconds () << ".");
-    }
+  NS_LOG_DEBUG ("Waiting time before the next transmission is = " <<
+                waitingTime.GetSeconds () << ".");
 
   waitingTime = GetNextClassTransmissionDelay (waitingTime);
 
@@ -562,23 +546,26 @@ EndDeviceLorawanMac::GetChannelForTx (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  // Pick a random channel to transmit on
-  std::vector<Ptr<LogicalLoraChannel> > logicalChannels;
-  logicalChannels = m_channelHelper.GetEnabledChannelList ();                 // Use a separate list to do the shuffle
-  logicalChannels = Shuffle (logicalChannels);
+  // Pick a random channel to transmit on, shuffling the indices of the
+  // enabled channels in a buffer that is reused across transmissions
+  const std::vector<Ptr<LogicalLoraChannel> > &channels = m_channelHelper.GetChannels ();
+  m_channelOrder.clear ();
+  for (uint32_t i = 0; i < channels.size (); i++)
+    {
+      if (m_channelHelper.IsChannelEnabled (i))
+        {
+          m_channelOrder.push_back (i);
+        }
+    }
+  Shuffle (m_channelOrder);
 
   // Try every channel
-  std::vector<Ptr<LogicalLoraChannel> >::iterator it;
-  for (it = logicalChannels.begin (); it != logicalChannels.end (); ++it)
+  for (uint32_t chIndex : m_channelOrder)
     {
-      // Pointer to the current channel
-      Ptr<LogicalLoraChannel> logicalChannel = *it;
-      double frequency = logicalChannel->GetFrequency ();
-
-      NS_LOG_DEBUG ("Frequency of the current channel: " << frequency);
+      NS_LOG_DEBUG ("Frequency of the current channel: " << channels[chIndex]->GetFrequency ());
 
       // Verify that we can send the packet
-      Time waitingTime = m_channelHelper.GetWaitingTime (logicalChannel);
+      Time waitingTime = m_channelHelper.GetWaitingTime (chIndex);
 
       NS_LOG_DEBUG ("Waiting time for current channel = " <<
                     waitingTime.GetSeconds ());
@@ -586,7 +573,7 @@ EndDeviceLorawanMac::GetChannelForTx (void)
       // Send immediately if we can
       if (waitingTime == Seconds (0))
         {
-          return *it;
+          return channels[chIndex];
         }
       else
         {
@@ -598,8 +585,8 @@ EndDeviceLorawanMac::GetChannelForTx (void)
 }
 
 
-std::vector<Ptr<LogicalLoraChannel> >
-EndDeviceLorawanMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
+void
+EndDeviceLorawanMac::Shuffle (std::vector<uint32_t> &vector)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -608,12 +595,8 @@ EndDeviceLorawanMac::Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector)
   for (int i = 0; i < size; ++i)
     {
       uint16_t random = std::floor (m_uniformRV->GetValue (0, size));
-      Ptr<LogicalLoraChannel> temp = vector.at (random);
-      vector.at (random) = vector.at (i);
-      vector.at (i) = temp;
+      std::swap (vector.at (random), vector.at (i));
     }
-
-  return vector;
 }
 
 /////////////////////////
@@ -716,7 +699,7 @@ EndDeviceLorawanMac::OnLinkAdrReq (uint8_t dataRate, uint8_t txPower,
   // Check the channel mask
   /////////////////////////
   // Check whether all specified channels exist on this device
-  auto channelList = m_channelHelper.GetChannelList ();
+  const std::vector<Ptr<LogicalLoraChannel> > &channelList = m_channelHelper.GetChannels ();
   int channelListSize = channelList.size ();
 
   for (auto it = enabledChannels.begin (); it != enabledChannels.end (); it++)
@@ -787,16 +770,16 @@ EndDeviceLorawanMac::OnLinkAdrReq (uint8_t dataRate, uint8_t txPower,
   if (channelMaskOk && dataRateOk && txPowerOk)
     {
       // Cycle over all channels in the list
-      for (uint32_t i = 0; i < m_channelHelper.GetChannelList ().size (); i++)
+      for (uint32_t i = 0; i < m_channelHelper.GetChannels ().size (); i++)
         {
           if (std::find (enabledChannels.begin (), enabledChannels.end (), i) != enabledChannels.end ())
             {
-              m_channelHelper.GetChannelList ().at (i)->SetEnabledForUplink ();
+              m_channelHelper.EnableChannel (i);
               NS_LOG_DEBUG ("Channel " << i << " enabled");
             }
           else
             {
-              m_channelHelper.GetChannelList ().at (i)->DisableForUplink ();
+              m_channelHelper.DisableChannel (i);
               NS_LOG_DEBUG ("Channel " << i << " disabled");
             }
         }
@@ -420,6 +420,13 @@ protected:
    */
   Ptr<UniformRandomVariable> m_uniformRV;
 
+  /**
+   * The indices of the enabled channels, in the order they are tried by
+   * GetChannelForTx. Kept as a member to avoid allocations at each
+   * transmission.
+   */
+  std::vector<uint32_t> m_channelOrder;
+
   /////////////////
   //  Callbacks  //
   /////////////////
@@ -433,11 +440,11 @@ protected:
 
 private:
   /**
-   * Randomly shuffle a Ptr<LogicalLoraChannel> vector.
+   * Randomly shuffle a vector of channel indices in place.
    *
    * Used to pick a random channel on which to send the packet.
    */
-  std::vector<Ptr<LogicalLoraChannel> > Shuffle (std::vector<Ptr<LogicalLoraChannel> > vector);
+  void Shuffle (std::vector<uint32_t> &vector);
 
   /**
    * Find the minimum waiting time before the next possible transmission.
@@ -29,6 +29,7 @@
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
 #include "ns3/lora-tag.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
 
@@ -43,7 +44,14 @@ EndDeviceStatus::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::EndDeviceStatus")
                           .SetParent<Object> ()
                           .AddConstructor<EndDeviceStatus> ()
-                          .SetGroupName ("lorawan");
+                          .SetGroupName ("lorawan")
+                          .AddAttribute ("HistoryLength",
+                                         "The number of received packets to keep "
+                                         "for each device (components like ADR may "
+                                         "require more)",
+                                         UintegerValue (4),
+                                         MakeUintegerAccessor (&EndDeviceStatus::m_historyLength),
+                                         MakeUintegerChecker<uint32_t> (1));
   return tid;
 }
 
@@ -51,7 +59,6 @@ EndDeviceStatus::EndDeviceStatus (LoraDeviceAddress endDeviceAddress,
                                   Ptr<ClassAEndDeviceLorawanMac> endDeviceMac)
     : m_reply (EndDeviceStatus::Reply ()),
       m_endDeviceAddress (endDeviceAddress),
-      m_receivedPacketList (ReceivedPacketList ()),
       m_mac (endDeviceMac)
 {
   NS_LOG_FUNCTION (endDeviceAddress);
@@ -63,7 +70,6 @@ EndDeviceStatus::EndDeviceStatus ()
 
   // Initialize data structure
   m_reply = EndDeviceStatus::Reply ();
-  m_receivedPacketList = ReceivedPacketList ();
 }
 
 EndDeviceStatus::~EndDeviceStatus ()
@@ -126,13 +132,7 @@ EndDeviceStatus::GetCompleteReplyPacket (void)
 
   // Add headers
   m_reply.frameHeader.SetAddress (m_endDeviceAddress);
-  Ptr<Packet> lastPacket = GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  lastPacket->RemoveHeader (mHdr);
-  lastPacket->RemoveHeader (fHdr);
-  m_reply.frameHeader.SetFCnt (fHdr.GetFCnt ());
+  m_reply.frameHeader.SetFCnt (GetLastReceivedUplink ()->GetFCnt ());
   m_reply.macHeader.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
   replyPacket->AddHeader (m_reply.frameHeader);
   replyPacket->AddHeader (m_reply.macHeader);
@@ -182,7 +182,59 @@ EndDeviceStatus::ReceivedPacketList
 EndDeviceStatus::GetReceivedPacketList ()
 {
   NS_LOG_FUNCTION_NOARGS ();
-  return m_receivedPacketList;
+
+  ReceivedPacketList packetList;
+  for (std::size_t age = 0; age < m_historyCount; age++)
+    {
+      const ReceivedPacketInfo &info = GetReceivedPacketInfo (age);
+      packetList.push_front (std::pair<Ptr<Packet const>, ReceivedPacketInfo> (info.packet, info));
+    }
+  return packetList;
+}
+
+std::size_t
+EndDeviceStatus::GetReceivedPacketCount (void) const
+{
+  return m_historyCount;
+}
+
+const EndDeviceStatus::ReceivedPacketInfo &
+EndDeviceStatus::GetReceivedPacketInfo (std::size_t age) const
+{
+  NS_ASSERT (age < m_historyCount);
+
+  return m_history[(m_historyHead + m_history.size () - age) % m_history.size ()];
+}
+
+void
+EndDeviceStatus::SetMinHistoryLength (std::size_t length)
+{
+  NS_LOG_FUNCTION (length);
+
+  if (length <= m_history.size ())
+    {
+      return;
+    }
+
+  // Move the packets to a larger buffer, from the oldest one in slot 0 to the
+  // most recent one
+  std::vector<ReceivedPacketInfo> history (length);
+  UidHashMap<std::size_t> fCntIndex;
+  for (std::size_t age = 0; age < m_historyCount; age++)
+    {
+      std::size_t slot = m_historyCount - 1 - age;
+      history[slot] = GetReceivedPacketInfo (age);
+      fCntIndex.Insert (history[slot].uplink->GetFCnt (), slot);
+    }
+  m_history.swap (history);
+  m_fCntIndex = fCntIndex;
+  m_historyHead = m_historyCount > 0 ? m_historyCount - 1 : length - 1;
+}
+
+RxPowerStatistics &
+EndDeviceStatus::GetRxPowerStatistics (void)
+{
+  return m_rxPowerStatistics;
 }
 
 void
@@ -239,84 +291,70 @@ EndDeviceStatus::SetReplyPayload (Ptr<Packet> replyPayload)
 ///////////////////////
 
 void
-EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket, const Address &gwAddress)
+EndDeviceStatus::InsertReceivedPacket (Ptr<const ParsedUplink> uplink, const Address &gwAddress,
+                                       uint32_t gwIndex)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = receivedPacket->Copy ();
-
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
-
   // Update current parameters
-  LoraTag tag;
-  myPacket->RemovePacketTag (tag);
-  SetFirstReceiveWindowSpreadingFactor (tag.GetSpreadingFactor ());
-  SetFirstReceiveWindowFrequency (tag.GetFrequency ());
-
-  // Update Information on the received packet
-  ReceivedPacketInfo info;
-  info.sf = tag.GetSpreadingFactor ();
-  info.frequency = tag.GetFrequency ();
-  info.packet = receivedPacket;
-
-  double rcvPower = tag.GetReceivePower ();
-
-  // Perform insertion in list, also checking that the packet isn't already in
-  // the list (it could have been received by another GW already)
-
-  // Start searching from the end
-  auto it = m_receivedPacketList.rbegin ();
-  for (; it != m_receivedPacketList.rend (); it++)
+  SetFirstReceiveWindowSpreadingFactor (uplink->GetSpreadingFactor ());
+  SetFirstReceiveWindowFrequency (uplink->GetFrequency ());
+
+  PacketInfoPerGw gwInfo;
+  gwInfo.receivedTime = Simulator::Now ();
+  gwInfo.rxPower = uplink->GetReceivePower ();
+  gwInfo.gwAddress = gwAddress;
+
+  // Check whether the packet is already in the history (it could have been
+  // received by another GW already)
+  std::size_t *slot = m_fCntIndex.Find (uplink->GetFCnt ());
+  if (slot != 0)
     {
-      // Get the frame counter of the current packet to compare it with the
-      // newly received one
-      Ptr<Packet> packetCopy = ((*it).first)->Copy ();
-      LorawanMacHeader currentMacHdr;
-      packetCopy->RemoveHeader (currentMacHdr);
-      LoraFrameHeader currentFrameHdr;
-      frameHdr.SetAsUplink ();
-      packetCopy->RemoveHeader (currentFrameHdr);
-
-      NS_LOG_DEBUG ("Received packet's frame counter: " << unsigned(frameHdr.GetFCnt ())
-                                                        << "\nCurrent packet's frame counter: "
-                                                        << unsigned(currentFrameHdr.GetFCnt ()));
-
-      if (frameHdr.GetFCnt () == currentFrameHdr.GetFCnt ())
-        {
-          NS_LOG_INFO ("Packet was already received by another gateway");
-
-          // This packet had already been received from another gateway:
-          // add this gateway's reception information.
-          GatewayList &gwList = it->second.gwList;
+      NS_LOG_INFO ("Packet was already received by another gateway");
 
-          PacketInfoPerGw gwInfo;
-          gwInfo.receivedTime = Simulator::Now ();
-          gwInfo.rxPower = rcvPower;
-          gwInfo.gwAddress = gwAddress;
-          gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo));
+      // Add this gateway's reception information
+      GatewayList &gwList = m_history[*slot].gwList;
+      bool inserted = gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo)).second;
 
-          NS_LOG_DEBUG ("Size of gateway list: " << gwList.size ());
+      NS_LOG_DEBUG ("Size of gateway list: " << gwList.size ());
 
-          break; // Exit from the cycle
+      // Late copies of older packets don't change the statistics and the
+      // gateway ranking anymore, and neither do copies a gateway forwards
+      // again
+      if (inserted && *slot == m_historyHead)
+        {
+          m_rxPowerStatistics.AddReception (gwInfo.rxPower);
+          RankGateway (gwIndex, gwInfo.rxPower);
         }
     }
-  if (it == m_receivedPacketList.rend ())
+  else
     {
       NS_LOG_INFO ("Packet was received for the first time");
-      PacketInfoPerGw gwInfo;
-      gwInfo.receivedTime = Simulator::Now ();
-      gwInfo.rxPower = rcvPower;
-      gwInfo.gwAddress = gwAddress;
+
+      SetMinHistoryLength (m_historyLength);
+
+      // Overwrite the oldest packet if the buffer is full
+      m_historyHead = (m_historyHead + 1) % m_history.size ();
+      ReceivedPacketInfo &info = m_history[m_historyHead];
+      if (m_historyCount == m_history.size ())
+        {
+          m_fCntIndex.Erase (info.uplink->GetFCnt ());
+        }
+      else
+        {
+          m_historyCount++;
+        }
+
+      info = ReceivedPacketInfo ();
+      info.sf = uplink->GetSpreadingFactor ();
+      info.frequency = uplink->GetFrequency ();
+      info.packet = uplink->GetPacket ();
+      info.uplink = uplink;
       info.gwList.insert (std::pair<Address, PacketInfoPerGw> (gwAddress, gwInfo));
-      m_receivedPacketList.push_back (
-          std::pair<Ptr<Packet const>, ReceivedPacketInfo> (receivedPacket, info));
+      m_fCntIndex.Insert (uplink->GetFCnt (), m_historyHead);
+      m_rxPowerStatistics.AddPacket (gwInfo.rxPower);
+      m_nBestGateways = 0;
+      RankGateway (gwIndex, gwInfo.rxPower);
     }
   NS_LOG_DEBUG (*this);
 }
@@ -325,10 +363,9 @@ EndDeviceStatus::ReceivedPacketInfo
 EndDeviceStatus::GetLastReceivedPacketInfo (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  auto it = m_receivedPacketList.rbegin ();
-  if (it != m_receivedPacketList.rend ())
+  if (m_historyCount > 0)
     {
-      return it->second;
+      return GetReceivedPacketInfo (0);
     }
   else
     {
@@ -340,10 +377,23 @@ Ptr<Packet const>
 EndDeviceStatus::GetLastPacketReceivedFromDevice (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  auto it = m_receivedPacketList.rbegin ();
-  if (it != m_receivedPacketList.rend ())
+  if (m_historyCount > 0)
     {
-      return it->first;
+      return GetReceivedPacketInfo (0).packet;
+    }
+  else
+    {
+      return 0;
+    }
+}
+
+Ptr<const ParsedUplink>
+EndDeviceStatus::GetLastReceivedUplink (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_historyCount > 0)
+    {
+      return GetReceivedPacketInfo (0).uplink;
     }
   else
     {
@@ -368,7 +418,7 @@ EndDeviceStatus::AddMACCommand (Ptr<MacCommand> macCommand)
 bool
 EndDeviceStatus::HasReceiveWindowOpportunityScheduled ()
 {
-  return m_receiveWindowEvent.IsRunning();
+  return m_receiveWindowEvent.IsRunning() || m_receiveWindowPending;
 }
 
 void
@@ -377,10 +427,23 @@ EndDeviceStatus::SetReceiveWindowOpportunity (EventId event)
   m_receiveWindowEvent = event;
 }
 
+void
+EndDeviceStatus::SetReceiveWindowOpportunityPending (bool pending)
+{
+  m_receiveWindowPending = pending;
+}
+
+bool
+EndDeviceStatus::IsReceiveWindowOpportunityPending (void) const
+{
+  return m_receiveWindowPending;
+}
+
 void
 EndDeviceStatus::RemoveReceiveWindowOpportunity (void)
 {
   Simulator::Cancel(m_receiveWindowEvent);
+  m_receiveWindowPending = false;
 }
 
 std::map<double, Address>
@@ -389,8 +452,7 @@ EndDeviceStatus::GetPowerGatewayMap (void)
   // Create a map of the gateways
   // Key: received power
   // Value: address of the corresponding gateway
-  ReceivedPacketInfo info = m_receivedPacketList.back ().second;
-  GatewayList gwList = info.gwList;
+  const GatewayList &gwList = GetReceivedPacketInfo (0).gwList;
 
   std::map<double, Address> gatewayPowers;
 
@@ -404,16 +466,55 @@ EndDeviceStatus::GetPowerGatewayMap (void)
   return gatewayPowers;
 }
 
+std::size_t
+EndDeviceStatus::GetBestGatewayCount (void) const
+{
+  return m_nBestGateways;
+}
+
+uint32_t
+EndDeviceStatus::GetBestGateway (std::size_t rank) const
+{
+  NS_ASSERT (rank < m_nBestGateways);
+
+  return m_bestGateways[rank].index;
+}
+
+void
+EndDeviceStatus::RankGateway (uint32_t gwIndex, double rxPower)
+{
+  // Find the position of the gateway, after the ones with a higher or equal
+  // power. If the array is full, the weakest gateway is dropped.
+  std::size_t position = m_nBestGateways;
+  while (position > 0 && m_bestGateways[position - 1].rxPower < rxPower)
+    {
+      position--;
+    }
+  if (position == std::size_t (N_BEST_GATEWAYS))
+    {
+      return;
+    }
+
+  std::size_t last = std::min (m_nBestGateways, std::size_t (N_BEST_GATEWAYS - 1));
+  for (std::size_t i = last; i > position; i--)
+    {
+      m_bestGateways[i] = m_bestGateways[i - 1];
+    }
+  m_bestGateways[position].rxPower = rxPower;
+  m_bestGateways[position].index = gwIndex;
+  m_nBestGateways = std::min (m_nBestGateways + 1, std::size_t (N_BEST_GATEWAYS));
+}
+
 std::ostream &
 operator<< (std::ostream &os, const EndDeviceStatus &status)
 {
-  os << "Total packets received: " << status.m_receivedPacketList.size () << std::endl;
+  os << "Packets in history: " << status.m_historyCount << std::endl;
 
-  for (auto j = status.m_receivedPacketList.begin (); j != status.m_receivedPacketList.end (); j++)
+  for (std::size_t age = status.m_historyCount; age-- > 0;)
     {
-      EndDeviceStatus::ReceivedPacketInfo info = (*j).second;
+      const EndDeviceStatus::ReceivedPacketInfo &info = status.GetReceivedPacketInfo (age);
       EndDeviceStatus::GatewayList gatewayList = info.gwList;
-      Ptr<Packet const> pkt = (*j).first;
+      Ptr<Packet const> pkt = info.packet;
       os << pkt << " " << gatewayList.size () << std::endl;
       for (EndDeviceStatus::GatewayList::iterator k = gatewayList.begin (); k != gatewayList.end ();
            k++)
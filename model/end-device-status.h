@@ -30,7 +30,12 @@
 #include "ns3/lora-frame-header.h"
 #include "ns3/pointer.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/parsed-uplink.h"
+#include "ns3/uid-hash-map.h"
+#include "ns3/rx-power-statistics.h"
+#include <array>
 #include <iostream>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -65,12 +70,12 @@ namespace lorawan {
  *                   - Need for reply (true/false)
  *                   - Updated reply
  *               --- Received Packets
- *                   - Received packets list (see below).
+ *                   - Last received packets (see below).
  *
  *
  * Private Access:
  *
- *  (Received packets list) - List of gateways that received the packet (see below)
+ *  (Received packets ring buffer, indexed by frame counter) - List of gateways that received the packet (see below)
  *                          - SF of the received packet
  *                          - Frequency of the received packet
  *                          - Bandwidth of the received packet
@@ -169,6 +174,7 @@ public:
   {
     // Members
     Ptr<Packet const> packet = 0;   //!< The received packet
+    Ptr<const ParsedUplink> uplink = 0; //!< The parsed content of the packet
     GatewayList gwList;      //!< List of gateways that received this packet.
     uint8_t sf;
     double frequency;
@@ -218,10 +224,41 @@ public:
   /**
    * Get the received packet list.
    *
+   * Only the last packets received from the device are kept (see
+   * SetMinHistoryLength), from the oldest to the most recent one.
+   *
    * \return The received packet list.
    */
   ReceivedPacketList GetReceivedPacketList (void);
 
+  /**
+   * Get the number of packets that are kept in the history of this device.
+   */
+  std::size_t GetReceivedPacketCount (void) const;
+
+  /**
+   * Get the information about a packet in the history of this device.
+   *
+   * \param age The position of the packet, starting from the most recent one
+   * (0) and going back in time. Must be lower than GetReceivedPacketCount ().
+   * \return The information about the packet.
+   */
+  const ReceivedPacketInfo &GetReceivedPacketInfo (std::size_t age) const;
+
+  /**
+   * Make sure that at least the given number of packets is kept in the
+   * history of this device. The history never shrinks.
+   *
+   * \param length The number of packets to keep.
+   */
+  void SetMinHistoryLength (std::size_t length);
+
+  /**
+   * Get the statistics of the power at which the last packets of this device
+   * were received, which are updated as packets are inserted.
+   */
+  RxPowerStatistics &GetRxPowerStatistics (void);
+
   /**
    * Set the spreading factor this device is using in the first receive window.
    */
@@ -265,15 +302,25 @@ public:
 
   /**
    * Insert a received packet in the packet list.
+   *
+   * \param uplink The packet, as parsed by the NetworkServer.
+   * \param gwAddress The address of the gateway that forwarded the packet.
+   * \param gwIndex The index of the gateway in the NetworkStatus.
    */
-  void InsertReceivedPacket (Ptr<Packet const> receivedPacket,
-                             const Address& gwAddress);
+  void InsertReceivedPacket (Ptr<const ParsedUplink> uplink,
+                             const Address& gwAddress, uint32_t gwIndex);
 
   /**
    * Return the last packet that was received from this device.
    */
   Ptr<Packet const> GetLastPacketReceivedFromDevice (void);
 
+  /**
+   * Return the parsed content of the last packet that was received from this
+   * device, or 0 if no packet was received yet.
+   */
+  Ptr<const ParsedUplink> GetLastReceivedUplink (void);
+
   /**
    * Return the information about the last packet that was received from the
    * device.
@@ -302,6 +349,18 @@ public:
 
   void SetReceiveWindowOpportunity (EventId event);
 
+  /**
+   * Mark a receive window opportunity as scheduled by the NetworkScheduler
+   * outside of the simulator event queue, or as handled.
+   */
+  void SetReceiveWindowOpportunityPending (bool pending);
+
+  /**
+   * Returns whether a receive window opportunity marked with
+   * SetReceiveWindowOpportunityPending is still waiting to be handled.
+   */
+  bool IsReceiveWindowOpportunityPending (void) const;
+
   void RemoveReceiveWindowOpportunity (void);
 
   /**
@@ -309,6 +368,27 @@ public:
    */
   std::map<double, Address> GetPowerGatewayMap (void);
 
+  /**
+   * The maximum number of gateways that are ranked for each device.
+   */
+  static const int N_BEST_GATEWAYS = 8;
+
+  /**
+   * Get the number of gateways that are ranked by the power at which they
+   * received the last packet of this device (at most N_BEST_GATEWAYS).
+   */
+  std::size_t GetBestGatewayCount (void) const;
+
+  /**
+   * Get the index of a gateway that received the last packet of this device.
+   *
+   * \param rank The rank of the gateway, from 0 for the one that received
+   * the packet with the highest power. Must be lower than
+   * GetBestGatewayCount ().
+   * \return The index of the gateway in the NetworkStatus.
+   */
+  uint32_t GetBestGateway (std::size_t rank) const;
+
   struct Reply m_reply; //<! Next reply intended for this device
 
   LoraDeviceAddress m_endDeviceAddress;   //<! The address of this device
@@ -322,8 +402,36 @@ private:
   uint8_t m_secondReceiveWindowOffset = 0;
   double m_secondReceiveWindowFrequency = 869.525;
   EventId m_receiveWindowEvent;
+  bool m_receiveWindowPending = false; //!< Whether an opportunity is pending
+
+  // The last received packets are kept in a ring buffer, and the slot of
+  // each of them is indexed by its frame counter, so that duplicates coming
+  // from other gateways can be found in constant time
+  std::vector<ReceivedPacketInfo> m_history; //!< The received packets
+  std::size_t m_historyHead = 0;   //!< The slot of the most recent packet
+  std::size_t m_historyCount = 0;  //!< The number of packets in m_history
+  uint32_t m_historyLength = 4;    //!< The initial size of m_history
+  UidHashMap<std::size_t> m_fCntIndex; //!< The slot of each frame counter
+
+  RxPowerStatistics m_rxPowerStatistics; //!< Statistics of the receive power
+
+  /**
+   * A gateway that received the last packet of this device.
+   */
+  struct RankedGateway
+  {
+    double rxPower;  //!< The power at which the gateway received the packet
+    uint32_t index;  //!< The index of the gateway in the NetworkStatus
+  };
+
+  /**
+   * Insert a gateway in m_bestGateways, keeping it sorted.
+   */
+  void RankGateway (uint32_t gwIndex, double rxPower);
 
-  ReceivedPacketList m_receivedPacketList;   //<! List of received packets
+  // The gateways that received the last packet, by decreasing power
+  std::array<RankedGateway, N_BEST_GATEWAYS> m_bestGateways; //!< The ranked gateways
+  std::size_t m_nBestGateways = 0; //!< The number of ranked gateways
 
   // NOTE Using this attribute is 'cheating', since we are assuming perfect
   // synchronization between the info at the device and at the network server
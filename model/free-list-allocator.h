@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FREE_LIST_ALLOCATOR_H
+#define FREE_LIST_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * An allocator that recycles single-object allocations through a free list.
+ *
+ * Objects that are created and destroyed at a high rate (like the events of
+ * LoraInterferenceHelper, or the nodes of the containers holding them) can use
+ * this allocator to avoid going through the heap each time: memory blocks are
+ * kept in a per-thread, per-type free list when they are released, and handed
+ * out again on the next allocation. Blocks are never given back to the heap,
+ * so the memory used is bounded by the peak number of live objects.
+ *
+ * The allocator is stateless, and can be used with standard containers.
+ */
+template <typename T>
+class FreeListAllocator
+{
+public:
+  typedef T value_type;
+
+  FreeListAllocator ()
+  {
+  }
+
+  template <typename U>
+  FreeListAllocator (const FreeListAllocator<U> &)
+  {
+  }
+
+  /**
+   * Allocate memory for n objects of type T.
+   *
+   * \param n The number of objects.
+   * \return A pointer to uninitialized memory.
+   */
+  T *
+  allocate (std::size_t n)
+  {
+    if (n == 1 && m_freeList != 0)
+      {
+        Block *block = m_freeList;
+        m_freeList = block->next;
+        return reinterpret_cast<T *> (block);
+      }
+    return static_cast<T *> (::operator new (n == 1 ? BlockSize () : n * sizeof (T)));
+  }
+
+  /**
+   * Release memory obtained through allocate.
+   *
+   * \param p The memory to release.
+   * \param n The number of objects p was allocated for.
+   */
+  void
+  deallocate (T *p, std::size_t n)
+  {
+    if (n == 1)
+      {
+        Block *block = reinterpret_cast<Block *> (p);
+        block->next = m_freeList;
+        m_freeList = block;
+      }
+    else
+      {
+        ::operator delete (p);
+      }
+  }
+
+private:
+  /**
+   * A released memory block, linked to the next one in the free list.
+   */
+  struct Block
+  {
+    Block *next;
+  };
+
+  /**
+   * The size of single-object blocks, large enough to hold a Block too.
+   */
+  static std::size_t
+  BlockSize (void)
+  {
+    return sizeof (T) > sizeof (Block) ? sizeof (T) : sizeof (Block);
+  }
+
+  static thread_local Block *m_freeList; //!< The released blocks
+};
+
+template <typename T>
+thread_local typename FreeListAllocator<T>::Block *FreeListAllocator<T>::m_freeList = 0;
+
+template <typename T, typename U>
+bool
+operator== (const FreeListAllocator<T> &, const FreeListAllocator<U> &)
+{
+  return true;
+}
+
+template <typename T, typename U>
+bool
+operator!= (const FreeListAllocator<T> &, const FreeListAllocator<U> &)
+{
+  return false;
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* FREE_LIST_ALLOCATOR_H */
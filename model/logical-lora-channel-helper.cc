@@ -39,50 +39,87 @@ LogicalLoraChannelHelper::GetTypeId (void)
 }
 
 LogicalLoraChannelHelper::LogicalLoraChannelHelper () :
+  m_plan (Create<RegionalChannelPlan> ()),
+  m_enabledChannels (0),
   m_nextAggregatedTransmissionTime (Seconds (0)),
   m_aggregatedDutyCycle (1)
 {
   NS_LOG_FUNCTION (this);
 }
 
+LogicalLoraChannelHelper::LogicalLoraChannelHelper (Ptr<RegionalChannelPlan> plan) :
+  m_plan (plan),
+  m_enabledChannels (0),
+  m_nextAggregatedTransmissionTime (Seconds (0)),
+  m_aggregatedDutyCycle (1)
+{
+  NS_LOG_FUNCTION (this << plan);
+
+  const std::vector<Ptr<LogicalLoraChannel> > &channels = m_plan->GetChannels ();
+  NS_ABORT_MSG_IF (channels.size () > MAX_CHANNELS, "Too many channels in the plan");
+  for (uint32_t i = 0; i < channels.size (); i++)
+    {
+      if (channels[i]->IsEnabledForUplink ())
+        {
+          m_enabledChannels |= uint64_t (1) << i;
+        }
+    }
+  for (auto &subBand : m_plan->GetSubBands ())
+    {
+      m_nextTransmissionTimes.push_back (subBand->GetNextTransmissionTime ());
+    }
+}
+
 LogicalLoraChannelHelper::~LogicalLoraChannelHelper ()
 {
   NS_LOG_FUNCTION (this);
 }
 
+Ptr<const RegionalChannelPlan>
+LogicalLoraChannelHelper::GetChannelPlan (void) const
+{
+  return m_plan;
+}
+
+Ptr<RegionalChannelPlan>
+LogicalLoraChannelHelper::GetWritablePlan (void)
+{
+  // Copy on write, the channels and SubBands themselves are not modified
+  if (m_plan->IsShared ())
+    {
+      NS_LOG_DEBUG ("Copying the shared channel plan");
+      m_plan = Create<RegionalChannelPlan> (*m_plan);
+    }
+  return m_plan;
+}
+
 std::vector<Ptr <LogicalLoraChannel> >
 LogicalLoraChannelHelper::GetChannelList (void)
 {
   NS_LOG_FUNCTION (this);
 
   // Make a copy of the channel vector
-  std::vector<Ptr<LogicalLoraChannel> > vector;
-  vector.reserve (m_channelList.size ());
-  std::copy (m_channelList.begin (), m_channelList.end (), std::back_inserter
-               (vector));
-
-  return vector;
+  return m_plan->GetChannels ();
 }
 
+const std::vector<Ptr <LogicalLoraChannel> > &
+LogicalLoraChannelHelper::GetChannels (void) const
+{
+  return m_plan->GetChannels ();
+}
 
 std::vector<Ptr <LogicalLoraChannel> >
 LogicalLoraChannelHelper::GetEnabledChannelList (void)
 {
   NS_LOG_FUNCTION (this);
 
-  // Make a copy of the channel vector
-  std::vector<Ptr<LogicalLoraChannel> > vector;
-  vector.reserve (m_channelList.size ());
-  std::copy (m_channelList.begin (), m_channelList.end (), std::back_inserter
-               (vector));     // Working on a copy
-
+  const std::vector<Ptr<LogicalLoraChannel> > &channelList = m_plan->GetChannels ();
   std::vector<Ptr <LogicalLoraChannel> > channels;
-  std::vector<Ptr <LogicalLoraChannel> >::iterator it;
-  for (it = vector.begin (); it != vector.end (); it++)
+  for (uint32_t i = 0; i < channelList.size (); i++)
     {
-      if ((*it)->IsEnabledForUplink ())
+      if (IsChannelEnabled (i))
         {
-          channels.push_back (*it);
+          channels.push_back (channelList[i]);
         }
     }
 
@@ -100,19 +137,31 @@ Ptr<SubBand>
 LogicalLoraChannelHelper::GetSubBandFromFrequency (double frequency)
 {
   // Get the SubBand this frequency belongs to
-  std::list< Ptr< SubBand > >::iterator it;
-  for (it = m_subBandList.begin (); it != m_subBandList.end (); it++)
+  return m_plan->GetSubBands ()[GetSubBandIndex (frequency)];
+}
+
+int
+LogicalLoraChannelHelper::GetSubBandIndex (double frequency) const
+{
+  int index = m_plan->GetSubBandIndex (frequency);
+  if (index == RegionalChannelPlan::NO_SUB_BAND)
     {
-      if ((*it)->BelongsToSubBand (frequency))
-        {
-          return *it;
-        }
+      NS_LOG_ERROR ("Requested frequency: " << frequency);
+      NS_ABORT_MSG ("Warning: frequency is outside any known SubBand.");
     }
+  return index;
+}
 
-  NS_LOG_ERROR ("Requested frequency: " << frequency);
-  NS_ABORT_MSG ("Warning: frequency is outside any known SubBand.");
-
-  return 0;     // If no SubBand is found, return 0
+int
+LogicalLoraChannelHelper::GetChannelSubBandIndex (uint32_t chIndex) const
+{
+  int index = m_plan->GetChannelSubBandIndex (chIndex);
+  if (index == RegionalChannelPlan::NO_SUB_BAND)
+    {
+      NS_LOG_ERROR ("Requested frequency: " << m_plan->GetChannels ()[chIndex]->GetFrequency ());
+      NS_ABORT_MSG ("Warning: frequency is outside any known SubBand.");
+    }
+  return index;
 }
 
 void
@@ -120,14 +169,11 @@ LogicalLoraChannelHelper::AddChannel (double frequency)
 {
   NS_LOG_FUNCTION (this << frequency);
 
-  // Create the new channel and increment the counter
-  Ptr<LogicalLoraChannel> channel = Create<LogicalLoraChannel> (frequency);
-
-  // Add it to the list
-  m_channelList.push_back (channel);
+  // Create the new channel and add it to the list
+  AddChannel (Create<LogicalLoraChannel> (frequency));
 
   NS_LOG_DEBUG ("Added a channel. Current number of channels in list is " <<
-                m_channelList.size ());
+                m_plan->GetChannels ().size ());
 }
 
 void
@@ -135,8 +181,15 @@ LogicalLoraChannelHelper::AddChannel (Ptr<LogicalLoraChannel> logicalChannel)
 {
   NS_LOG_FUNCTION (this << logicalChannel);
 
+  uint32_t chIndex = m_plan->GetChannels ().size ();
+  NS_ABORT_MSG_IF (chIndex >= MAX_CHANNELS, "Too many channels");
+
   // Add it to the list
-  m_channelList.push_back (logicalChannel);
+  GetWritablePlan ()->AddChannel (logicalChannel);
+  if (logicalChannel->IsEnabledForUplink ())
+    {
+      EnableChannel (chIndex);
+    }
 }
 
 void
@@ -146,7 +199,15 @@ LogicalLoraChannelHelper::SetChannel (uint8_t chIndex,
 {
   NS_LOG_FUNCTION (this << chIndex << logicalChannel);
 
-  m_channelList.at (chIndex) = logicalChannel;
+  GetWritablePlan ()->SetChannel (chIndex, logicalChannel);
+  if (logicalChannel->IsEnabledForUplink ())
+    {
+      EnableChannel (chIndex);
+    }
+  else
+    {
+      DisableChannel (chIndex);
+    }
 }
 
 void
@@ -159,7 +220,7 @@ LogicalLoraChannelHelper::AddSubBand (double firstFrequency,
   Ptr<SubBand> subBand = Create<SubBand> (firstFrequency, lastFrequency,
                                           dutyCycle, maxTxPowerDbm);
 
-  m_subBandList.push_back (subBand);
+  AddSubBand (subBand);
 }
 
 void
@@ -167,20 +228,25 @@ LogicalLoraChannelHelper::AddSubBand (Ptr<SubBand> subBand)
 {
   NS_LOG_FUNCTION (this << subBand);
 
-  m_subBandList.push_back (subBand);
+  GetWritablePlan ()->AddSubBand (subBand);
+  m_nextTransmissionTimes.push_back (subBand->GetNextTransmissionTime ());
 }
 
 void
 LogicalLoraChannelHelper::RemoveChannel (Ptr<LogicalLoraChannel> logicalChannel)
 {
   // Search and remove the channel from the list
-  std::vector<Ptr<LogicalLoraChannel> >::iterator it;
-  for (it = m_channelList.begin (); it != m_channelList.end (); it++)
+  const std::vector<Ptr<LogicalLoraChannel> > &channels = m_plan->GetChannels ();
+  for (uint32_t i = 0; i < channels.size (); i++)
     {
-      Ptr<LogicalLoraChannel> currentChannel = *it;
-      if (currentChannel == logicalChannel)
+      if (channels[i] == logicalChannel)
         {
-          m_channelList.erase (it);
+          GetWritablePlan ()->RemoveChannel (i);
+
+          // Move the bits of the following channels down
+          uint64_t below = m_enabledChannels & ((uint64_t (1) << i) - 1);
+          uint64_t above = i + 1 < MAX_CHANNELS ? (m_enabledChannels >> (i + 1)) << i : 0;
+          m_enabledChannels = below | above;
           return;
         }
     }
@@ -206,34 +272,62 @@ LogicalLoraChannelHelper::GetWaitingTime (Ptr<LogicalLoraChannel> channel)
 {
   NS_LOG_FUNCTION (this << channel);
 
-  // SubBand waiting time
-  Time subBandWaitingTime = GetSubBandFromChannel (channel)->
-    GetNextTransmissionTime () -
-    Simulator::Now ();
+  int index = GetSubBandIndex (channel->GetFrequency ());
 
-  // Handle case in which waiting time is negative
-  subBandWaitingTime = Seconds (std::max (subBandWaitingTime.GetSeconds (),
-                                          double(0)));
+  // SubBand waiting time, handling the case in which it is negative
+  Time subBandWaitingTime = std::max (m_nextTransmissionTimes[index] - Simulator::Now (),
+                                      Time (0));
 
   NS_LOG_DEBUG ("Waiting time: " << subBandWaitingTime.GetSeconds ());
 
   return subBandWaitingTime;
 }
 
+Time
+LogicalLoraChannelHelper::GetWaitingTime (uint32_t chIndex) const
+{
+  Time nextTime = m_nextTransmissionTimes[GetChannelSubBandIndex (chIndex)];
+  return std::max (nextTime - Simulator::Now (), Time (0));
+}
+
+Time
+LogicalLoraChannelHelper::GetMinimumWaitingTime (void) const
+{
+  Time nextTime = Time::Max ();
+  uint32_t nChannels = m_plan->GetChannels ().size ();
+  for (uint32_t i = 0; i < nChannels; i++)
+    {
+      if (IsChannelEnabled (i))
+        {
+          nextTime = std::min (nextTime, m_nextTransmissionTimes[GetChannelSubBandIndex (i)]);
+        }
+    }
+  if (nextTime == Time::Max ())
+    {
+      return nextTime;
+    }
+
+  Time waitingTime = std::max (nextTime - Simulator::Now (), Time (0));
+
+  NS_LOG_DEBUG ("Minimum waiting time: " << waitingTime.GetSeconds ());
+
+  return waitingTime;
+}
+
 void
 LogicalLoraChannelHelper::AddEvent (Time duration,
                                     Ptr<LogicalLoraChannel> channel)
 {
   NS_LOG_FUNCTION (this << duration << channel);
 
-  Ptr<SubBand> subBand = GetSubBandFromChannel (channel);
+  int index = GetSubBandIndex (channel->GetFrequency ());
 
-  double dutyCycle = subBand->GetDutyCycle ();
+  double dutyCycle = m_plan->GetSubBands ()[index]->GetDutyCycle ();
   double timeOnAir = duration.GetSeconds ();
 
   // Computation of necessary waiting time on this sub-band
-  subBand->SetNextTransmissionTime (Simulator::Now () + Seconds
-                                      (timeOnAir / dutyCycle - timeOnAir));
+  m_nextTransmissionTimes[index] = Simulator::Now () + Seconds
+      (timeOnAir / dutyCycle - timeOnAir);
 
   // Computation of necessary aggregate waiting time
   m_nextAggregatedTransmissionTime = Simulator::Now () + Seconds
@@ -243,7 +337,7 @@ LogicalLoraChannelHelper::AddEvent (Time duration,
   NS_LOG_DEBUG ("m_aggregatedDutyCycle: " << m_aggregatedDutyCycle);
   NS_LOG_DEBUG ("Current time: " << Simulator::Now ().GetSeconds ());
   NS_LOG_DEBUG ("Next transmission on this sub-band allowed at time: " <<
-                (subBand->GetNextTransmissionTime ()).GetSeconds ());
+                m_nextTransmissionTimes[index].GetSeconds ());
   NS_LOG_DEBUG ("Next aggregated transmission allowed at time " <<
                 m_nextAggregatedTransmissionTime.GetSeconds ());
 }
@@ -255,18 +349,8 @@ LogicalLoraChannelHelper::GetTxPowerForChannel (Ptr<LogicalLoraChannel>
   NS_LOG_FUNCTION_NOARGS ();
 
   // Get the maxTxPowerDbm from the SubBand this channel is in
-  std::list< Ptr< SubBand > >::iterator it;
-  for (it = m_subBandList.begin (); it != m_subBandList.end (); it++)
-    {
-      // Check whether this channel is in this SubBand
-      if ((*it)->BelongsToSubBand (logicalChannel->GetFrequency ()))
-        {
-          return (*it)->GetMaxTxPowerDbm ();
-        }
-    }
-  NS_ABORT_MSG ("Logical channel doesn't belong to a known SubBand");
-
-  return 0;
+  int index = GetSubBandIndex (logicalChannel->GetFrequency ());
+  return m_plan->GetSubBands ()[index]->GetMaxTxPowerDbm ();
 }
 
 void
@@ -274,7 +358,23 @@ LogicalLoraChannelHelper::DisableChannel (int index)
 {
   NS_LOG_FUNCTION (this << index);
 
-  m_channelList.at (index)->DisableForUplink ();
+  NS_ASSERT (uint32_t (index) < m_plan->GetChannels ().size ());
+  m_enabledChannels &= ~(uint64_t (1) << index);
+}
+
+void
+LogicalLoraChannelHelper::EnableChannel (int index)
+{
+  NS_LOG_FUNCTION (this << index);
+
+  NS_ASSERT (uint32_t (index) < m_plan->GetChannels ().size ());
+  m_enabledChannels |= uint64_t (1) << index;
+}
+
+bool
+LogicalLoraChannelHelper::IsChannelEnabled (uint32_t index) const
+{
+  return (m_enabledChannels >> index) & 1;
 }
 }
 }
@@ -26,6 +26,7 @@
 #include "ns3/nstime.h"
 #include "ns3/packet.h"
 #include "ns3/sub-band.h"
+#include "ns3/regional-channel-plan.h"
 #include <list>
 #include <iterator>
 #include <vector>
@@ -41,6 +42,14 @@ namespace lorawan {
  * This class also takes into account duty cycle limitations, by updating a list
  * of SubBand objects and providing methods to query whether transmission on a
  * set channel is admissible or not.
+ *
+ * The channels and SubBands are kept in a RegionalChannelPlan, which copies
+ * of this helper share until one of them changes its channels or SubBands.
+ * The state that is specific to a device is kept by the helper: a bitmask of
+ * the channels that are enabled for uplink, and the next transmission time
+ * of each SubBand, in a flat array. The enabled state of a channel is taken
+ * from the LogicalLoraChannel when it is added, and is then managed through
+ * EnableChannel and DisableChannel.
  */
 class LogicalLoraChannelHelper : public Object
 {
@@ -50,6 +59,19 @@ public:
   LogicalLoraChannelHelper ();
   virtual ~LogicalLoraChannelHelper ();
 
+  /**
+   * Create a helper using a channel plan, which is shared with the other
+   * helpers that use it.
+   *
+   * \param plan The channel plan.
+   */
+  LogicalLoraChannelHelper (Ptr<RegionalChannelPlan> plan);
+
+  /**
+   * \return The channel plan used by this helper.
+   */
+  Ptr<const RegionalChannelPlan> GetChannelPlan (void) const;
+
   /**
    * Get the time it is necessary to wait before transmitting again, according
    * to the aggregate duty cycle timer.
@@ -72,6 +94,28 @@ public:
    */
   Time GetWaitingTime (Ptr<LogicalLoraChannel> channel);
 
+  /**
+   * Get the time it is necessary to wait for before transmitting on the
+   * channel at a given index.
+   *
+   * \remark This function does not take into account aggregate waiting time.
+   *
+   * \param chIndex The index of the channel in the channel list.
+   * \return The waiting time before transmission is allowed on the channel.
+   */
+  Time GetWaitingTime (uint32_t chIndex) const;
+
+  /**
+   * Get the minimum time it is necessary to wait for before transmitting on
+   * any of the channels enabled for uplink.
+   *
+   * \remark This function does not take into account aggregate waiting time.
+   *
+   * \return The minimum waiting time, or Time::Max () if no channel is
+   * enabled for uplink.
+   */
+  Time GetMinimumWaitingTime (void) const;
+
   /**
    * Register the transmission of a packet.
    *
@@ -87,6 +131,15 @@ public:
    */
   std::vector<Ptr<LogicalLoraChannel> > GetChannelList (void);
 
+  /**
+   * Get the LogicalLoraChannels currently registered on this helper, without
+   * copying them.
+   *
+   * \return A reference to the managed channels, which is invalidated when
+   * channels are added or removed.
+   */
+  const std::vector<Ptr<LogicalLoraChannel> > &GetChannels (void) const;
+
   /**
    * Get the list of LogicalLoraChannels currently registered on this helper
    * that have been enabled for Uplink transmission with the channel mask.
@@ -175,18 +228,68 @@ public:
    */
   void DisableChannel (int index);
 
+  /**
+   * Enable the channel at a specified index.
+   *
+   * \param index The index of the channel to enable.
+   */
+  void EnableChannel (int index);
+
+  /**
+   * Test whether the channel at a specified index is enabled for uplink.
+   *
+   * \param index The index of the channel.
+   * \return True if the channel is enabled for uplink.
+   */
+  bool IsChannelEnabled (uint32_t index) const;
+
 private:
+  static const uint32_t MAX_CHANNELS = 64; //!< The size of the channel mask
+
+  /**
+   * Get the index of the SubBand of a frequency, aborting if the frequency is
+   * outside any known SubBand.
+   *
+   * \param frequency The frequency we want to check.
+   * \return The index of the SubBand in the channel plan.
+   */
+  int GetSubBandIndex (double frequency) const;
+
+  /**
+   * Get the index of the SubBand of the channel at a given index, aborting if
+   * the channel is outside any known SubBand.
+   *
+   * \param chIndex The index of the channel in the channel list.
+   * \return The index of the SubBand in the channel plan.
+   */
+  int GetChannelSubBandIndex (uint32_t chIndex) const;
+
+  /**
+   * Get the channel plan, copying it first if it is shared with other
+   * helpers, so that it can be modified.
+   *
+   * \return The channel plan of this helper only.
+   */
+  Ptr<RegionalChannelPlan> GetWritablePlan (void);
+
+  /**
+   * The SubBands and the LogicalLoraChannels that are currently registered
+   * within this helper. The channel list represents the node's channel mask.
+   * The first N channels are the default ones for a fixed region.
+   */
+  Ptr<RegionalChannelPlan> m_plan;
+
   /**
-   * A list of the SubBands that are currently registered within this helper.
+   * The channels that are enabled for uplink, as a bitmask indexed like the
+   * channels of the plan.
    */
-  std::list<Ptr <SubBand> > m_subBandList;
+  uint64_t m_enabledChannels;
 
   /**
-   * A vector of the LogicalLoraChannels that are currently registered within
-   * this helper. This vector represents the node's channel mask. The first N
-   * channels are the default ones for a fixed region.
+   * The next time at which transmission is allowed on each SubBand, indexed
+   * like the SubBands of the plan.
    */
-  std::vector<Ptr <LogicalLoraChannel> > m_channelList;
+  std::vector<Time> m_nextTransmissionTimes;
 
   Time m_nextAggregatedTransmissionTime; //!< The next time at which
   //!transmission will be possible
@@ -41,7 +41,8 @@ LogicalLoraChannel::LogicalLoraChannel () :
   m_frequency (0),
   m_minDataRate (0),
   m_maxDataRate (5),
-  m_enabledForUplink (true)
+  m_enabledForUplink (true),
+  m_readOnly (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -53,7 +54,8 @@ LogicalLoraChannel::~LogicalLoraChannel ()
 
 LogicalLoraChannel::LogicalLoraChannel (double frequency) :
   m_frequency (frequency),
-  m_enabledForUplink (true)
+  m_enabledForUplink (true),
+  m_readOnly (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -63,7 +65,8 @@ LogicalLoraChannel::LogicalLoraChannel (double frequency, uint8_t minDataRate,
   m_frequency (frequency),
   m_minDataRate (minDataRate),
   m_maxDataRate (maxDataRate),
-  m_enabledForUplink (true)
+  m_enabledForUplink (true),
+  m_readOnly (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -77,12 +80,18 @@ LogicalLoraChannel::GetFrequency (void) const
 void
 LogicalLoraChannel::SetMinimumDataRate (uint8_t minDataRate)
 {
+  NS_ABORT_MSG_IF (m_readOnly, "Channels can't be modified once they are in "
+                   "a channel plan");
+
   m_minDataRate = minDataRate;
 }
 
 void
 LogicalLoraChannel::SetMaximumDataRate (uint8_t maxDataRate)
 {
+  NS_ABORT_MSG_IF (m_readOnly, "Channels can't be modified once they are in "
+                   "a channel plan");
+
   m_maxDataRate = maxDataRate;
 }
 
@@ -101,12 +110,18 @@ LogicalLoraChannel::GetMaximumDataRate (void)
 void
 LogicalLoraChannel::SetEnabledForUplink (void)
 {
+  NS_ABORT_MSG_IF (m_readOnly, "Channels can't be modified once they are in "
+                   "a channel plan");
+
   m_enabledForUplink = true;
 }
 
 void
 LogicalLoraChannel::DisableForUplink (void)
 {
+  NS_ABORT_MSG_IF (m_readOnly, "Channels can't be modified once they are in "
+                   "a channel plan");
+
   m_enabledForUplink = false;
 }
 
@@ -116,6 +131,18 @@ LogicalLoraChannel::IsEnabledForUplink (void)
   return m_enabledForUplink;
 }
 
+void
+LogicalLoraChannel::SetReadOnly (void)
+{
+  m_readOnly = true;
+}
+
+bool
+LogicalLoraChannel::IsReadOnly (void) const
+{
+  return m_readOnly;
+}
+
 bool
 operator== (const Ptr<LogicalLoraChannel>& first,
             const Ptr<LogicalLoraChannel>& second)
@@ -37,6 +37,11 @@ class SubBand;
  *
  * Furthermore, a LogicalLoraChannel can be marked as enabled or disabled for
  * uplink transmission.
+ *
+ * Once it is added to a RegionalChannelPlan, a channel can be shared by the
+ * channel plans of multiple devices, and becomes read-only: its setters
+ * abort the simulation. The uplink mask of a device is changed through
+ * LogicalLoraChannelHelper::EnableChannel and DisableChannel instead.
  */
 class LogicalLoraChannel : public Object
 {
@@ -74,11 +79,15 @@ public:
 
   /**
    * Set the minimum Data Rate that is allowed on this channel.
+   *
+   * The channel must not be read-only.
    */
   void SetMinimumDataRate (uint8_t minDataRate);
 
   /**
    * Set the maximum Data Rate that is allowed on this channel.
+   *
+   * The channel must not be read-only.
    */
   void SetMaximumDataRate (uint8_t maxDataRate);
 
@@ -94,11 +103,16 @@ public:
 
   /**
    * Set this channel as enabled for uplink.
+   *
+   * LogicalLoraChannelHelper only reads this flag when the channel is added
+   * to it. The channel must not be read-only.
    */
   void SetEnabledForUplink (void);
 
   /**
    * Set this channel as disabled for uplink.
+   *
+   * The channel must not be read-only.
    */
   void DisableForUplink (void);
 
@@ -107,6 +121,17 @@ public:
    */
   bool IsEnabledForUplink (void);
 
+  /**
+   * Make this channel read-only, because it was added to a channel plan that
+   * can be shared by multiple devices.
+   */
+  void SetReadOnly (void);
+
+  /**
+   * \return Whether this channel is read-only.
+   */
+  bool IsReadOnly (void) const;
+
 private:
   /**
    * The central frequency of this channel, in MHz.
@@ -127,6 +152,11 @@ private:
    * Whether this channel can be used for uplink or not.
    */
   bool m_enabledForUplink;
+
+  /**
+   * Whether this channel belongs to a channel plan, and can't be modified.
+   */
+  bool m_readOnly;
 };
 
 /**
@@ -20,13 +20,23 @@
 
 #include "ns3/lora-channel.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/pointer.h"
 #include "ns3/object-factory.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/gateway-lora-phy.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/tag.h"
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#endif
 #include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 namespace lorawan {
@@ -35,6 +45,77 @@ NS_LOG_COMPONENT_DEFINE ("LoraChannel");
 
 NS_OBJECT_ENSURE_REGISTERED (LoraChannel);
 
+#ifdef NS3_MPI
+/**
+ * Tag used to carry the parameters of a transmission to a PHY that lives on
+ * another rank of a distributed simulation.
+ */
+class LoraChannelTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer i) const;
+  virtual void Deserialize (TagBuffer i);
+  virtual void Print (std::ostream &os) const;
+
+  uint32_t m_phyIndex;     //!< The index of the receiver in m_phys.
+  LoraChannelParameters m_parameters;     //!< The transmission parameters.
+};
+
+NS_OBJECT_ENSURE_REGISTERED (LoraChannelTag);
+
+TypeId
+LoraChannelTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LoraChannelTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<LoraChannelTag> ();
+  return tid;
+}
+
+TypeId
+LoraChannelTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LoraChannelTag::GetSerializedSize (void) const
+{
+  // Index, power, SF, duration, frequency
+  return 4 + 8 + 1 + 8 + 8;
+}
+
+void
+LoraChannelTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_phyIndex);
+  i.WriteDouble (m_parameters.rxPowerDbm);
+  i.WriteU8 (m_parameters.sf);
+  i.WriteU64 (m_parameters.duration.GetTimeStep ());
+  i.WriteDouble (m_parameters.frequencyMHz);
+}
+
+void
+LoraChannelTag::Deserialize (TagBuffer i)
+{
+  m_phyIndex = i.ReadU32 ();
+  m_parameters.rxPowerDbm = i.ReadDouble ();
+  m_parameters.sf = i.ReadU8 ();
+  m_parameters.duration = Time (int64_t (i.ReadU64 ()));
+  m_parameters.frequencyMHz = i.ReadDouble ();
+}
+
+void
+LoraChannelTag::Print (std::ostream &os) const
+{
+  os << m_phyIndex << " " << m_parameters;
+}
+#endif
+
 TypeId
 LoraChannel::GetTypeId (void)
 {
@@ -52,6 +133,40 @@ LoraChannel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraChannel::m_delay),
                    MakePointerChecker<PropagationDelayModel> ())
+    .AddAttribute ("MaxRange",
+                   "The distance [m] beyond which PHYs are not notified of a "
+                   "transmission. Receivers are culled through a spatial "
+                   "index, without computing propagation for them. PHYs "
+                   "that are moving are checked against their current "
+                   "position at every transmission. A value of 0 disables "
+                   "culling.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&LoraChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("CacheLinkBudget",
+                   "Whether to cache the received power and delay computed by "
+                   "the propagation models for each pair of PHYs and "
+                   "transmission power. Cached values are invalidated when "
+                   "the sender or the receiver changes course, and links "
+                   "involving a moving PHY are not cached, so this only "
+                   "helps with PHYs that stay still between course changes. "
+                   "Note that random components of the loss models are "
+                   "drawn only once per link when this is enabled.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraChannel::m_cacheLinkBudget),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SharedInterference",
+                   "Whether to keep a single log of the recent transmissions, "
+                   "which end device PHYs use to rebuild the interference "
+                   "they are subject to when they start listening, instead of "
+                   "keeping track of every transmission while they sleep or "
+                   "transmit. The received power of logged transmissions is "
+                   "computed when they are needed, so random components of "
+                   "the loss models are drawn at that time. Not supported in "
+                   "distributed simulations.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraChannel::m_sharedInterference),
+                   MakeBooleanChecker ())
     .AddTraceSource ("PacketSent",
                      "Trace source fired whenever a packet goes out on the channel",
                      MakeTraceSourceAccessor (&LoraChannel::m_packetSent),
@@ -59,29 +174,87 @@ LoraChannel::GetTypeId (void)
   return tid;
 }
 
-LoraChannel::LoraChannel ()
+LoraChannel::LoraChannel () :
+  m_phyRecordsOutdated (false),
+  m_maxRange (0),
+  m_gridOutdated (true),
+  m_gridCellSize (0),
+  m_cacheLinkBudget (false),
+  m_sharedInterference (false),
+  m_nextTransmissionId (0)
 {
 }
 
 LoraChannel::~LoraChannel ()
 {
-  m_phyList.clear ();
+  m_phys.clear ();
 }
 
 LoraChannel::LoraChannel (Ptr<PropagationLossModel> loss,
                           Ptr<PropagationDelayModel> delay) :
+  m_phyRecordsOutdated (false),
   m_loss (loss),
-  m_delay (delay)
+  m_delay (delay),
+  m_maxRange (0),
+  m_gridOutdated (true),
+  m_gridCellSize (0),
+  m_cacheLinkBudget (false),
+  m_sharedInterference (false),
+  m_nextTransmissionId (0)
 {
 }
 
+void
+LoraChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Callbacks were created from const methods, match their type
+  const LoraChannel *self = this;
+  std::set<Ptr<MobilityModel> >::iterator it;
+  for (it = m_trackedMobilities.begin (); it != m_trackedMobilities.end (); it++)
+    {
+      (*it)->TraceDisconnectWithoutContext
+        ("CourseChange", MakeCallback (&LoraChannel::CourseChanged, self));
+    }
+  m_trackedMobilities.clear ();
+  m_linkBudgets.clear ();
+  m_mobilityLinkBudgets.clear ();
+  m_transmissionLog.clear ();
+  m_grid.clear ();
+  m_gridPositions.clear ();
+  m_movingPhys.clear ();
+  m_mobilityPhys.clear ();
+
+  Channel::DoDispose ();
+}
+
 void
 LoraChannel::Add (Ptr<LoraPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
 
-  // Add the new phy to the vector
-  m_phyList.push_back (phy);
+  // Add the new phy to the vector. Its mobility model, device and node are
+  // usually set later, so they are looked up before the next transmission.
+  PhyRecord record;
+  record.phy = phy;
+  record.nodeId = 0;
+  record.systemId = 0;
+  record.isGateway = false;
+
+  // End device PHYs only listen in STANDBY and RX, and tell the channel when
+  // this changes. They start in SLEEP.
+  Ptr<EndDeviceLoraPhy> endDevicePhy = DynamicCast<EndDeviceLoraPhy> (phy);
+  record.listening = endDevicePhy == 0
+    || endDevicePhy->GetState () == EndDeviceLoraPhy::STANDBY
+    || endDevicePhy->GetState () == EndDeviceLoraPhy::RX;
+  record.missedSince = m_nextTransmissionId;
+  m_phyIndexes[PeekPointer (phy)] = m_phys.size ();
+  m_phys.push_back (record);
+  m_phyRecordsOutdated = true;
+
+  // The spatial index needs to learn about this PHY
+  m_gridOutdated = true;
 }
 
 void
@@ -89,20 +262,205 @@ LoraChannel::Remove (Ptr<LoraPhy> phy)
 {
   NS_LOG_FUNCTION (this << phy);
 
+  // Forget the link budgets that involve this PHY. They are indexed by the
+  // mobility model it had when they were computed.
+  auto record = std::find_if (m_phys.begin (), m_phys.end (),
+                              [&phy] (const PhyRecord &record)
+                              {
+                                return record.phy == phy;
+                              });
+  NS_ASSERT (record != m_phys.end ());
+  ForgetLinkBudgets (PeekPointer (record->mobility), PeekPointer (phy));
+  if (phy->GetMobility () != record->mobility)
+    {
+      ForgetLinkBudgets (PeekPointer (phy->GetMobility ()), PeekPointer (phy));
+    }
+
   // Remove the phy from the vector
-  m_phyList.erase (find (m_phyList.begin (), m_phyList.end (), phy));
+  m_phys.erase (record);
+
+  // Indexes in the spatial index and in the registry of listening PHYs are
+  // not valid anymore
+  m_phyIndexes.clear ();
+  for (uint32_t j = 0; j < m_phys.size (); j++)
+    {
+      m_phyIndexes[PeekPointer (m_phys[j].phy)] = j;
+    }
+  m_phyRecordsOutdated = true;
+  m_gridOutdated = true;
 }
 
 std::size_t
 LoraChannel::GetNDevices (void) const
 {
-  return m_phyList.size ();
+  return m_phys.size ();
 }
 
 Ptr<NetDevice>
 LoraChannel::GetDevice (std::size_t i) const
 {
-  return m_phyList[i]->GetDevice ()->GetObject<NetDevice> ();
+  return m_phys[i].phy->GetDevice ()->GetObject<NetDevice> ();
+}
+
+bool
+LoraChannel::IsInterferenceShared (void) const
+{
+  return m_sharedInterference;
+}
+
+std::vector<LoraImpingingTransmission>
+LoraChannel::GetImpingingTransmissions (Ptr<LoraPhy> receiver, Time since) const
+{
+  NS_LOG_FUNCTION (this << receiver << since);
+
+  std::vector<LoraImpingingTransmission> transmissions;
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+  for (auto &transmission : m_transmissionLog)
+    {
+      // Skip the transmissions that are surely over, without computing their
+      // propagation
+      if (transmission.sender == receiver
+          || transmission.startTime + transmission.duration + Seconds (1) < Simulator::Now ()
+          || !IsInRange (transmission.senderPosition, receiverMobility))
+        {
+          continue;
+        }
+
+      Time delay;
+      double rxPowerDbm;
+      GetLinkBudget (transmission.sender, transmission.senderMobility, receiver,
+                     receiverMobility, transmission.txPowerDbm, delay, rxPowerDbm);
+
+      // Only keep the transmissions that arrived while the PHY was not
+      // listening, and that did not end yet
+      Time startTime = transmission.startTime + delay;
+      if (startTime <= since || startTime >= Simulator::Now ()
+          || startTime + transmission.duration <= Simulator::Now ())
+        {
+          continue;
+        }
+
+      LoraImpingingTransmission impinging;
+      impinging.packet = transmission.packet;
+      impinging.startTime = startTime;
+      impinging.parameters.rxPowerDbm = rxPowerDbm;
+      impinging.parameters.sf = transmission.sf;
+      impinging.parameters.duration = transmission.duration;
+      impinging.parameters.frequencyMHz = transmission.frequencyMHz;
+      transmissions.push_back (impinging);
+    }
+
+  NS_LOG_DEBUG ("Found " << transmissions.size () << " impinging transmissions");
+
+  return transmissions;
+}
+
+void
+LoraChannel::SetListening (Ptr<LoraPhy> phy, bool listening)
+{
+  NS_LOG_FUNCTION (this << phy << listening);
+
+  auto it = m_phyIndexes.find (PeekPointer (phy));
+  if (it == m_phyIndexes.end () || m_phys[it->second].listening == listening)
+    {
+      return;
+    }
+
+  UpdatePhyRecords ();
+
+  uint32_t j = it->second;
+  PhyRecord &record = m_phys[j];
+  record.listening = listening;
+  auto position = std::lower_bound (m_listeningPhys.begin (), m_listeningPhys.end (), j);
+  if (!listening)
+    {
+      record.missedSince = m_nextTransmissionId;
+      m_listeningPhys.erase (position);
+      return;
+    }
+  m_listeningPhys.insert (position, j);
+
+  // Deliver the transmissions the PHY was not notified of, and that did not
+  // reach it yet. Since sequence numbers in the log are consecutive, they
+  // start at a known position.
+  std::size_t first = 0;
+  if (!m_transmissionLog.empty () && record.missedSince > m_transmissionLog.front ().id)
+    {
+      first = record.missedSince - m_transmissionLog.front ().id;
+    }
+  for (auto transmission = m_transmissionLog.begin () + std::min (first, m_transmissionLog.size ());
+       transmission != m_transmissionLog.end (); transmission++)
+    {
+      if (transmission->sender == phy
+          || !IsInRange (transmission->senderPosition, record.mobility))
+        {
+          continue;
+        }
+
+      Time delay;
+      double rxPowerDbm;
+      GetLinkBudget (transmission->sender, transmission->senderMobility, phy, record.mobility,
+                     transmission->txPowerDbm, delay, rxPowerDbm);
+      Time startTime = transmission->startTime + delay;
+      if (startTime < Simulator::Now ())
+        {
+          continue;
+        }
+
+      NS_LOG_INFO ("Delivering a transmission the PHY was not notified of");
+
+      LoraChannelParameters parameters;
+      parameters.rxPowerDbm = rxPowerDbm;
+      parameters.sf = transmission->sf;
+      parameters.duration = transmission->duration;
+      parameters.frequencyMHz = transmission->frequencyMHz;
+      Simulator::ScheduleWithContext (record.nodeId, startTime - Simulator::Now (),
+                                      &LoraChannel::Receive, this, j, transmission->packet,
+                                      parameters);
+    }
+}
+
+void
+LoraChannel::InvalidatePhyRecords (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_phyRecordsOutdated = true;
+  m_gridOutdated = true;
+}
+
+void
+LoraChannel::UpdatePhyRecords (void) const
+{
+  if (!m_phyRecordsOutdated)
+    {
+      return;
+    }
+
+  NS_LOG_FUNCTION (this);
+
+  m_listeningPhys.clear ();
+  for (uint32_t j = 0; j < m_phys.size (); j++)
+    {
+      PhyRecord &record = m_phys[j];
+      record.mobility = record.phy->GetMobility ();
+      record.device = record.phy->GetDevice ();
+      record.nodeId = 0;
+      record.systemId = 0;
+      if (record.device != 0 && record.device->GetNode () != 0)
+        {
+          record.nodeId = record.device->GetNode ()->GetId ();
+          record.systemId = record.device->GetNode ()->GetSystemId ();
+        }
+      record.isGateway = DynamicCast<GatewayLoraPhy> (record.phy) != 0;
+
+      if (record.listening)
+        {
+          m_listeningPhys.push_back (j);
+        }
+    }
+
+  m_phyRecordsOutdated = false;
 }
 
 void
@@ -113,71 +471,421 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
   NS_LOG_FUNCTION (this << sender << packet << txPowerDbm << txParams <<
                    duration << frequencyMHz);
 
+  UpdatePhyRecords ();
+
   // Get the mobility model of the sender
-  Ptr<MobilityModel> senderMobility = sender->GetMobility ()->GetObject<MobilityModel> ();
+  Ptr<MobilityModel> senderMobility = sender->GetMobility ();
 
   NS_ASSERT (senderMobility != 0);     // Make sure it's available
 
-  NS_LOG_INFO ("Starting cycle over all " << m_phyList.size () << " PHYs");
   NS_LOG_INFO ("Sender mobility: " << senderMobility->GetPosition ());
 
+  if (m_sharedInterference)
+    {
+#ifdef NS3_MPI
+      NS_ABORT_MSG_IF (MpiInterface::IsEnabled (),
+                       "SharedInterference is not supported in distributed simulations");
+#endif
+
+      // Forget the transmissions that cannot be arriving anywhere anymore.
+      // Since the log is sorted by start time, they are at its beginning.
+      while (!m_transmissionLog.empty ()
+             && m_transmissionLog.front ().startTime + m_transmissionLog.front ().duration
+             + Seconds (1) < Simulator::Now ())
+        {
+          m_transmissionLog.pop_front ();
+        }
+
+      LoggedTransmission transmission;
+      transmission.sender = sender;
+      transmission.senderMobility = senderMobility;
+      transmission.senderPosition = senderMobility->GetPosition ();
+      transmission.packet = packet;
+      transmission.txPowerDbm = txPowerDbm;
+      transmission.sf = txParams.sf;
+      transmission.startTime = Simulator::Now ();
+      transmission.duration = duration;
+      transmission.frequencyMHz = frequencyMHz;
+      transmission.id = m_nextTransmissionId++;
+      m_transmissionLog.push_back (transmission);
+    }
+
+  if (m_maxRange > 0)
+    {
+      // Only cycle over the PHYs that are close enough to the sender
+      std::vector<uint32_t> receivers =
+        GetPhysInRange (senderMobility->GetPosition ());
+
+      NS_LOG_INFO ("Starting cycle over " << receivers.size () << " of " <<
+                   m_phys.size () << " PHYs");
+
+      std::vector<uint32_t>::const_iterator i;
+      for (i = receivers.begin (); i != receivers.end (); i++)
+        {
+          // Do not deliver to the sender, nor to PHYs that are not listening
+          if (sender != m_phys[*i].phy
+              && (!m_sharedInterference || m_phys[*i].listening))
+            {
+              Deliver (*i, sender, senderMobility, packet, txPowerDbm, txParams,
+                       duration, frequencyMHz);
+            }
+        }
+      return;
+    }
+
+  if (m_sharedInterference)
+    {
+      NS_LOG_INFO ("Starting cycle over " << m_listeningPhys.size () << " of " <<
+                   m_phys.size () << " PHYs, which are listening");
+
+      // Only cycle over the registry of listening PHYs
+      for (uint32_t k = 0; k < m_listeningPhys.size (); k++)
+        {
+          uint32_t j = m_listeningPhys[k];
+          if (sender != m_phys[j].phy)
+            {
+              Deliver (j, sender, senderMobility, packet, txPowerDbm, txParams,
+                       duration, frequencyMHz);
+            }
+        }
+      return;
+    }
+
+  NS_LOG_INFO ("Starting cycle over all " << m_phys.size () << " PHYs");
+
   // Cycle over all registered PHYs
-  uint32_t j = 0;
-  std::vector<Ptr<LoraPhy> >::const_iterator i;
-  for (i = m_phyList.begin (); i != m_phyList.end (); i++, j++)
+  for (uint32_t j = 0; j < m_phys.size (); j++)
     {
-      // Do not deliver to the sender (*i is the current PHY)
-      if (sender != (*i))
+      // Do not deliver to the sender
+      if (sender != m_phys[j].phy)
         {
-          // Get the receiver's mobility model
-          Ptr<MobilityModel> receiverMobility = (*i)->GetMobility ()->
-            GetObject<MobilityModel> ();
+          Deliver (j, sender, senderMobility, packet, txPowerDbm, txParams, duration,
+                   frequencyMHz);
+        }
+    }
+}
+
+void
+LoraChannel::Deliver (uint32_t j, Ptr<LoraPhy> sender,
+                      Ptr<MobilityModel> senderMobility,
+                      Ptr<Packet> packet, double txPowerDbm,
+                      LoraTxParameters txParams, Time duration,
+                      double frequencyMHz) const
+{
+  NS_LOG_FUNCTION (this << j << packet);
 
-          NS_LOG_INFO ("Receiver mobility: " <<
-                       receiverMobility->GetPosition ());
+  const PhyRecord &receiver = m_phys[j];
+  Time delay;
+  double rxPowerDbm;
+  GetLinkBudget (sender, senderMobility, receiver.phy, receiver.mobility, txPowerDbm, delay,
+                 rxPowerDbm);
 
-          // Compute delay using the delay model
-          Time delay = m_delay->GetDelay (senderMobility, receiverMobility);
+  // The id of the destination node is used as context, or 0 if the PHY has
+  // no net device
+  uint32_t dstNode = receiver.nodeId;
+  NS_LOG_DEBUG ("dstNode = " << dstNode);
 
-          // Compute received power using the loss model
-          double rxPowerDbm = GetRxPower (txPowerDbm, senderMobility,
-                                          receiverMobility);
+  // Create the parameters object based on the calculations above
+  LoraChannelParameters parameters;
+  parameters.rxPowerDbm = rxPowerDbm;
+  parameters.sf = txParams.sf;
+  parameters.duration = duration;
+  parameters.frequencyMHz = frequencyMHz;
+
+#ifdef NS3_MPI
+  // In distributed simulations, PHYs owned by other ranks are notified
+  // through MPI
+  if (MpiInterface::IsEnabled () && receiver.device != 0
+      && receiver.systemId != MpiInterface::GetSystemId ())
+    {
+      NS_LOG_INFO ("Sending the packet to rank " << receiver.systemId);
+
+      LoraChannelTag tag;
+      tag.m_phyIndex = j;
+      tag.m_parameters = parameters;
+      Ptr<Packet> remotePacket = packet->Copy ();
+      remotePacket->AddPacketTag (tag);
+      MpiInterface::SendPacket (remotePacket, Simulator::Now () + delay, dstNode,
+                                receiver.device->GetIfIndex ());
+
+      // Fire the trace source for sent packet
+      m_packetSent (packet);
+      return;
+    }
+#endif
 
-          NS_LOG_DEBUG ("Propagation: txPower=" << txPowerDbm <<
-                        "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
-                        "distance=" << senderMobility->GetDistanceFrom (receiverMobility) <<
-                        "m, delay=" << delay);
+  // Schedule the receive event
+  NS_LOG_INFO ("Scheduling reception of the packet");
+  Simulator::ScheduleWithContext (dstNode, delay, &LoraChannel::Receive,
+                                  this, j, packet, parameters);
 
-          // Get the id of the destination PHY to correctly format the context
-          Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice ();
-          uint32_t dstNode = 0;
-          if (dstNetDevice != 0)
+  // Fire the trace source for sent packet
+  m_packetSent (packet);
+}
+
+void
+LoraChannel::GetLinkBudget (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+                            Ptr<LoraPhy> receiver, Ptr<MobilityModel> receiverMobility,
+                            double txPowerDbm, Time &delay, double &rxPowerDbm) const
+{
+  LinkBudgetKey key (PeekPointer (sender), PeekPointer (receiver), txPowerDbm);
+  auto cached = m_linkBudgets.end ();
+  if (m_cacheLinkBudget)
+    {
+      cached = m_linkBudgets.find (key);
+    }
+
+  // Entries computed before one of the PHYs was given another mobility model
+  // are not valid anymore
+  if (cached != m_linkBudgets.end ()
+      && (cached->second.senderMobility != PeekPointer (senderMobility)
+          || cached->second.receiverMobility != PeekPointer (receiverMobility)))
+    {
+      m_linkBudgets.erase (cached);
+      cached = m_linkBudgets.end ();
+    }
+
+  if (cached != m_linkBudgets.end ())
+    {
+      NS_LOG_INFO ("Using cached link budget");
+
+      delay = cached->second.delay;
+      rxPowerDbm = cached->second.rxPowerDbm;
+    }
+  else
+    {
+      NS_LOG_INFO ("Receiver mobility: " <<
+                   receiverMobility->GetPosition ());
+
+      // Compute delay using the delay model
+      delay = m_delay->GetDelay (senderMobility, receiverMobility);
+
+      // Compute received power using the loss model
+      rxPowerDbm = GetRxPower (txPowerDbm, senderMobility, receiverMobility);
+
+      NS_LOG_DEBUG ("Propagation: txPower=" << txPowerDbm <<
+                    "dbm, rxPower=" << rxPowerDbm << "dbm, " <<
+                    "distance=" << senderMobility->GetDistanceFrom (receiverMobility) <<
+                    "m, delay=" << delay);
+
+      // The link budget of a moving PHY changes between course changes, so
+      // it can't be cached
+      if (m_cacheLinkBudget && !IsMoving (senderMobility) && !IsMoving (receiverMobility))
+        {
+          // Make sure the entry is invalidated if any of the two changes
+          // course
+          TrackMobility (senderMobility);
+          TrackMobility (receiverMobility);
+          m_mobilityLinkBudgets[PeekPointer (senderMobility)].insert (key);
+          m_mobilityLinkBudgets[PeekPointer (receiverMobility)].insert (key);
+
+          LinkBudget budget;
+          budget.rxPowerDbm = rxPowerDbm;
+          budget.delay = delay;
+          budget.senderMobility = PeekPointer (senderMobility);
+          budget.receiverMobility = PeekPointer (receiverMobility);
+          m_linkBudgets[key] = budget;
+        }
+    }
+}
+
+std::pair<int64_t, int64_t>
+LoraChannel::GetCell (Vector position) const
+{
+  return std::make_pair (int64_t (std::floor (position.x / m_gridCellSize)),
+                         int64_t (std::floor (position.y / m_gridCellSize)));
+}
+
+void
+LoraChannel::UpdateGrid (void) const
+{
+  if (!m_gridOutdated && m_gridCellSize == m_maxRange)
+    {
+      return;
+    }
+
+  NS_LOG_FUNCTION (this);
+
+  m_grid.clear ();
+  m_movingPhys.clear ();
+  m_mobilityPhys.clear ();
+  m_gridCellSize = m_maxRange;
+
+  UpdatePhyRecords ();
+  m_gridPositions.assign (m_phys.size (), Vector ());
+  for (uint32_t j = 0; j < m_phys.size (); j++)
+    {
+      Ptr<MobilityModel> mobility = m_phys[j].mobility;
+
+      // Make sure we are notified when this PHY moves
+      TrackMobility (mobility);
+      m_mobilityPhys[PeekPointer (mobility)].push_back (j);
+
+      AddToGrid (j);
+    }
+
+  m_gridOutdated = false;
+}
+
+void
+LoraChannel::AddToGrid (uint32_t j) const
+{
+  Ptr<MobilityModel> mobility = m_phys[j].mobility;
+
+  // The position of a moving PHY changes between course changes, so it can't
+  // be assigned a cell
+  if (IsMoving (mobility))
+    {
+      m_movingPhys.insert (j);
+      return;
+    }
+
+  Vector position = mobility->GetPosition ();
+  m_gridPositions[j] = position;
+  m_grid[GetCell (position)].push_back (j);
+}
+
+void
+LoraChannel::RemoveFromGrid (uint32_t j) const
+{
+  if (m_movingPhys.erase (j) > 0)
+    {
+      return;
+    }
+
+  auto cell = m_grid.find (GetCell (m_gridPositions[j]));
+  NS_ASSERT (cell != m_grid.end ());
+  cell->second.erase (std::find (cell->second.begin (), cell->second.end (), j));
+  if (cell->second.empty ())
+    {
+      m_grid.erase (cell);
+    }
+}
+
+std::vector<uint32_t>
+LoraChannel::GetPhysInRange (Vector position) const
+{
+  NS_LOG_FUNCTION (this << position);
+
+  UpdateGrid ();
+
+  // Since cells are as large as the maximum range, only the cell of the
+  // transmitter and its neighbors can contain PHYs within range
+  std::vector<uint32_t> phys;
+  std::pair<int64_t, int64_t> cell = GetCell (position);
+  for (int64_t dx = -1; dx <= 1; dx++)
+    {
+      for (int64_t dy = -1; dy <= 1; dy++)
+        {
+          auto it = m_grid.find (std::make_pair (cell.first + dx,
+                                                 cell.second + dy));
+          if (it == m_grid.end ())
             {
-              NS_LOG_INFO ("Getting node index from NetDevice, since it exists");
-              dstNode = dstNetDevice->GetNode ()->GetId ();
-              NS_LOG_DEBUG ("dstNode = " << dstNode);
+              continue;
             }
-          else
+          for (auto &j : it->second)
             {
-              NS_LOG_INFO ("No net device connected to the PHY, using context 0");
+              if (CalculateDistance (m_gridPositions[j], position) <= m_maxRange)
+                {
+                  phys.push_back (j);
+                }
             }
+        }
+    }
+
+  // Moving PHYs are checked against their current position
+  for (auto &j : m_movingPhys)
+    {
+      if (CalculateDistance (m_phys[j].mobility->GetPosition (), position) <= m_maxRange)
+        {
+          phys.push_back (j);
+        }
+    }
 
-          // Create the parameters object based on the calculations above
-          LoraChannelParameters parameters;
-          parameters.rxPowerDbm = rxPowerDbm;
-          parameters.sf = txParams.sf;
-          parameters.duration = duration;
-          parameters.frequencyMHz = frequencyMHz;
+  // Keep the same delivery order we would have without culling
+  std::sort (phys.begin (), phys.end ());
+
+  return phys;
+}
 
-          // Schedule the receive event
-          NS_LOG_INFO ("Scheduling reception of the packet");
-          Simulator::ScheduleWithContext (dstNode, delay, &LoraChannel::Receive,
-                                          this, j, packet, parameters);
+bool
+LoraChannel::IsInRange (Vector position, Ptr<MobilityModel> receiverMobility) const
+{
+  return m_maxRange <= 0
+         || CalculateDistance (receiverMobility->GetPosition (), position) <= m_maxRange;
+}
 
-          // Fire the trace source for sent packet
-          m_packetSent (packet);
+void
+LoraChannel::TrackMobility (Ptr<MobilityModel> mobility) const
+{
+  if (m_trackedMobilities.insert (mobility).second)
+    {
+      mobility->TraceConnectWithoutContext
+        ("CourseChange", MakeCallback (&LoraChannel::CourseChanged, this));
+    }
+}
+
+void
+LoraChannel::CourseChanged (Ptr<const MobilityModel> mobility) const
+{
+  NS_LOG_FUNCTION (this << mobility);
+
+  // Move the PHYs using this mobility model to their new cell. If the grid
+  // is going to be rebuilt anyway, there's no need.
+  auto phys = m_mobilityPhys.find (PeekPointer (mobility));
+  if (!m_gridOutdated && phys != m_mobilityPhys.end ())
+    {
+      for (auto &j : phys->second)
+        {
+          RemoveFromGrid (j);
+          AddToGrid (j);
         }
     }
+
+  // Invalidate the link budgets this mobility model is involved in
+  ForgetLinkBudgets (PeekPointer (mobility), 0);
+}
+
+void
+LoraChannel::ForgetLinkBudgets (const MobilityModel *mobility, const LoraPhy *phy) const
+{
+  auto keys = m_mobilityLinkBudgets.find (mobility);
+  if (keys == m_mobilityLinkBudgets.end ())
+    {
+      return;
+    }
+
+  for (auto key = keys->second.begin (); key != keys->second.end ();)
+    {
+      if (phy != 0 && std::get<0> (*key) != phy && std::get<1> (*key) != phy)
+        {
+          key++;
+          continue;
+        }
+
+      // The entry may have been invalidated through the other mobility model
+      // and computed again since, without this one
+      auto cached = m_linkBudgets.find (*key);
+      if (cached != m_linkBudgets.end ()
+          && (cached->second.senderMobility == mobility
+              || cached->second.receiverMobility == mobility))
+        {
+          m_linkBudgets.erase (cached);
+        }
+      key = keys->second.erase (key);
+    }
+
+  if (keys->second.empty ())
+    {
+      m_mobilityLinkBudgets.erase (keys);
+    }
+}
+
+bool
+LoraChannel::IsMoving (Ptr<MobilityModel> mobility)
+{
+  Vector velocity = mobility->GetVelocity ();
+  return velocity.x != 0 || velocity.y != 0 || velocity.z != 0;
 }
 
 void
@@ -187,10 +895,111 @@ LoraChannel::Receive (uint32_t i, Ptr<Packet> packet,
   NS_LOG_FUNCTION (this << i << packet << parameters);
 
   // Call the appropriate PHY instance to let it begin reception
-  m_phyList[i]->StartReceive (packet, parameters.rxPowerDbm, parameters.sf,
+  m_phys[i].phy->StartReceive (packet, parameters.rxPowerDbm, parameters.sf,
                               parameters.duration, parameters.frequencyMHz);
 }
 
+#ifdef NS3_MPI
+void
+LoraChannel::ReceiveRemote (Ptr<Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  LoraChannelTag tag;
+  bool found = packet->RemovePacketTag (tag);
+  NS_ASSERT (found);
+
+  Receive (tag.m_phyIndex, packet, tag.m_parameters);
+}
+#endif
+
+void
+LoraChannel::EnableRemoteReception (Ptr<NetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+
+#ifdef NS3_MPI
+  Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver> ();
+  receiver->SetReceiveCallback (MakeCallback (&LoraChannel::ReceiveRemote, this));
+  device->AggregateObject (receiver);
+#else
+  NS_FATAL_ERROR ("Remote reception needs ns-3 to be configured with --enable-mpi");
+#endif
+}
+
+Time
+LoraChannel::GetLookAhead (double guardBand) const
+{
+  NS_LOG_FUNCTION (this << guardBand);
+
+  NS_ABORT_MSG_IF (guardBand <= 0, "The guard band between partitions must be positive");
+
+  // Find the extension of each partition along the x axis
+  std::map<uint32_t, std::pair<double, double> > extensions;
+  UpdatePhyRecords ();
+  for (auto &record : m_phys)
+    {
+      if (record.device == 0)
+        {
+          continue;
+        }
+      uint32_t systemId = record.systemId;
+      double x = record.mobility->GetPosition ().x;
+
+      auto it = extensions.find (systemId);
+      if (it == extensions.end ())
+        {
+          extensions[systemId] = std::make_pair (x, x);
+        }
+      else
+        {
+          it->second.first = std::min (it->second.first, x);
+          it->second.second = std::max (it->second.second, x);
+        }
+    }
+
+  if (extensions.size () < 2)
+    {
+      return Time::Max ();
+    }
+
+  // Sort partitions by their leftmost point, and make sure that consecutive
+  // ones are at least a guard band apart. Any PHY closer to another partition
+  // than that would receive transmissions before the lookahead allows.
+  std::vector<std::pair<double, double> > sorted;
+  for (auto &extension : extensions)
+    {
+      sorted.push_back (extension.second);
+    }
+  std::sort (sorted.begin (), sorted.end ());
+
+  for (uint32_t k = 1; k < sorted.size (); k++)
+    {
+      double gap = sorted[k].first - sorted[k - 1].second;
+      NS_ABORT_MSG_IF (gap < guardBand,
+                       "Partitions are " << gap << " m apart along the x axis, less than "
+                       "the " << guardBand << " m guard band. All nodes must be placed "
+                       "in strips along the x axis, outside of the guard bands (see "
+                       "LoraHelper::CreatePartitionedNodes), gateways included");
+    }
+
+  Ptr<ConstantPositionMobilityModel> a =
+    CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b =
+    CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+  b->SetPosition (Vector (guardBand, 0, 0));
+
+  // Only the propagation delay can be used: receivers start tracking a
+  // signal as soon as it arrives, not at the end of its preamble
+  Time lookAhead = m_delay->GetDelay (a, b);
+
+  NS_LOG_DEBUG ("Guard band between partitions: " << guardBand << " m, lookahead: "
+                << lookAhead);
+
+  return lookAhead;
+}
+
 double
 LoraChannel::GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                          Ptr<MobilityModel> receiverMobility) const
@@ -198,6 +1007,52 @@ LoraChannel::GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
   return m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
 }
 
+double
+LoraChannel::GetMaxUsefulRange (Ptr<PropagationLossModel> loss,
+                                double txPowerDbm, double sensitivityDbm,
+                                double marginDb)
+{
+  NS_LOG_FUNCTION (loss << txPowerDbm << sensitivityDbm << marginDb);
+
+  Ptr<ConstantPositionMobilityModel> a =
+    CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b =
+    CreateObject<ConstantPositionMobilityModel> ();
+  a->SetPosition (Vector (0, 0, 0));
+
+  double threshold = sensitivityDbm - marginDb;
+
+  // Find a distance at which the signal is surely below the threshold
+  double low = 1;
+  double high = 1;
+  do
+    {
+      low = high;
+      high *= 2;
+      b->SetPosition (Vector (high, 0, 0));
+    }
+  while (loss->CalcRxPower (txPowerDbm, a, b) >= threshold && high < 1e8);
+
+  // Bisect to find the distance at which the threshold is crossed
+  while (high - low > 1)
+    {
+      double middle = (low + high) / 2;
+      b->SetPosition (Vector (middle, 0, 0));
+      if (loss->CalcRxPower (txPowerDbm, a, b) >= threshold)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+
+  NS_LOG_DEBUG ("Maximum useful range: " << high << " m");
+
+  return high;
+}
+
 std::ostream &operator << (std::ostream &os, const LoraChannelParameters &params)
 {
   os << "(rxPowerDbm: " << params.rxPowerDbm << ", SF: " << unsigned(params.sf) <<
@@ -25,6 +25,11 @@
 #define LORA_CHANNEL_H
 
 #include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <tuple>
 #include "ns3/lora-phy.h"
 #include "ns3/mobility-model.h"
 #include "ns3/channel.h"
@@ -61,6 +66,17 @@ struct LoraChannelParameters
  */
 std::ostream &operator << (std::ostream &os, const LoraChannelParameters &params);
 
+/**
+ * A transmission that is arriving at a PHY, as reconstructed by a
+ * LoraChannel from its log of recent transmissions.
+ */
+struct LoraImpingingTransmission
+{
+  Ptr<Packet> packet;     //!< The packet being transmitted.
+  Time startTime;     //!< The time the transmission started arriving at the PHY.
+  LoraChannelParameters parameters;     //!< The transmission, as seen by the PHY.
+};
+
 /**
  * The class that delivers packets among PHY layers.
  *
@@ -153,6 +169,130 @@ public:
   double GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                      Ptr<MobilityModel> receiverMobility) const;
 
+  /**
+    * Compute the maximum useful range of a transmission.
+    *
+    * This method looks for the distance at which a transmission with the
+    * specified power is received, according to the given loss model, at a
+    * power that is marginDb below the sensitivity. The result can be used to
+    * set this channel's MaxRange attribute. Since LoraChannel's own loss model
+    * is typically a chain of models with random components, callers should
+    * pass the deterministic part of the chain (for example, the
+    * LogDistancePropagationLossModel) and account for shadowing and building
+    * losses through the margin.
+    *
+    * \param loss The loss model to use for the computation.
+    * \param txPowerDbm The highest transmission power in use, in dBm.
+    * \param sensitivityDbm The lowest sensitivity among receivers, in dBm.
+    * \param marginDb The margin to add below the sensitivity, in dB.
+    * \return The distance in meters beyond which transmissions are certainly
+    * useless.
+    */
+  static double GetMaxUsefulRange (Ptr<PropagationLossModel> loss,
+                                   double txPowerDbm, double sensitivityDbm,
+                                   double marginDb);
+
+  /**
+    * Make a device able to receive transmissions sent by PHYs that live on
+    * other ranks of a distributed simulation.
+    *
+    * In distributed simulations, transmissions towards PHYs whose node has a
+    * system id different from the local one are sent to the rank owning that
+    * node via MpiInterface, instead of being scheduled locally. This method
+    * aggregates an MpiReceiver to a local device, so that these transmissions
+    * are handed to this channel when they arrive. All ranks must build the
+    * same topology, so that PHYs have the same index on every rank.
+    *
+    * This method aborts if ns-3 was not configured with MPI support.
+    *
+    * \param device The local device to enable remote reception on.
+    */
+  void EnableRemoteReception (Ptr<NetDevice> device);
+
+  /**
+    * Compute the lookahead that can be used by a distributed simulation.
+    *
+    * The lookahead is the propagation delay across the guard band, i.e., the
+    * minimum distance along the x axis between PHYs belonging to different
+    * system ids. This assumes that nodes were partitioned in strips along the
+    * x axis, separated by empty guard bands, for example through
+    * LoraHelper::CreatePartitionedNodes. The method aborts if two strips are
+    * closer than the guard band, for instance because some nodes were placed
+    * inside it.
+    *
+    * The time on air of the preamble is not added to the lookahead, even
+    * though a receiver can't lock on a packet before its preamble is over:
+    * the receiving PHY accounts the incoming signal as interference, and
+    * decides whether to lock on it, as soon as it starts arriving. A remote
+    * transmission must therefore be delivered within one propagation delay
+    * from its start, or it would be missing from the interference seen by
+    * packets arriving at the same time.
+    *
+    * \param guardBand The minimum distance between strips, in meters.
+    * \return The lookahead, or Time::Max () if all PHYs are on the same
+    * system.
+    */
+  Time GetLookAhead (double guardBand) const;
+
+  /**
+    * Make the channel look up the mobility model, net device and node of its
+    * PHYs again before the next transmission.
+    *
+    * The channel keeps a record of these for each PHY, which is captured at
+    * the first transmission after a PHY is added, since the helpers link PHYs
+    * to their device and node after adding them. PHYs call this method when
+    * their mobility model or device change.
+    */
+  void InvalidatePhyRecords (void);
+
+  /**
+    * Whether end device PHYs that are not listening leave the interference of
+    * the transmissions they are not notified of to this channel, as set by the
+    * SharedInterference attribute.
+    *
+    * \return True if the channel keeps a log of recent transmissions.
+    */
+  bool IsInterferenceShared (void) const;
+
+  /**
+    * Get the transmissions that are arriving at a PHY at the current time,
+    * from the log of recent transmissions.
+    *
+    * This is used by end device PHYs that start listening, to rebuild the
+    * interference they did not keep track of while they were not listening.
+    * Only the transmissions that started arriving after the PHY stopped
+    * listening and before the current time are included: the PHY already
+    * knows about the earlier ones, and is notified of the later ones as
+    * usual. Transmissions sent from beyond MaxRange are left out, as in Send.
+    *
+    * \param receiver The PHY to compute the transmissions for.
+    * \param since The time the PHY stopped listening.
+    * \return The transmissions, in the order they were sent.
+    */
+  std::vector<LoraImpingingTransmission>
+  GetImpingingTransmissions (Ptr<LoraPhy> receiver, Time since) const;
+
+  /**
+    * Tell the channel whether an end device PHY is listening, i.e., whether
+    * it needs to be notified of transmissions.
+    *
+    * When SharedInterference is enabled, the channel keeps a registry of the
+    * listening PHYs, and transmissions are only delivered to them and to
+    * gateways. End device PHYs that are sleeping or transmitting are not
+    * notified at all, and take the interference of the transmissions they
+    * missed from the log when they switch to STANDBY. Transmissions they
+    * missed that did not reach them yet are delivered as usual when they
+    * start listening again. PHYs call this method on their state
+    * transitions.
+    *
+    * \param phy The end device PHY.
+    * \param listening Whether the PHY is listening.
+    */
+  void SetListening (Ptr<LoraPhy> phy, bool listening);
+
+protected:
+  virtual void DoDispose (void);
+
 private:
   /**
     * Private method that is scheduled by LoraChannel's Send method to happen
@@ -168,11 +308,166 @@ private:
   void Receive (uint32_t i, Ptr<Packet> packet,
                 LoraChannelParameters parameters) const;
 
+#ifdef NS3_MPI
+  /**
+    * Start reception of a transmission sent by a PHY on another rank.
+    *
+    * \param packet The packet, carrying the channel parameters in a tag.
+    */
+  void ReceiveRemote (Ptr<Packet> packet);
+#endif
+
+  /**
+    * Compute the propagation towards a single PHY and schedule its reception.
+    *
+    * \param j The index of the receiving phy in m_phys.
+    * \param sender The phy that is sending the packet.
+    * \param senderMobility The mobility model of the sender.
+    * \param packet The packet that is being sent.
+    * \param txPowerDbm The power of the transmission.
+    * \param txParams The set of parameters that are used by the transmitter.
+    * \param duration The on-air duration of this packet.
+    * \param frequencyMHz The frequency this transmission will happen at.
+    */
+  void Deliver (uint32_t j, Ptr<LoraPhy> sender,
+                Ptr<MobilityModel> senderMobility,
+                Ptr<Packet> packet, double txPowerDbm,
+                LoraTxParameters txParams, Time duration,
+                double frequencyMHz) const;
+
+  /**
+    * Compute the received power and the delay of a transmission from a PHY to
+    * another, or take them from the link budget cache if it's enabled.
+    *
+    * \param sender The phy that is sending.
+    * \param senderMobility The mobility model of the sender.
+    * \param receiver The phy that is receiving.
+    * \param receiverMobility The mobility model of the receiver.
+    * \param txPowerDbm The power of the transmission.
+    * \param delay The propagation delay.
+    * \param rxPowerDbm The received power.
+    */
+  void GetLinkBudget (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+                      Ptr<LoraPhy> receiver, Ptr<MobilityModel> receiverMobility,
+                      double txPowerDbm, Time &delay, double &rxPowerDbm) const;
+
+  /**
+    * Capture the records of the PHYs, if they are out of date.
+    */
+  void UpdatePhyRecords (void) const;
+
+  /**
+    * Rebuild the spatial index of PHY positions, if it's out of date.
+    */
+  void UpdateGrid (void) const;
+
+  /**
+    * Insert a PHY in the spatial index, based on its current position and
+    * velocity.
+    *
+    * \param j The index of the PHY in m_phys.
+    */
+  void AddToGrid (uint32_t j) const;
+
+  /**
+    * Remove a PHY from the spatial index.
+    *
+    * \param j The index of the PHY in m_phys.
+    */
+  void RemoveFromGrid (uint32_t j) const;
+
+  /**
+    * Get the indexes of the PHYs that are within m_maxRange of a position.
+    *
+    * \param position The position of the transmitter.
+    * \return The indexes in m_phys, in ascending order.
+    */
+  std::vector<uint32_t> GetPhysInRange (Vector position) const;
+
+  /**
+    * Check whether a PHY is within m_maxRange of a transmitter, applying to
+    * logged transmissions the same culling Send applies.
+    *
+    * \param position The position of the transmitter.
+    * \param receiverMobility The mobility model of the PHY.
+    * \return True if culling is disabled or the PHY is within range.
+    */
+  bool IsInRange (Vector position, Ptr<MobilityModel> receiverMobility) const;
+
+  /**
+    * Connect to the CourseChange trace source of a mobility model, if this
+    * wasn't done already.
+    *
+    * \param mobility The mobility model to keep track of.
+    */
+  void TrackMobility (Ptr<MobilityModel> mobility) const;
+
   /**
-    * The vector containing the PHYs that are currently connected to the
-    * channel.
+    * Callback for when a PHY's mobility model changes course.
+    *
+    * \param mobility The mobility model that changed course.
     */
-  std::vector<Ptr<LoraPhy> > m_phyList;
+  void CourseChanged (Ptr<const MobilityModel> mobility) const;
+
+  /**
+    * Forget the cached link budgets that were computed with a mobility model.
+    *
+    * \param mobility The mobility model.
+    * \param phy If not 0, only forget the link budgets involving this PHY.
+    */
+  void ForgetLinkBudgets (const MobilityModel *mobility, const LoraPhy *phy) const;
+
+  /**
+    * Check whether a mobility model is currently moving.
+    *
+    * \param mobility The mobility model.
+    * \return Whether its velocity is not zero.
+    */
+  static bool IsMoving (Ptr<MobilityModel> mobility);
+
+  /**
+    * Get the grid cell a position falls into.
+    */
+  std::pair<int64_t, int64_t> GetCell (Vector position) const;
+
+  /**
+   * What the channel needs to know about a PHY to deliver transmissions to
+   * it, so that it is not looked up through object aggregation every time.
+   */
+  struct PhyRecord
+  {
+    Ptr<LoraPhy> phy;     //!< The PHY.
+    Ptr<MobilityModel> mobility;     //!< The mobility model of the PHY.
+    Ptr<NetDevice> device;     //!< The net device of the PHY, if any.
+    uint32_t nodeId;     //!< The id of the node of the device, or 0.
+    uint32_t systemId;     //!< The system id of the node of the device, or 0.
+    bool isGateway;     //!< Whether the PHY is a GatewayLoraPhy.
+    bool listening;     //!< Whether the PHY needs to be notified.
+    uint64_t missedSince;     //!< The first transmission it was not notified of.
+  };
+
+  /**
+    * The records of the PHYs that are currently connected to the channel, in
+    * the order they were added.
+    */
+  mutable std::vector<PhyRecord> m_phys;
+
+  /**
+    * Whether the records in m_phys need to be captured again before their
+    * next use.
+    */
+  mutable bool m_phyRecordsOutdated;
+
+  /**
+    * The index in m_phys of each PHY.
+    */
+  std::unordered_map<const LoraPhy *, uint32_t> m_phyIndexes;
+
+  /**
+    * The indexes in m_phys of the PHYs that are listening, in ascending
+    * order. Only used when SharedInterference is enabled.
+    */
+  mutable std::vector<uint32_t> m_listeningPhys;
 
   /**
     * Pointer to the loss model.
@@ -192,6 +487,120 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_packetSent;
 
+  /**
+   * The distance beyond which receivers are not notified of a transmission.
+   *
+   * A value of 0 disables culling, and makes the channel deliver to all PHYs.
+   */
+  double m_maxRange;
+
+  /**
+   * Whether the spatial index needs to be rebuilt before its next use.
+   */
+  mutable bool m_gridOutdated;
+
+  /**
+   * The side of the grid cells, i.e., the value of m_maxRange the grid was
+   * built for.
+   */
+  mutable double m_gridCellSize;
+
+  /**
+   * Spatial index mapping each grid cell of side m_maxRange to the indexes of
+   * the PHYs that are inside it.
+   */
+  mutable std::map<std::pair<int64_t, int64_t>, std::vector<uint32_t> > m_grid;
+
+  /**
+   * The position of each PHY at the time it was inserted in the grid.
+   */
+  mutable std::vector<Vector> m_gridPositions;
+
+  /**
+   * The indexes in m_phys of the PHYs that were moving when they were last
+   * indexed. They are not in the grid, and their current position is checked
+   * at every transmission instead.
+   */
+  mutable std::set<uint32_t> m_movingPhys;
+
+  /**
+   * The indexes in m_phys of the PHYs using each mobility model, so that only
+   * they are moved in the grid when the model changes course.
+   */
+  mutable std::unordered_map<const MobilityModel *, std::vector<uint32_t> > m_mobilityPhys;
+
+  /**
+   * The mobility models whose CourseChange trace source we are connected to.
+   */
+  mutable std::set<Ptr<MobilityModel> > m_trackedMobilities;
+
+  /**
+   * A cached result of the propagation models for a sender/receiver pair.
+   */
+  struct LinkBudget
+  {
+    double rxPowerDbm;     //!< The received power.
+    Time delay;     //!< The propagation delay.
+    const MobilityModel *senderMobility;     //!< The sender's mobility model.
+    const MobilityModel *receiverMobility;     //!< The receiver's mobility model.
+  };
+
+  /**
+   * Whether to cache the output of the propagation models.
+   */
+  bool m_cacheLinkBudget;
+
+  /**
+   * The key of a cached link budget: sender PHY, receiver PHY and
+   * transmission power.
+   */
+  typedef std::tuple<const LoraPhy *, const LoraPhy *, double> LinkBudgetKey;
+
+  /**
+   * Cache of link budgets.
+   */
+  mutable std::map<LinkBudgetKey, LinkBudget> m_linkBudgets;
+
+  /**
+   * The keys of the cached link budgets each mobility model was involved in
+   * when they were computed, so that invalidating them doesn't require going
+   * through the whole cache.
+   */
+  mutable std::unordered_map<const MobilityModel *, std::set<LinkBudgetKey> >
+  m_mobilityLinkBudgets;
+
+  /**
+   * A transmission in the log of recent transmissions.
+   */
+  struct LoggedTransmission
+  {
+    Ptr<LoraPhy> sender;     //!< The phy that sent the packet.
+    Ptr<MobilityModel> senderMobility;     //!< The sender's mobility model.
+    Vector senderPosition;     //!< The sender's position when it sent.
+    Ptr<Packet> packet;     //!< The packet.
+    double txPowerDbm;     //!< The power of the transmission.
+    uint8_t sf;     //!< The spreading factor of the transmission.
+    Time startTime;     //!< The time the transmission started.
+    Time duration;     //!< The on-air duration of the packet.
+    double frequencyMHz;     //!< The frequency of the transmission.
+    uint64_t id;     //!< The sequence number of the transmission.
+  };
+
+  /**
+   * Whether to keep a log of recent transmissions, which end device PHYs use
+   * instead of keeping track of interference while they are not listening.
+   */
+  bool m_sharedInterference;
+
+  /**
+   * The transmissions sent in the recent past, in the order they were sent.
+   */
+  mutable std::deque<LoggedTransmission> m_transmissionLog;
+
+  /**
+   * The sequence number of the next logged transmission.
+   */
+  mutable uint64_t m_nextTransmissionId;
 };
 
 } /* namespace ns3 */
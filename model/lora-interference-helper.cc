@@ -22,6 +22,8 @@
 #include "ns3/log.h"
 #include "ns3/enum.h"
 #include <limits>
+#include <cmath>
+#include <algorithm>
 
 namespace ns3 {
 namespace lorawan {
@@ -39,18 +41,48 @@ LoraInterferenceHelper::Event::Event (Time duration, double rxPowerdBm, uint8_t
       m_endTime (m_startTime + duration),
       m_sf (spreadingFactor),
       m_rxPowerdBm (rxPowerdBm),
+      // Power [mW] = 10^(Power[dBm]/10)
+      // Power [W] = Power [mW] / 1000
+      m_rxPowerW (pow (10, rxPowerdBm / 10) / 1000),
       m_packet (packet),
       m_frequencyMHz (frequencyMHz)
 {
   // NS_LOG_FUNCTION_NOARGS ();
 }
 
+LoraInterferenceHelper::Event::Event (Time startTime, Time duration, double rxPowerdBm,
+                                      uint8_t spreadingFactor, Ptr<Packet> packet,
+                                      double frequencyMHz)
+    : m_startTime (startTime),
+      m_endTime (m_startTime + duration),
+      m_sf (spreadingFactor),
+      m_rxPowerdBm (rxPowerdBm),
+      m_rxPowerW (pow (10, rxPowerdBm / 10) / 1000),
+      m_packet (packet),
+      m_frequencyMHz (frequencyMHz)
+{
+}
+
 // Event Destructor
 LoraInterferenceHelper::Event::~Event ()
 {
   // NS_LOG_FUNCTION_NOARGS ();
 }
 
+void *
+LoraInterferenceHelper::Event::operator new (std::size_t size)
+{
+  NS_ASSERT (size == sizeof (LoraInterferenceHelper::Event));
+  return FreeListAllocator<LoraInterferenceHelper::Event> ().allocate (1);
+}
+
+void
+LoraInterferenceHelper::Event::operator delete (void *pointer)
+{
+  FreeListAllocator<LoraInterferenceHelper::Event> ().deallocate (
+      static_cast<LoraInterferenceHelper::Event *> (pointer), 1);
+}
+
 // Getters
 Time
 LoraInterferenceHelper::Event::GetStartTime (void) const
@@ -76,6 +108,12 @@ LoraInterferenceHelper::Event::GetRxPowerdBm (void) const
   return m_rxPowerdBm;
 }
 
+double
+LoraInterferenceHelper::Event::GetRxPowerW (void) const
+{
+  return m_rxPowerW;
+}
+
 uint8_t
 LoraInterferenceHelper::Event::GetSpreadingFactor (void) const
 {
@@ -170,7 +208,9 @@ LoraInterferenceHelper::GetTypeId (void)
   return tid;
 }
 
-  LoraInterferenceHelper::LoraInterferenceHelper () : m_collisionSnir(LoraInterferenceHelper::collisionSnirGoursaud)
+  LoraInterferenceHelper::LoraInterferenceHelper () : m_collisionSnir(LoraInterferenceHelper::collisionSnirGoursaud),
+    m_nEvents (0),
+    m_nextEventId (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -188,19 +228,28 @@ Ptr<LoraInterferenceHelper::Event>
 LoraInterferenceHelper::Add (Time duration, double rxPower, uint8_t spreadingFactor,
                              Ptr<Packet> packet, double frequencyMHz)
 {
+  return Add (Simulator::Now (), duration, rxPower, spreadingFactor, packet, frequencyMHz);
+}
 
-  NS_LOG_FUNCTION (this << duration.GetSeconds () << rxPower << unsigned(spreadingFactor) << packet
-                        << frequencyMHz);
+Ptr<LoraInterferenceHelper::Event>
+LoraInterferenceHelper::Add (Time startTime, Time duration, double rxPower,
+                             uint8_t spreadingFactor, Ptr<Packet> packet, double frequencyMHz)
+{
+
+  NS_LOG_FUNCTION (this << startTime.GetSeconds () << duration.GetSeconds () << rxPower
+                        << unsigned(spreadingFactor) << packet << frequencyMHz);
 
   // Create an event based on the parameters
   Ptr<LoraInterferenceHelper::Event> event = Create<LoraInterferenceHelper::Event> (
-      duration, rxPower, spreadingFactor, packet, frequencyMHz);
+      startTime, duration, rxPower, spreadingFactor, packet, frequencyMHz);
 
-  // Add the event to the list
-  m_events.push_back (event);
+  // Add the event to the bucket of its frequency
+  m_events[frequencyMHz].insert (
+      std::make_pair (event->GetEndTime (), std::make_pair (m_nextEventId++, event)));
+  m_nEvents++;
 
   // Clean the event list
-  if (m_events.size () > 100)
+  if (m_nEvents > 100)
     {
       CleanOldEvents ();
     }
@@ -213,24 +262,50 @@ LoraInterferenceHelper::CleanOldEvents (void)
 {
   NS_LOG_FUNCTION (this);
 
-  // Cycle the events, and clean up if an event is old.
-  for (auto it = m_events.begin (); it != m_events.end ();)
+  // Since buckets are sorted by end time, old events are at their beginning
+  for (auto &bucket : m_events)
     {
-      if ((*it)->GetEndTime () + oldEventThreshold < Simulator::Now ())
+      while (!bucket.second.empty () &&
+             bucket.second.begin ()->first + oldEventThreshold < Simulator::Now ())
         {
-          it = m_events.erase (it);
+          bucket.second.erase (bucket.second.begin ());
+          m_nEvents--;
         }
-      else
+    }
+}
+
+std::vector<Ptr<LoraInterferenceHelper::Event>>
+LoraInterferenceHelper::GetEventsInOrder (void) const
+{
+  std::vector<std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>>> events;
+  events.reserve (m_nEvents);
+  for (auto &bucket : m_events)
+    {
+      for (auto &element : bucket.second)
         {
-          it++;
+          events.push_back (element.second);
         }
     }
+  std::sort (events.begin (), events.end (),
+             [] (const std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>> &a,
+                 const std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>> &b) {
+               return a.first < b.first;
+             });
+
+  std::vector<Ptr<LoraInterferenceHelper::Event>> ordered;
+  ordered.reserve (events.size ());
+  for (auto &element : events)
+    {
+      ordered.push_back (element.second);
+    }
+  return ordered;
 }
 
 std::list<Ptr<LoraInterferenceHelper::Event>>
 LoraInterferenceHelper::GetInterferers ()
 {
-  return m_events;
+  std::vector<Ptr<LoraInterferenceHelper::Event>> events = GetEventsInOrder ();
+  return std::list<Ptr<LoraInterferenceHelper::Event>> (events.begin (), events.end ());
 }
 
 void
@@ -240,9 +315,9 @@ LoraInterferenceHelper::PrintEvents (std::ostream &stream)
 
   stream << "Currently registered events:" << std::endl;
 
-  for (auto it = m_events.begin (); it != m_events.end (); it++)
+  for (auto &event : GetEventsInOrder ())
     {
-      (*it)->Print (stream);
+      event->Print (stream);
       stream << std::endl;
     }
 }
@@ -252,101 +327,89 @@ LoraInterferenceHelper::IsDestroyedByInterference (Ptr<LoraInterferenceHelper::E
 {
   NS_LOG_FUNCTION (this << event);
 
-  NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_events.size ());
+  NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_nEvents);
 
   // We want to see the interference affecting this event: cycle through events
   // that overlap with this one and see whether it survives the interference or
   // not.
 
   // Gather information about the event
-  double rxPowerDbm = event->GetRxPowerdBm ();
   uint8_t sf = event->GetSpreadingFactor ();
   double frequency = event->GetFrequency ();
 
   // Handy information about the time frame when the packet was received
-  Time now = Simulator::Now ();
   Time duration = event->GetDuration ();
-  Time packetStartTime = now - duration;
-  Time packetEndTime = now;
-
-  // Get the list of interfering events
-  std::list<Ptr<LoraInterferenceHelper::Event>>::iterator it;
-
-  // Energy for interferers of various SFs
-  std::vector<double> cumulativeInterferenceEnergy (6, 0);
 
-  // Cycle over the events
-  for (it = m_events.begin (); it != m_events.end ();)
+  // Only consider events on the same channel: we assume there's no
+  // interchannel interference. Events ending before this one started cannot
+  // overlap with it, so we only look at the ones after them in the bucket.
+  // Interferers are then visited in the order they were added, so that
+  // energies are always summed in the same order.
+  std::vector<std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>>> interferers;
+  auto bucket = m_events.find (frequency);
+  if (bucket != m_events.end ())
     {
-      // Pointer to the current interferer
-      Ptr<LoraInterferenceHelper::Event> interferer = *it;
-
-      // Only consider the current event if the channel is the same: we
-      // assume there's no interchannel interference. Also skip the current
-      // event if it's the same that we want to analyze.
-      if (!(interferer->GetFrequency () == frequency) || interferer == event)
+      for (auto it = bucket->second.upper_bound (event->GetStartTime ());
+           it != bucket->second.end (); it++)
         {
-          NS_LOG_DEBUG ("Different channel or same event");
-          it++;
-          continue; // Continues from the first line inside the for cycle
+          // Skip the current event if it's the same that we want to analyze
+          if (it->second.second != event)
+            {
+              interferers.push_back (it->second);
+            }
         }
+    }
+  std::sort (interferers.begin (), interferers.end (),
+             [] (const std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>> &a,
+                 const std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>> &b) {
+               return a.first < b.first;
+             });
+
+  // Lay the interferers out as a structure of arrays
+  std::size_t n = interferers.size ();
+  m_batch.start.resize (n);
+  m_batch.end.resize (n);
+  m_batch.powerW.resize (n);
+  m_batch.sfIndex.resize (n);
+  m_batch.overlap.resize (n);
+  for (std::size_t i = 0; i < n; i++)
+    {
+      Ptr<LoraInterferenceHelper::Event> interferer = interferers[i].second;
 
-      NS_LOG_DEBUG ("Interferer on same channel");
-
-      // Gather information about this interferer
-      uint8_t interfererSf = interferer->GetSpreadingFactor ();
-      double interfererPower = interferer->GetRxPowerdBm ();
-      Time interfererStartTime = interferer->GetStartTime ();
-      Time interfererEndTime = interferer->GetEndTime ();
+      NS_LOG_INFO ("Found an interferer: " << *interferer);
 
-      NS_LOG_INFO ("Found an interferer: sf = " << unsigned(interfererSf)
-                                                << ", power = " << interfererPower
-                                                << ", start time = " << interfererStartTime
-                                                << ", end time = " << interfererEndTime);
+      m_batch.start[i] = interferer->GetStartTime ().GetTimeStep ();
+      m_batch.end[i] = interferer->GetEndTime ().GetTimeStep ();
+      m_batch.powerW[i] = interferer->GetRxPowerW ();
+      m_batch.sfIndex[i] = interferer->GetSpreadingFactor () - 7;
+    }
 
-      // Compute the fraction of time the two events are overlapping
-      Time overlap = GetOverlapTime (event, interferer);
+  // Energy for interferers of various SFs
+  double cumulativeInterferenceEnergy[6];
+  AccumulateInterferenceEnergy (event->GetStartTime ().GetTimeStep (),
+                                event->GetEndTime ().GetTimeStep (), m_batch,
+                                cumulativeInterferenceEnergy);
 
-      NS_LOG_DEBUG ("The two events overlap for " << overlap.GetSeconds () << " s.");
+  // Use the computed cumulativeInterferenceEnergy to determine whether the
+  // interference with some SF destroys the packet
+  double signalEnergy = duration.GetSeconds () * event->GetRxPowerW ();
+  NS_LOG_DEBUG ("Signal power in W: " << event->GetRxPowerW ());
+  NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
 
-      // Compute the equivalent energy of the interference
-      // Power [mW] = 10^(Power[dBm]/10)
-      // Power [W] = Power [mW] / 1000
-      double interfererPowerW = pow (10, interfererPower / 10) / 1000;
-      // Energy [J] = Time [s] * Power [W]
-      double interferenceEnergy = overlap.GetSeconds () * interfererPowerW;
-      cumulativeInterferenceEnergy.at (unsigned(interfererSf) - 7) += interferenceEnergy;
-      NS_LOG_DEBUG ("Interferer power in W: " << interfererPowerW);
-      NS_LOG_DEBUG ("Interference energy: " << interferenceEnergy);
-      it++;
-    }
+  // The isolation needed to survive the interference of each SF
+  const std::vector<double> &snirIsolation = m_collisionSnir[unsigned(sf) - 7];
 
   // For each SF, check if there was destructive interference
   for (uint8_t currentSf = uint8_t (7); currentSf <= uint8_t (12); currentSf++)
     {
-      NS_LOG_DEBUG ("Cumulative Interference Energy: "
-                    << cumulativeInterferenceEnergy.at (unsigned(currentSf) - 7));
-
-      // Use the computed cumulativeInterferenceEnergy to determine whether the
-      // interference with this SF destroys the packet
-      double signalPowerW = pow (10, rxPowerDbm / 10) / 1000;
-      double signalEnergy = duration.GetSeconds () * signalPowerW;
-      NS_LOG_DEBUG ("Signal power in W: " << signalPowerW);
-      NS_LOG_DEBUG ("Signal energy: " << signalEnergy);
-
-      // Check whether the packet survives the interference of this SF
-      double snirIsolation = m_collisionSnir[unsigned(sf) - 7][unsigned(currentSf) - 7];
-      NS_LOG_DEBUG ("The needed isolation to survive is " << snirIsolation << " dB");
-      double snir =
-          10 * log10 (signalEnergy / cumulativeInterferenceEnergy.at (unsigned(currentSf) - 7));
-      NS_LOG_DEBUG ("The current SNIR is " << snir << " dB");
-
-      if (snir >= snirIsolation)
-        {
-          // Move on and check the rest of the interferers
-          NS_LOG_DEBUG ("Packet survived interference with SF " << currentSf);
-        }
-      else
+      unsigned index = unsigned(currentSf) - 7;
+      double snir = 10 * log10 (signalEnergy / cumulativeInterferenceEnergy[index]);
+
+      NS_LOG_DEBUG ("SF" << unsigned(currentSf) << ": cumulative interference energy "
+                         << cumulativeInterferenceEnergy[index] << ", SNIR " << snir
+                         << " dB, needed isolation " << snirIsolation[index] << " dB");
+
+      if (!(snir >= snirIsolation[index]))
         {
           NS_LOG_DEBUG ("Packet destroyed by interference with SF" << unsigned(currentSf));
 
@@ -360,12 +423,49 @@ LoraInterferenceHelper::IsDestroyedByInterference (Ptr<LoraInterferenceHelper::E
   return uint8_t (0);
 }
 
+void
+LoraInterferenceHelper::AccumulateInterferenceEnergy (int64_t start, int64_t end,
+                                                      InterfererBatch &batch,
+                                                      double energy[6])
+{
+  std::size_t n = batch.start.size ();
+  const int64_t *starts = batch.start.data ();
+  const int64_t *ends = batch.end.data ();
+  const double *powers = batch.powerW.data ();
+  const uint8_t *sfIndexes = batch.sfIndex.data ();
+  double *overlaps = batch.overlap.data ();
+
+  // Overlap of each interferer with the event, in seconds, converted like
+  // Time::GetSeconds does. This loop is branch-free, so that the compiler can
+  // vectorize it.
+  const double stepsPerSecond = double (Seconds (1).GetTimeStep ());
+  for (std::size_t i = 0; i < n; i++)
+    {
+      int64_t overlapStart = std::max (start, starts[i]);
+      int64_t overlapEnd = std::min (end, ends[i]);
+      overlaps[i] = double (std::max (overlapEnd - overlapStart, int64_t (0))) / stepsPerSecond;
+    }
+
+  for (unsigned j = 0; j < 6; j++)
+    {
+      energy[j] = 0;
+    }
+
+  // Energy [J] = Time [s] * Power [W]. Interferers that don't overlap with the
+  // event add an exact zero, so they don't need to be skipped.
+  for (std::size_t i = 0; i < n; i++)
+    {
+      energy[sfIndexes[i]] += overlaps[i] * powers[i];
+    }
+}
+
 void
 LoraInterferenceHelper::ClearAllEvents (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
   m_events.clear ();
+  m_nEvents = 0;
 }
 
 Time
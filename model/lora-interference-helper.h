@@ -28,7 +28,9 @@
 #include "ns3/callback.h"
 #include "ns3/packet.h"
 #include "ns3/logical-lora-channel.h"
+#include "ns3/free-list-allocator.h"
 #include <list>
+#include <map>
 
 namespace ns3 {
 namespace lorawan {
@@ -55,8 +57,17 @@ public:
   public:
     Event (Time duration, double rxPowerdBm, uint8_t spreadingFactor, Ptr<Packet> packet,
            double frequencyMHz);
+    Event (Time startTime, Time duration, double rxPowerdBm, uint8_t spreadingFactor,
+           Ptr<Packet> packet, double frequencyMHz);
     ~Event ();
 
+    /**
+     * Events are short-lived and created for every signal arriving at every
+     * PHY, so their memory is recycled through a FreeListAllocator.
+     */
+    static void *operator new (std::size_t size);
+    static void operator delete (void *pointer);
+
     /**
      * Get the duration of the event.
      */
@@ -77,6 +88,11 @@ public:
      */
     double GetRxPowerdBm (void) const;
 
+    /**
+     * Get the power of the event in W.
+     */
+    double GetRxPowerW (void) const;
+
     /**
      * Get the spreading factor used by this signal.
      */
@@ -118,6 +134,11 @@ public:
      */
     double m_rxPowerdBm;
 
+    /**
+     * The power of this event in W (at the device).
+     */
+    double m_rxPowerW;
+
     /**
      * The packet this event was generated for.
      */
@@ -153,6 +174,22 @@ public:
   Ptr<LoraInterferenceHelper::Event> Add (Time duration, double rxPower, uint8_t spreadingFactor,
                                           Ptr<Packet> packet, double frequencyMHz);
 
+  /**
+   * Add an event that started arriving in the past to the InterferenceHelper
+   *
+   * \param startTime the time the packet started arriving.
+   * \param duration the duration of the packet.
+   * \param rxPower the received power in dBm.
+   * \param spreadingFactor the spreading factor used by the transmission.
+   * \param packet The packet carried by this transmission.
+   * \param frequencyMHz The frequency this event was sent at.
+   *
+   * \return the newly created event
+   */
+  Ptr<LoraInterferenceHelper::Event> Add (Time startTime, Time duration, double rxPower,
+                                          uint8_t spreadingFactor, Ptr<Packet> packet,
+                                          double frequencyMHz);
+
   /**
    * Get a list of the interferers currently registered at this
    * InterferenceHelper.
@@ -207,9 +244,64 @@ private:
   std::vector<std::vector<double>> m_collisionSnir;
 
   /**
-   * A list of the events this LoraInterferenceHelper is keeping track of.
+   * Events on a single frequency, ordered by their end time. Each event is
+   * paired with a sequence number reflecting the order it was added in.
+   */
+  typedef std::multimap<
+      Time, std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>>, std::less<Time>,
+      FreeListAllocator<
+          std::pair<const Time, std::pair<uint64_t, Ptr<LoraInterferenceHelper::Event>>>>>
+      EventBucket;
+
+  /**
+   * The interferers of an event, laid out as a structure of arrays so that
+   * they can be processed in batch.
+   */
+  struct InterfererBatch
+  {
+    std::vector<int64_t> start; //!< Start times, in time steps
+    std::vector<int64_t> end; //!< End times, in time steps
+    std::vector<double> powerW; //!< Receive powers, in W
+    std::vector<uint8_t> sfIndex; //!< Spreading factors, minus 7
+    std::vector<double> overlap; //!< Overlap with the event, in seconds
+  };
+
+  /**
+   * Compute the energy each SF contributes to the interference on an event.
+   *
+   * \param start The start of the event, in time steps.
+   * \param end The end of the event, in time steps.
+   * \param batch The interferers, in the order their energies must be summed.
+   * \param energy The cumulative interference energy of each SF, in J.
+   */
+  static void AccumulateInterferenceEnergy (int64_t start, int64_t end,
+                                            InterfererBatch &batch, double energy[6]);
+
+  /**
+   * Scratch space reused by IsDestroyedByInterference.
+   */
+  InterfererBatch m_batch;
+
+  /**
+   * Get all events, in the order they were added.
+   */
+  std::vector<Ptr<LoraInterferenceHelper::Event>> GetEventsInOrder (void) const;
+
+  /**
+   * The events this LoraInterferenceHelper is keeping track of, grouped by
+   * frequency.
+   */
+  std::map<double, EventBucket> m_events;
+
+  /**
+   * The number of events in m_events.
+   */
+  uint32_t m_nEvents;
+
+  /**
+   * The sequence number to assign to the next event.
    */
-  std::list<Ptr<LoraInterferenceHelper::Event>> m_events;
+  uint64_t m_nextEventId;
 
   /**
    * The matrix containing information about how packets survive interference.
@@ -22,6 +22,8 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -73,7 +75,9 @@ LoraPhy::GetTypeId (void)
   return tid;
 }
 
-LoraPhy::LoraPhy ()
+LoraPhy::LoraPhy () :
+  m_nodeId (0),
+  m_nodeIdKnown (false)
 {
 }
 
@@ -93,6 +97,24 @@ LoraPhy::SetDevice (Ptr<NetDevice> device)
   NS_LOG_FUNCTION (this << device);
 
   m_device = device;
+  m_nodeIdKnown = false;
+
+  // The channel needs to look up the device and node of this PHY again
+  if (m_channel != 0)
+    {
+      m_channel->InvalidatePhyRecords ();
+    }
+}
+
+uint32_t
+LoraPhy::GetNodeId (void)
+{
+  if (!m_nodeIdKnown)
+    {
+      m_nodeId = m_device->GetNode ()->GetId ();
+      m_nodeIdKnown = true;
+    }
+  return m_nodeId;
 }
 
 Ptr<LoraChannel>
@@ -126,6 +148,12 @@ LoraPhy::SetMobility (Ptr<MobilityModel> mobility)
   NS_LOG_FUNCTION_NOARGS ();
 
   m_mobility = mobility;
+
+  // The channel needs to look up the mobility model of this PHY again
+  if (m_channel != 0)
+    {
+      m_channel->InvalidatePhyRecords ();
+    }
 }
 
 void
@@ -155,12 +183,109 @@ LoraPhy::SetTxFinishedCallback (TxFinishedCallback callback)
 }
 
 
+namespace {
+
+// Payloads up to this size have their time on air memoised
+const uint32_t MAX_TABLE_PAYLOAD = 255;
+
+// The maximum number of sets of parameters that get a table
+const std::size_t MAX_TABLES = 64;
+
+/**
+ * The time on air of all the payload sizes up to MAX_TABLE_PAYLOAD, for a
+ * set of transmission parameters.
+ */
+struct OnAirTimeTable
+{
+  LoraTxParameters txParams;       //!< The parameters of the table
+  std::vector<int64_t> timeSteps;  //!< The time on air by payload size, or -1
+};
+
+std::vector<OnAirTimeTable> g_onAirTimeTables; //!< The tables
+std::size_t g_lastOnAirTimeTable = 0; //!< The table of the last lookup
+Time::Unit g_onAirTimeResolution = Time::LAST; //!< The resolution of the tables
+bool g_onAirTimeTablesEnabled = true; //!< Whether the tables are used
+
+bool
+IsSameTxParameters (const LoraTxParameters &a, const LoraTxParameters &b)
+{
+  return a.sf == b.sf && a.headerDisabled == b.headerDisabled &&
+         a.codingRate == b.codingRate && a.bandwidthHz == b.bandwidthHz &&
+         a.nPreamble == b.nPreamble && a.crcEnabled == b.crcEnabled &&
+         a.lowDataRateOptimizationEnabled == b.lowDataRateOptimizationEnabled;
+}
+
+} // namespace
+
 Time
 LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
 {
-
   NS_LOG_FUNCTION (packet << txParams);
 
+  // Payload size
+  uint32_t pl = packet->GetSize ();      // Size in bytes
+  NS_LOG_DEBUG ("Packet of size " << pl << " bytes");
+
+  if (pl > MAX_TABLE_PAYLOAD || !g_onAirTimeTablesEnabled)
+    {
+      return ComputeOnAirTime (pl, txParams);
+    }
+
+  // Time steps are only valid for the resolution they were computed with
+  if (Time::GetResolution () != g_onAirTimeResolution)
+    {
+      g_onAirTimeTables.clear ();
+      g_lastOnAirTimeTable = 0;
+      g_onAirTimeResolution = Time::GetResolution ();
+    }
+
+  // Look for the table of these parameters, starting from the last used one
+  std::size_t nTables = g_onAirTimeTables.size ();
+  bool found = false;
+  for (std::size_t i = 0; i < nTables && !found; i++)
+    {
+      std::size_t index = (g_lastOnAirTimeTable + i) % nTables;
+      if (IsSameTxParameters (g_onAirTimeTables[index].txParams, txParams))
+        {
+          g_lastOnAirTimeTable = index;
+          found = true;
+        }
+    }
+
+  if (!found)
+    {
+      if (nTables == MAX_TABLES)
+        {
+          return ComputeOnAirTime (pl, txParams);
+        }
+
+      NS_LOG_DEBUG ("Creating the time on air table of " << txParams);
+
+      OnAirTimeTable table;
+      table.txParams = txParams;
+      table.timeSteps.assign (MAX_TABLE_PAYLOAD + 1, -1);
+      g_onAirTimeTables.push_back (table);
+      g_lastOnAirTimeTable = nTables;
+    }
+
+  // Entries are filled the first time they are needed
+  int64_t &timeStep = g_onAirTimeTables[g_lastOnAirTimeTable].timeSteps[pl];
+  if (timeStep < 0)
+    {
+      timeStep = ComputeOnAirTime (pl, txParams).GetTimeStep ();
+    }
+  return TimeStep (timeStep);
+}
+
+void
+LoraPhy::EnableOnAirTimeTables (bool enable)
+{
+  g_onAirTimeTablesEnabled = enable;
+}
+
+Time
+LoraPhy::ComputeOnAirTime (uint32_t payloadSize, const LoraTxParameters &txParams)
+{
   // The contents of this function are based on [1].
   // [1] SX1272 LoRa modem designer's guide.
 
@@ -172,8 +297,7 @@ LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
   double tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
 
   // Payload size
-  uint32_t pl = packet->GetSize ();      // Size in bytes
-  NS_LOG_DEBUG ("Packet of size " << pl << " bytes");
+  uint32_t pl = payloadSize;      // Size in bytes
 
   // This step is needed since the formula deals with double values.
   // de = 1 when the low data rate optimization is enabled, 0 otherwise
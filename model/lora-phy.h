@@ -240,16 +240,49 @@ public:
    * (obtained through a GetSize () call to accout for the presence of Headers
    * and Trailers, too) also influences the packet transmit time.
    *
+   * The time on air of payloads of up to 255 bytes is memoised, in a table
+   * for each set of LoraTxParameters that is used.
+   *
    * \param packet The packet that needs to be transmitted.
    * \param txParams The set of parameters that will be used for transmission.
    * \return The time necessary to transmit the packet.
    */
   static Time GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams);
 
+  /**
+   * Compute the time on air of a payload from the formula, without looking
+   * at the tables of GetOnAirTime, which returns exactly the same value.
+   *
+   * \param payloadSize The size of the payload, in bytes.
+   * \param txParams The set of parameters that will be used for transmission.
+   * \return The time necessary to transmit the payload.
+   */
+  static Time ComputeOnAirTime (uint32_t payloadSize, const LoraTxParameters &txParams);
+
+  /**
+   * Set whether GetOnAirTime looks up the time on air in its tables, or
+   * always computes it from the formula. Tables are used by default.
+   *
+   * \param enable Whether to use the tables.
+   */
+  static void EnableOnAirTimeTables (bool enable);
+
 private:
   Ptr<MobilityModel> m_mobility;   //!< The mobility model associated to this PHY.
 
+  uint32_t m_nodeId; //!< The id of the node of m_device, once looked up.
+  bool m_nodeIdKnown; //!< Whether m_nodeId holds the id of the node.
+
 protected:
+  /**
+   * Get the id of the node this PHY's net device is installed on, which is
+   * used as context by the trace sources. It is only looked up the first time,
+   * since the device is installed on its node after being linked to the PHY.
+   *
+   * \return The id of the node.
+   */
+  uint32_t GetNodeId (void);
+
   // Member objects
 
   Ptr<NetDevice> m_device; //!< The net device this PHY is attached to.
@@ -17,8 +17,11 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/energy-source.h"
 #include "lora-radio-energy-model.h"
+#include <algorithm>
 
 
 namespace ns3 {
@@ -63,6 +66,23 @@ LoraRadioEnergyModel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraRadioEnergyModel::m_txCurrentModel),
                    MakePointerChecker<LoraTxCurrentModel> ())
+    .AddAttribute ("LazyAccounting",
+                   "Whether to only notify the energy source of the energy "
+                   "consumption when it reaches LazyUpdateThreshold, instead "
+                   "of at every state change. The energy source still takes "
+                   "into account all the consumption at its periodic updates.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraRadioEnergyModel::m_lazyAccounting),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LazyUpdateThreshold",
+                   "The energy [J] that can be consumed in lazy accounting mode "
+                   "before the energy source is notified at a state change. "
+                   "It should be smaller than the energy left when the source "
+                   "reaches its low battery threshold, so that depletion is "
+                   "detected in time.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&LoraRadioEnergyModel::m_lazyUpdateThresholdJ),
+                   MakeDoubleChecker<double> (0))
     .AddTraceSource ("TotalEnergyConsumption",
                      "Total energy consumption of the radio device.",
                      MakeTraceSourceAccessor (&LoraRadioEnergyModel::m_totalEnergyConsumption),
@@ -76,6 +96,12 @@ LoraRadioEnergyModel::LoraRadioEnergyModel ()
   NS_LOG_FUNCTION (this);
   m_currentState = EndDeviceLoraPhy::SLEEP;      // initially STANDBY
   m_lastUpdateTime = Seconds (0.0);
+  m_energyConsumption = 0;
+  m_lazyAccounting = false;
+  m_lazyUpdateThresholdJ = 0.1;
+  m_pendingEnergyJ = 0;
+  m_pendingChargeC = 0;
+  m_lastSourceUpdateTime = Seconds (0.0);
   m_nPendingChangeState = 0;
   m_isSupersededChangeState = false;
   m_energyDepletionCallback.Nullify ();
@@ -105,7 +131,7 @@ double
 LoraRadioEnergyModel::GetTotalEnergyConsumption (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_totalEnergyConsumption;
+  return m_energyConsumption;
 }
 
 double
@@ -240,7 +266,19 @@ LoraRadioEnergyModel::ChangeState (int newState)
     }
 
   // update total energy consumption
-  m_totalEnergyConsumption += energyToDecrease;
+  m_energyConsumption += energyToDecrease;
+
+  // in lazy accounting mode, only keep track of the charge drawn since the
+  // energy source last queried the current, unless enough energy was consumed
+  // that the source may need to handle depletion
+  bool notifySource = true;
+  if (m_lazyAccounting)
+    {
+      Time from = std::max (m_lastUpdateTime, m_lastSourceUpdateTime);
+      m_pendingChargeC += (Simulator::Now () - from).GetSeconds () * DoGetStateCurrentA ();
+      m_pendingEnergyJ += energyToDecrease;
+      notifySource = m_pendingEnergyJ >= m_lazyUpdateThresholdJ;
+    }
 
   // update last update time stamp
   m_lastUpdateTime = Simulator::Now ();
@@ -248,7 +286,12 @@ LoraRadioEnergyModel::ChangeState (int newState)
   m_nPendingChangeState++;
 
   // notify energy source
-  m_source->UpdateEnergySource ();
+  if (notifySource)
+    {
+      m_totalEnergyConsumption = m_energyConsumption;
+      m_pendingEnergyJ = 0;
+      m_source->UpdateEnergySource ();
+    }
 
   // in case the energy source is found to be depleted during the last update, a callback might be
   // invoked that might cause a change in the Lora PHY state (e.g., the PHY is put into SLEEP mode).
@@ -277,6 +320,7 @@ LoraRadioEnergyModel::HandleEnergyDepletion (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy is depleted!");
+  SourceUpdated ();
   // invoke energy depletion callback, if set.
   if (!m_energyDepletionCallback.IsNull ())
     {
@@ -289,6 +333,7 @@ LoraRadioEnergyModel::HandleEnergyChanged (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy changed!");
+  SourceUpdated ();
 }
 
 void
@@ -296,6 +341,7 @@ LoraRadioEnergyModel::HandleEnergyRecharged (void)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("LoraRadioEnergyModel:Energy is recharged!");
+  SourceUpdated ();
   // invoke energy recharged callback, if set.
   if (!m_energyRechargedCallback.IsNull ())
     {
@@ -326,6 +372,39 @@ double
 LoraRadioEnergyModel::DoGetCurrentA (void) const
 {
   NS_LOG_FUNCTION (this);
+
+  if (!m_lazyAccounting)
+    {
+      return DoGetStateCurrentA ();
+    }
+
+  // The energy source computes the energy consumed since its last update from
+  // the current, so return the average current since then. The counters are
+  // reset by SourceUpdated, once the source is done with the update.
+  Time from = std::max (m_lastUpdateTime, m_lastSourceUpdateTime);
+  double chargeC = m_pendingChargeC + (Simulator::Now () - from).GetSeconds () * DoGetStateCurrentA ();
+  Time interval = Simulator::Now () - m_lastSourceUpdateTime;
+  if (interval.IsStrictlyPositive ())
+    {
+      return chargeC / interval.GetSeconds ();
+    }
+  return DoGetStateCurrentA ();
+}
+
+void
+LoraRadioEnergyModel::SourceUpdated (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The energy source took into account the consumption up to now
+  m_pendingChargeC = 0;
+  m_pendingEnergyJ = 0;
+  m_lastSourceUpdateTime = Simulator::Now ();
+}
+
+double
+LoraRadioEnergyModel::DoGetStateCurrentA (void) const
+{
   switch (m_currentState)
     {
     case EndDeviceLoraPhy::STANDBY:
@@ -123,6 +123,19 @@ private:
  * object. The EnergySource object will query this model for the total current.
  * Then the EnergySource object uses the total current to calculate energy.
  *
+ * In lazy accounting mode (see the LazyAccounting attribute), transactions only
+ * add the energy spent in the previous state to a counter, and the
+ * EnergySource is notified only once the energy consumed since its last
+ * update reaches the LazyUpdateThreshold. In between, the EnergySource learns
+ * about the consumption through its own periodic updates: when it queries the
+ * current, this model returns the average current since its previous update,
+ * so that the energy it computes accounts for all the states the radio went
+ * through. Querying the current has no side effects: the model learns that
+ * the update is over from the HandleEnergyChanged, HandleEnergyDepletion or
+ * HandleEnergyRecharged notification that BasicEnergySource sends at its end. The total energy consumption returned by GetTotalEnergyConsumption
+ * is the same as in the default mode, but the TotalEnergyConsumption trace
+ * source is only updated when the EnergySource is notified.
+ *
  */
 class LoraRadioEnergyModel : public DeviceEnergyModel
 {
@@ -291,6 +304,20 @@ private:
    */
   double DoGetCurrentA (void) const;
 
+  /**
+   * \returns Current draw of device in its current state.
+   */
+  double DoGetStateCurrentA (void) const;
+
+  /**
+   * Reset the lazy accounting counters, after the energy source queried the
+   * current and took it into account.
+   *
+   * This is called by the handlers of the notifications the energy source
+   * sends at the end of each of its updates.
+   */
+  void SourceUpdated (void);
+
   /**
    * \param state New state the radio device is currently in.
    *
@@ -312,6 +339,16 @@ private:
   /// This variable keeps track of the total energy consumed by this model.
   TracedValue<double> m_totalEnergyConsumption;
 
+  /// The total energy consumed by this model, up to the last state change.
+  double m_energyConsumption;
+
+  // Lazy accounting.
+  bool m_lazyAccounting; ///< whether the energy source is notified lazily
+  double m_lazyUpdateThresholdJ; ///< energy that triggers a notification
+  double m_pendingEnergyJ; ///< energy consumed since the last update
+  double m_pendingChargeC; ///< charge drawn since the last update
+  Time m_lastSourceUpdateTime; ///< time stamp of the last source update
+
   // State variables.
   EndDeviceLoraPhy::State m_currentState;  ///< current state the radio is in
   Time m_lastUpdateTime;          ///< time stamp of previous energy update
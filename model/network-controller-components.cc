@@ -66,31 +66,23 @@ ConfirmedMessagesComponent::~ConfirmedMessagesComponent ()
 }
 
 void
-ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const Packet> packet,
+ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                                               Ptr<EndDeviceStatus> status,
                                               Ptr<NetworkStatus> networkStatus)
 {
-  NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
+  NS_LOG_FUNCTION (this->GetTypeId () << uplink->GetPacket () << networkStatus);
 
   // Check whether the received packet requires an acknowledgment.
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  NS_LOG_INFO ("Received packet MType: " << unsigned (uplink->GetMType ()));
 
-  NS_LOG_INFO ("Received packet Mac Header: " << mHdr);
-  NS_LOG_INFO ("Received packet Frame Header: " << fHdr);
-
-  if (mHdr.GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
+  if (uplink->GetMType () == LorawanMacHeader::CONFIRMED_DATA_UP)
     {
       NS_LOG_INFO ("Packet requires confirmation");
 
       // Set up the ACK bit on the reply
       status->m_reply.frameHeader.SetAsDownlink ();
       status->m_reply.frameHeader.SetAck (true);
-      status->m_reply.frameHeader.SetAddress (fHdr.GetAddress ());
+      status->m_reply.frameHeader.SetAddress (uplink->GetAddress ());
       status->m_reply.macHeader.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
       status->m_reply.needsReply = true;
 
@@ -143,11 +135,11 @@ LinkCheckComponent::~LinkCheckComponent ()
 }
 
 void
-LinkCheckComponent::OnReceivedPacket (Ptr<const Packet> packet,
+LinkCheckComponent::OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                                       Ptr<EndDeviceStatus> status,
                                       Ptr<NetworkStatus> networkStatus)
 {
-  NS_LOG_FUNCTION (this->GetTypeId () << packet << networkStatus);
+  NS_LOG_FUNCTION (this->GetTypeId () << uplink->GetPacket () << networkStatus);
 
   // We will only act just before reply, when all Gateways will have received
   // the packet.
@@ -159,14 +151,8 @@ LinkCheckComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
-  LorawanMacHeader mHdr;
-  LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
-
-  Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq> ();
+  Ptr<LinkCheckReq> command =
+    status->GetLastReceivedUplink ()->GetMacCommand<LinkCheckReq> ();
 
   // GetMacCommand returns 0 if no command is found
   if (command)
@@ -55,10 +55,10 @@ public:
   /**
    * Method that is called when a new packet is received by the NetworkServer.
    *
-   * \param packet The newly received packet
+   * \param uplink The newly received packet, as parsed by the NetworkServer
    * \param networkStatus A pointer to the NetworkStatus object
    */
-  virtual void OnReceivedPacket (Ptr<const Packet> packet,
+  virtual void OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                                  Ptr<EndDeviceStatus> status,
                                  Ptr<NetworkStatus> networkStatus) = 0;
 
@@ -93,10 +93,10 @@ public:
    * This method checks whether the received packet requires an acknowledgment
    * and sets up the appropriate reply in case it does.
    *
-   * \param packet The newly received packet
+   * \param uplink The newly received packet
    * \param networkStatus A pointer to the NetworkStatus object
    */
-  void OnReceivedPacket (Ptr<const Packet> packet,
+  void OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                          Ptr<EndDeviceStatus> status,
                          Ptr<NetworkStatus> networkStatus);
 
@@ -124,10 +124,10 @@ public:
    * This method checks whether the received packet requires an acknowledgment
    * and sets up the appropriate reply in case it does.
    *
-   * \param packet The newly received packet
+   * \param uplink The newly received packet
    * \param networkStatus A pointer to the NetworkStatus object
    */
-  void OnReceivedPacket (Ptr<const Packet> packet,
+  void OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                          Ptr<EndDeviceStatus> status,
                          Ptr<NetworkStatus> networkStatus);
 
@@ -1,4 +1,5 @@
 #include "network-scheduler.h"
+#include "ns3/pointer.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -17,12 +18,31 @@ NetworkScheduler::GetTypeId (void)
                      "Trace source that is fired when a receive window opportunity happens.",
                      MakeTraceSourceAccessor (&NetworkScheduler::m_receiveWindowOpened),
                      "ns3::Packet::TracedCallback")
+    .AddAttribute ("ReceiveWindowResolution",
+                   "The time resolution of receive window opportunities, "
+                   "which are delayed to the next multiple of it.",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&NetworkScheduler::SetReceiveWindowResolution,
+                                     &NetworkScheduler::GetReceiveWindowResolution),
+                   MakeTimeChecker ())
+    .AddAttribute ("DownlinkPlanner",
+                   "The strategy used to assign gateways to the replies of "
+                   "the receive windows that open in the same interval. "
+                   "A MatchingDownlinkPlanner is used if none is set.",
+                   PointerValue (),
+                   MakePointerAccessor (&NetworkScheduler::SetDownlinkPlanner,
+                                        &NetworkScheduler::GetDownlinkPlanner),
+                   MakePointerChecker<DownlinkPlanner> ())
     .SetGroupName ("lorawan");
   return tid;
 }
 
 NetworkScheduler::NetworkScheduler ()
 {
+  m_receiveWindows.SetExpireCallback
+    (MakeCallback (&NetworkScheduler::ExpireReceiveWindow, this));
+  m_receiveWindows.SetTickCallback
+    (MakeCallback (&NetworkScheduler::PlanReceiveWindows, this));
 }
 
 NetworkScheduler::NetworkScheduler (Ptr<NetworkStatus> status,
@@ -30,6 +50,10 @@ NetworkScheduler::NetworkScheduler (Ptr<NetworkStatus> status,
   m_status (status),
   m_controller (controller)
 {
+  m_receiveWindows.SetExpireCallback
+    (MakeCallback (&NetworkScheduler::ExpireReceiveWindow, this));
+  m_receiveWindows.SetTickCallback
+    (MakeCallback (&NetworkScheduler::PlanReceiveWindows, this));
 }
 
 NetworkScheduler::~NetworkScheduler ()
@@ -37,97 +61,204 @@ NetworkScheduler::~NetworkScheduler ()
 }
 
 void
-NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
+NetworkScheduler::OnReceivedPacket (Ptr<const ParsedUplink> uplink)
 {
-  NS_LOG_FUNCTION (packet);
+  NS_LOG_FUNCTION (uplink->GetPacket ());
 
-  // Get the current packet's frame counter
-  Ptr<Packet> packetCopy = packet->Copy ();
-  LorawanMacHeader receivedMacHdr;
-  packetCopy->RemoveHeader (receivedMacHdr);
-  LoraFrameHeader receivedFrameHdr;
-  receivedFrameHdr.SetAsUplink ();
-  packetCopy->RemoveHeader (receivedFrameHdr);
+  // Extract the address
+  LoraDeviceAddress deviceAddress = uplink->GetAddress ();
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
 
   // Need to decide whether to schedule a receive window
-  if (!m_status->GetEndDeviceStatus (packet)->HasReceiveWindowOpportunityScheduled ())
+  if (!edStatus->HasReceiveWindowOpportunityScheduled ())
   {
-    // Extract the address
-    LoraDeviceAddress deviceAddress = receivedFrameHdr.GetAddress ();
-
     // Schedule OnReceiveWindowOpportunity event
-    m_status->GetEndDeviceStatus (packet)->SetReceiveWindowOpportunity (
-      Simulator::Schedule (Seconds (1),
-                           &NetworkScheduler::OnReceiveWindowOpportunity,
-                           this,
-                           deviceAddress,
-                           1)); // This will be the first receive window
+    ScheduleReceiveWindow (edStatus, deviceAddress, 1, false); // This will be the first receive window
   }
 }
 
+void
+NetworkScheduler::SetReceiveWindowResolution (Time resolution)
+{
+  NS_LOG_FUNCTION (this << resolution);
+
+  m_receiveWindows.SetTick (resolution);
+}
+
+Time
+NetworkScheduler::GetReceiveWindowResolution (void) const
+{
+  return m_receiveWindows.GetTick ();
+}
+
+void
+NetworkScheduler::SetDownlinkPlanner (Ptr<DownlinkPlanner> planner)
+{
+  m_planner = planner;
+}
+
+Ptr<DownlinkPlanner>
+NetworkScheduler::GetDownlinkPlanner (void) const
+{
+  return m_planner;
+}
+
+void
+NetworkScheduler::ScheduleReceiveWindow (Ptr<EndDeviceStatus> edStatus,
+                                         LoraDeviceAddress deviceAddress,
+                                         int window, bool replyPrepared)
+{
+  ReceiveWindow receiveWindow;
+  receiveWindow.deviceAddress = deviceAddress;
+  receiveWindow.window = window;
+  receiveWindow.replyPrepared = replyPrepared;
+  m_receiveWindows.Schedule (Seconds (1), receiveWindow);
+  edStatus->SetReceiveWindowOpportunityPending (true);
+}
+
+void
+NetworkScheduler::ExpireReceiveWindow (ReceiveWindow receiveWindow)
+{
+  // Opportunities removed in the meantime are simply skipped
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (receiveWindow.deviceAddress);
+  if (!edStatus->IsReceiveWindowOpportunityPending ())
+    {
+      return;
+    }
+  edStatus->SetReceiveWindowOpportunityPending (false);
+
+  // The opportunity is handled together with the others of the same tick
+  m_batch.push_back (receiveWindow);
+}
+
 void
 NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window)
 {
   NS_LOG_FUNCTION (deviceAddress);
 
-  NS_LOG_DEBUG ("Opening receive window number " << window << " for device "
-                                                 << deviceAddress);
+  ReceiveWindow receiveWindow;
+  receiveWindow.deviceAddress = deviceAddress;
+  receiveWindow.window = window;
+  receiveWindow.replyPrepared = false;
+  m_batch.push_back (receiveWindow);
+  PlanReceiveWindows ();
+}
 
-  // Check whether we can send a reply to the device, again by using
-  // NetworkStatus
-  Address gwAddress = m_status->GetBestGatewayForDevice (deviceAddress, window);
+void
+NetworkScheduler::PlanReceiveWindows (void)
+{
+  NS_LOG_FUNCTION (this << m_batch.size ());
 
-  if (gwAddress == Address () && window == 1)
+  if (m_batch.empty ())
     {
-      NS_LOG_DEBUG ("No suitable gateway found for first window.");
-
-      // No suitable GW was found, but there's still hope to find one for the
-      // second window.
-      // Schedule another OnReceiveWindowOpportunity event
-      m_status->GetEndDeviceStatus (deviceAddress)->SetReceiveWindowOpportunity (
-        Simulator::Schedule (Seconds (1),
-                             &NetworkScheduler::OnReceiveWindowOpportunity,
-                             this,
-                             deviceAddress,
-                             2));     // This will be the second receive window
+      return;
     }
-  else if (gwAddress == Address () && window == 2)
+  if (m_planner == 0)
     {
-      // No suitable GW was found and this was our last opportunity
-      // Simply give up.
-      NS_LOG_DEBUG ("Giving up on reply: no suitable gateway was found " <<
-                   "on the second receive window");
-
-      // Reset the reply
-      // XXX Should we reset it here or keep it for the next opportunity?
-      m_status->GetEndDeviceStatus (deviceAddress)->RemoveReceiveWindowOpportunity();
-      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+      m_planner = CreateObject<MatchingDownlinkPlanner> ();
     }
-  else
+
+  // Collect the gateways that can reach each device, and let the controller
+  // prepare the replies of the devices that can be reached
+  std::size_t nRequests = 0;
+  for (std::size_t i = 0; i < m_batch.size (); i++)
     {
-      // A gateway was found
+      LoraDeviceAddress deviceAddress = m_batch[i].deviceAddress;
+      int window = m_batch[i].window;
 
-      NS_LOG_DEBUG ("Found available gateway with address: " << gwAddress);
+      NS_LOG_DEBUG ("Opening receive window number " << window << " for device "
+                                                     << deviceAddress);
 
-      m_controller->BeforeSendingReply (m_status->GetEndDeviceStatus
-                                          (deviceAddress));
+      if (nRequests == m_requests.size ())
+        {
+          m_requests.push_back (DownlinkPlanner::Request ());
+        }
+      DownlinkPlanner::Request &request = m_requests[nRequests];
+      m_status->GetAvailableGatewaysForDevice (deviceAddress, window, request.gateways);
 
-      // Check whether this device needs a response by querying m_status
-      bool needsReply = m_status->NeedsReply (deviceAddress);
+      if (request.gateways.empty ())
+        {
+          NS_LOG_DEBUG ("No suitable gateway found for window " << window);
+          OnReplyNotSent (m_batch[i]);
+          continue;
+        }
+
+      NS_LOG_DEBUG ("Found " << request.gateways.size () << " available gateways");
+
+      if (!m_batch[i].replyPrepared)
+        {
+          m_controller->BeforeSendingReply (m_status->GetEndDeviceStatus
+                                              (deviceAddress));
+          m_batch[i].replyPrepared = true;
+        }
 
-      if (needsReply)
+      // Check whether this device needs a response by querying m_status
+      if (m_status->NeedsReply (deviceAddress))
         {
           NS_LOG_INFO ("A reply is needed");
 
-          // Send the reply through that gateway
-          m_status->SendThroughGateway (m_status->GetReplyForDevice
-                                          (deviceAddress, window),
-                                        gwAddress);
+          // Keep the opportunities of the requests at the front of the batch
+          std::swap (m_batch[nRequests], m_batch[i]);
+          nRequests++;
+        }
+    }
 
-          // Reset the reply
-          m_status->GetEndDeviceStatus (deviceAddress)->RemoveReceiveWindowOpportunity();
-          m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+  // Assign the gateways jointly, and send the replies
+  m_requests.resize (nRequests);
+  m_planner->Plan (m_requests, m_status->GetGatewayCount ());
+  for (std::size_t i = 0; i < nRequests; i++)
+    {
+      LoraDeviceAddress deviceAddress = m_batch[i].deviceAddress;
+      uint32_t gateway = m_requests[i].gateway;
+      if (gateway == DownlinkPlanner::NO_GATEWAY)
+        {
+          NS_LOG_DEBUG ("All the gateways of device " << deviceAddress <<
+                        " were assigned to other devices");
+          OnReplyNotSent (m_batch[i]);
+          continue;
         }
+
+      // Send the reply through that gateway, and book it so that it is not
+      // used by other replies before it starts transmitting
+      Ptr<GatewayStatus> gwStatus = m_status->GetGatewayStatus (gateway);
+      NS_LOG_DEBUG ("Sending reply through gateway " << gwStatus->GetAddress ());
+      gwStatus->SetNextTransmissionTime (Simulator::Now ());
+      m_status->SendThroughGateway (m_status->GetReplyForDevice
+                                      (deviceAddress, m_batch[i].window),
+                                    gwStatus->GetAddress ());
+
+      // Reset the reply
+      m_status->GetEndDeviceStatus (deviceAddress)->RemoveReceiveWindowOpportunity();
+      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+    }
+
+  m_batch.clear ();
+}
+
+void
+NetworkScheduler::OnReplyNotSent (const ReceiveWindow &receiveWindow)
+{
+  LoraDeviceAddress deviceAddress = receiveWindow.deviceAddress;
+  if (receiveWindow.window == 1)
+    {
+      // No gateway could be used, but there's still hope to find one for the
+      // second window.
+      ScheduleReceiveWindow (m_status->GetEndDeviceStatus (deviceAddress),
+                             deviceAddress,
+                             2,      // This will be the second receive window
+                             receiveWindow.replyPrepared);
+    }
+  else
+    {
+      // No gateway could be used and this was our last opportunity
+      // Simply give up.
+      NS_LOG_DEBUG ("Giving up on reply: no suitable gateway was found " <<
+                    "on the second receive window");
+
+      // Reset the reply
+      // XXX Should we reset it here or keep it for the next opportunity?
+      m_status->GetEndDeviceStatus (deviceAddress)->RemoveReceiveWindowOpportunity();
+      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
     }
 }
 }
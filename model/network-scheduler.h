@@ -29,6 +29,8 @@
 #include "ns3/lora-frame-header.h"
 #include "ns3/network-controller.h"
 #include "ns3/network-status.h"
+#include "ns3/timer-wheel.h"
+#include "ns3/downlink-planner.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -51,18 +53,84 @@ public:
    * uplink packet. This function schedules the OnReceiveWindowOpportunity
    * events 1 and 2 seconds later.
    */
-  void OnReceivedPacket (Ptr<const Packet> packet);
+  void OnReceivedPacket (Ptr<const ParsedUplink> uplink);
 
   /**
-   * Method that is scheduled after packet arrivals in order to act on
-   * receive windows 1 and 2 seconds later receptions.
+   * Act on a receive window opportunity of a single device right away.
+   *
+   * Opportunities scheduled after packet arrivals are handled in batches
+   * instead: those falling in the same ReceiveWindowResolution interval are
+   * collected, and the DownlinkPlanner assigns gateways to all of their
+   * replies at once.
    */
   void OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, int window);
 
+  /**
+   * Set the resolution of the receive window opportunities. Can only be
+   * changed while no opportunity is scheduled.
+   */
+  void SetReceiveWindowResolution (Time resolution);
+
+  /**
+   * Get the resolution of the receive window opportunities.
+   */
+  Time GetReceiveWindowResolution (void) const;
+
+  /**
+   * Set the strategy used to assign gateways to the replies of a batch.
+   */
+  void SetDownlinkPlanner (Ptr<DownlinkPlanner> planner);
+
+  /**
+   * Get the strategy used to assign gateways to the replies of a batch.
+   */
+  Ptr<DownlinkPlanner> GetDownlinkPlanner (void) const;
+
 private:
+  /**
+   * A receive window opportunity waiting in m_receiveWindows.
+   */
+  struct ReceiveWindow
+  {
+    LoraDeviceAddress deviceAddress; //!< The device to reply to
+    int window;                      //!< The receive window number
+    bool replyPrepared;              //!< Whether the controller prepared the reply
+  };
+
+  /**
+   * Schedule a receive window opportunity for a device, one second from now.
+   */
+  void ScheduleReceiveWindow (Ptr<EndDeviceStatus> edStatus,
+                              LoraDeviceAddress deviceAddress, int window,
+                              bool replyPrepared);
+
+  /**
+   * Called by m_receiveWindows when a receive window opportunity is due.
+   */
+  void ExpireReceiveWindow (ReceiveWindow receiveWindow);
+
+  /**
+   * Send the replies of the opportunities in m_batch, through the gateways
+   * chosen by the DownlinkPlanner.
+   */
+  void PlanReceiveWindows (void);
+
+  /**
+   * Move to the second receive window, or give up, after no reply could be
+   * sent in a receive window.
+   */
+  void OnReplyNotSent (const ReceiveWindow &receiveWindow);
+
   TracedCallback<Ptr<const Packet> > m_receiveWindowOpened;
   Ptr<NetworkStatus> m_status;
   Ptr<NetworkController> m_controller;
+
+  // All opportunities falling in the same tick share a single simulator event
+  TimerWheel<ReceiveWindow> m_receiveWindows; //!< The pending opportunities
+
+  Ptr<DownlinkPlanner> m_planner;        //!< The strategy assigning gateways
+  std::vector<ReceiveWindow> m_batch;    //!< The opportunities of the current tick
+  std::vector<DownlinkPlanner::Request> m_requests; //!< The replies to plan
 };
 
 } /* namespace ns3 */
@@ -57,7 +57,7 @@ NetworkServer::GetTypeId (void)
 NetworkServer::NetworkServer () :
   m_status (Create<NetworkStatus> ()),
   m_controller (Create<NetworkController> (m_status)),
-  m_scheduler (Create<NetworkScheduler> (m_status, m_controller))
+  m_scheduler (CreateObject<NetworkScheduler> (m_status, m_controller))
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -156,20 +156,20 @@ NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << protocol << address);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
+  // Parse the headers of the packet once for all components
+  Ptr<const ParsedUplink> uplink = Create<ParsedUplink> (packet);
 
   // Fire the trace source
   m_receivedPacket (packet);
 
   // Inform the scheduler of the newly arrived packet
-  m_scheduler->OnReceivedPacket (packet);
+  m_scheduler->OnReceivedPacket (uplink);
 
   // Inform the status of the newly arrived packet
-  m_status->OnReceivedPacket (packet, address);
+  m_status->OnReceivedPacket (uplink, address);
 
   // Inform the controller of the newly arrived packet
-  m_controller->OnNewPacket (packet);
+  m_controller->OnNewPacket (uplink);
 
   return true;
 }
@@ -188,5 +188,11 @@ NetworkServer::GetNetworkStatus (void)
   return m_status;
 }
 
+Ptr<NetworkScheduler>
+NetworkServer::GetNetworkScheduler (void)
+{
+  return m_scheduler;
+}
+
 }
 }
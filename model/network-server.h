@@ -100,6 +100,11 @@ public:
 
   Ptr<NetworkStatus> GetNetworkStatus (void);
 
+  /**
+   * Get the NetworkScheduler, for example to configure its DownlinkPlanner.
+   */
+  Ptr<NetworkScheduler> GetNetworkScheduler (void);
+
 protected:
   Ptr<NetworkStatus> m_status;
   Ptr<NetworkController> m_controller;
@@ -63,15 +63,14 @@ NetworkStatus::AddNode (Ptr<ClassAEndDeviceLorawanMac> edMac)
 
   // Check whether this device already exists in our list
   LoraDeviceAddress edAddress = edMac->GetDeviceAddress ();
-  if (m_endDeviceStatuses.find (edAddress) == m_endDeviceStatuses.end ())
+  if (m_endDeviceStatuses.Find (edAddress) == 0)
     {
       // The device doesn't exist. Create new EndDeviceStatus
       Ptr<EndDeviceStatus> edStatus = CreateObject<EndDeviceStatus>
         (edAddress, edMac->GetObject<ClassAEndDeviceLorawanMac>());
 
-      // Add it to the map
-      m_endDeviceStatuses.insert (std::pair<LoraDeviceAddress, Ptr<EndDeviceStatus> >
-                                  (edAddress, edStatus));
+      // Add it to the table
+      m_endDeviceStatuses.Insert (edAddress, edStatus);
       NS_LOG_DEBUG ("Added to the list a device with address " <<
                     edAddress.Print ());
     }
@@ -90,74 +89,50 @@ NetworkStatus::AddGateway (Address& address, Ptr<GatewayStatus> gwStatus)
       // Add it to the map
       m_gatewayStatuses.insert (std::pair<Address, Ptr<GatewayStatus> >
                                 (address, gwStatus));
+      m_gatewayIndices[address] = m_gateways.size ();
+      m_gateways.push_back (gwStatus);
       NS_LOG_DEBUG ("Added to the list a gateway with address " << address);
     }
 }
 
 void
-NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
+NetworkStatus::OnReceivedPacket (Ptr<const ParsedUplink> uplink,
                                   const Address& gwAddress)
 {
-  NS_LOG_FUNCTION (this << packet << gwAddress);
-
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
-  // Extract the headers
-  LorawanMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-  LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+  NS_LOG_FUNCTION (this << uplink->GetPacket () << gwAddress);
 
   // Update the correct EndDeviceStatus object
-  LoraDeviceAddress edAddr = frameHdr.GetAddress ();
+  LoraDeviceAddress edAddr = uplink->GetAddress ();
   NS_LOG_DEBUG ("Node address: " << edAddr);
-  m_endDeviceStatuses.at (edAddr)->InsertReceivedPacket (packet, gwAddress);
+  GetKnownEndDeviceStatus (edAddr)->InsertReceivedPacket (uplink, gwAddress,
+                                                          m_gatewayIndices.at (gwAddress));
 }
 
 bool
 NetworkStatus::NeedsReply (LoraDeviceAddress deviceAddress)
 {
-  // Throws out of range if no device is found
-  return m_endDeviceStatuses.at (deviceAddress)->NeedsReply ();
+  return GetKnownEndDeviceStatus (deviceAddress)->NeedsReply ();
 }
 
 Address
 NetworkStatus::GetBestGatewayForDevice (LoraDeviceAddress deviceAddress, int window)
 {
   // Get the endDeviceStatus we are interested in
-  Ptr<EndDeviceStatus> edStatus = m_endDeviceStatuses.at (deviceAddress);
-  double replyFrequency;
-  if (window == 1)
-    {
-      replyFrequency = edStatus->GetFirstReceiveWindowFrequency();
-    }
-  else if (window == 2)
-    {
-      replyFrequency = edStatus->GetSecondReceiveWindowFrequency();
-    }
-  else
-    {
-      NS_ABORT_MSG ("Invalid window value");
-    }
+  Ptr<EndDeviceStatus> edStatus = GetKnownEndDeviceStatus (deviceAddress);
+  double replyFrequency = GetReplyFrequency (edStatus, window);
 
-  // Get the list of gateways that this device can reach
+  // Go through the gateways that received the last packet of this device,
+  // from the 'best' one, i.e. the one with the highest received power, to the
+  // worst, and pick the first one that can transmit.
   // NOTE: At this point, we could also take into account the whole network to
-  // identify the best gateway according to various metrics. For now, we just
-  // ask the EndDeviceStatus to pick the best gateway for us via its method.
-  std::map<double, Address> gwAddresses = edStatus->GetPowerGatewayMap ();
-
-  // By iterating on the map in reverse, we go from the 'best'
-  // gateway, i.e. the one with the highest received power, to the
-  // worst.
+  // identify the best gateway according to various metrics.
   Address bestGwAddress;
-  for (auto it = gwAddresses.rbegin(); it != gwAddresses.rend(); it++)
+  for (std::size_t rank = 0; rank < edStatus->GetBestGatewayCount (); rank++)
     {
-      bool isAvailable = m_gatewayStatuses.find(it->second)->second->IsAvailableForTransmission (replyFrequency);
-      if (isAvailable)
+      Ptr<GatewayStatus> gwStatus = m_gateways[edStatus->GetBestGateway (rank)];
+      if (gwStatus->IsAvailableForTransmission (replyFrequency))
         {
-          bestGwAddress = it->second;
+          bestGwAddress = gwStatus->GetAddress ();
           break;
         }
     }
@@ -165,6 +140,38 @@ NetworkStatus::GetBestGatewayForDevice (LoraDeviceAddress deviceAddress, int win
   return bestGwAddress;
 }
 
+void
+NetworkStatus::GetAvailableGatewaysForDevice (LoraDeviceAddress deviceAddress,
+                                              int window,
+                                              std::vector<uint32_t> &gateways)
+{
+  Ptr<EndDeviceStatus> edStatus = GetKnownEndDeviceStatus (deviceAddress);
+  double replyFrequency = GetReplyFrequency (edStatus, window);
+
+  gateways.clear ();
+  for (std::size_t rank = 0; rank < edStatus->GetBestGatewayCount (); rank++)
+    {
+      uint32_t gwIndex = edStatus->GetBestGateway (rank);
+      if (m_gateways[gwIndex]->IsAvailableForTransmission (replyFrequency))
+        {
+          gateways.push_back (gwIndex);
+        }
+    }
+}
+
+uint32_t
+NetworkStatus::GetGatewayCount (void) const
+{
+  return m_gateways.size ();
+}
+
+Ptr<GatewayStatus>
+NetworkStatus::GetGatewayStatus (uint32_t index)
+{
+  NS_ASSERT (index < m_gateways.size ());
+  return m_gateways[index];
+}
+
 void
 NetworkStatus::SendThroughGateway (Ptr<Packet> packet, Address gwAddress)
 {
@@ -179,7 +186,7 @@ Ptr<Packet>
 NetworkStatus::GetReplyForDevice (LoraDeviceAddress edAddress, int windowNumber)
 {
   // Get the reply packet
-  Ptr<EndDeviceStatus> edStatus = m_endDeviceStatuses.find (edAddress)->second;
+  Ptr<EndDeviceStatus> edStatus = GetKnownEndDeviceStatus (edAddress);
   Ptr<Packet> packet = edStatus->GetCompleteReplyPacket ();
 
   // Apply the appropriate tag
@@ -211,10 +218,10 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
   Ptr<Packet> myPacket = packet->Copy ();
   myPacket->RemoveHeader (mHdr);
   myPacket->RemoveHeader (fHdr);
-  auto it = m_endDeviceStatuses.find (fHdr.GetAddress ());
-  if (it != m_endDeviceStatuses.end ())
+  Ptr<EndDeviceStatus> *status = m_endDeviceStatuses.Find (fHdr.GetAddress ());
+  if (status != 0)
     {
-      return (*it).second;
+      return *status;
     }
   else
     {
@@ -228,10 +235,10 @@ NetworkStatus::GetEndDeviceStatus (LoraDeviceAddress address)
 {
   NS_LOG_FUNCTION (this << address);
 
-  auto it = m_endDeviceStatuses.find (address);
-  if (it != m_endDeviceStatuses.end ())
+  Ptr<EndDeviceStatus> *status = m_endDeviceStatuses.Find (address);
+  if (status != 0)
     {
-      return (*it).second;
+      return *status;
     }
   else
     {
@@ -245,7 +252,30 @@ NetworkStatus::CountEndDevices (void)
 {
   NS_LOG_FUNCTION (this);
 
-  return m_endDeviceStatuses.size ();
+  return m_endDeviceStatuses.GetSize ();
+}
+
+Ptr<EndDeviceStatus>
+NetworkStatus::GetKnownEndDeviceStatus (LoraDeviceAddress address)
+{
+  Ptr<EndDeviceStatus> *status = m_endDeviceStatuses.Find (address);
+  NS_ABORT_MSG_IF (status == 0, "Device " << address << " is not managed by the server");
+  return *status;
+}
+
+double
+NetworkStatus::GetReplyFrequency (Ptr<EndDeviceStatus> edStatus, int window)
+{
+  if (window == 1)
+    {
+      return edStatus->GetFirstReceiveWindowFrequency();
+    }
+  else if (window == 2)
+    {
+      return edStatus->GetSecondReceiveWindowFrequency();
+    }
+  NS_ABORT_MSG ("Invalid window value");
+  return 0;
 }
 }
 }
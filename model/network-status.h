@@ -28,6 +28,7 @@
 #include "ns3/gateway-status.h"
 #include "ns3/lora-device-address.h"
 #include "ns3/network-scheduler.h"
+#include "ns3/device-address-table.h"
 
 #include <iterator>
 
@@ -38,7 +39,8 @@ namespace lorawan {
  * This class represents the knowledge about the state of the network that is
  * available at the Network Server. It is essentially a collection of two maps:
  * one containing DeviceStatus objects, and the other containing GatewayStatus
- * objects.
+ * objects. Devices are kept in a DeviceAddressTable, so that looking them up
+ * takes constant time even in networks with millions of devices.
  *
  * This class is meant to be queried by NetworkController components, which
  * can decide to take action based on the current status of the network.
@@ -59,17 +61,19 @@ public:
   /**
    * Add this gateway to the list of gateways connected to the network.
    *
-   * Each GW is identified by its Address in the NS-GW network.
+   * Each GW is identified by its Address in the NS-GW network, and is given a
+   * dense index (in order of addition) which EndDeviceStatus objects use to
+   * refer to it.
    */
   void AddGateway (Address &address, Ptr<GatewayStatus> gwStatus);
 
   /**
    * Update network status on the received packet.
    *
-   * \param packet the received packet.
+   * \param uplink the received packet, as parsed by the NetworkServer.
    * \param address the gateway this packet was received from.
    */
-  void OnReceivedPacket (Ptr<const Packet> packet, const Address &gwaddress);
+  void OnReceivedPacket (Ptr<const ParsedUplink> uplink, const Address &gwaddress);
 
   /**
    * Return whether the specified device needs a reply.
@@ -86,6 +90,27 @@ public:
    */
   Address GetBestGatewayForDevice (LoraDeviceAddress deviceAddress, int window);
 
+  /**
+   * Get all the gateways that are available to send a reply to the specified
+   * device, from the best to the worst.
+   *
+   * \param deviceAddress the address of the device we are interested in.
+   * \param window the receive window the reply would be sent in.
+   * \param gateways the vector that is filled with the gateway indices.
+   */
+  void GetAvailableGatewaysForDevice (LoraDeviceAddress deviceAddress, int window,
+                                      std::vector<uint32_t> &gateways);
+
+  /**
+   * Return the number of gateways connected to the network.
+   */
+  uint32_t GetGatewayCount (void) const;
+
+  /**
+   * Get the GatewayStatus of the gateway with the specified index.
+   */
+  Ptr<GatewayStatus> GetGatewayStatus (uint32_t index);
+
   /**
    * Send a packet through a Gateway.
    *
@@ -116,8 +141,22 @@ public:
   int CountEndDevices (void);
 
 public:
-  std::map<LoraDeviceAddress, Ptr<EndDeviceStatus>> m_endDeviceStatuses;
+  DeviceAddressTable<Ptr<EndDeviceStatus>> m_endDeviceStatuses;
   std::map<Address, Ptr<GatewayStatus>> m_gatewayStatuses;
+
+private:
+  /**
+   * Get the EndDeviceStatus of a device that must be known to the server.
+   */
+  Ptr<EndDeviceStatus> GetKnownEndDeviceStatus (LoraDeviceAddress address);
+
+  /**
+   * Get the frequency of a receive window of a device.
+   */
+  double GetReplyFrequency (Ptr<EndDeviceStatus> edStatus, int window);
+
+  std::vector<Ptr<GatewayStatus>> m_gateways; //!< The gateways, by index
+  std::map<Address, uint32_t> m_gatewayIndices; //!< The index of each gateway
 };
 
 } // namespace lorawan
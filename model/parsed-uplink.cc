@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/parsed-uplink.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("ParsedUplink");
+
+ParsedUplink::ParsedUplink (Ptr<const Packet> packet) :
+  m_packet (packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+
+  // The frame header can only be reached by removing the MAC header, so a
+  // (copy-on-write) copy of the packet is needed here. This is the only one
+  // made while the NetworkServer processes the packet.
+  Ptr<Packet> myPacket = packet->Copy ();
+  LorawanMacHeader macHdr;
+  myPacket->RemoveHeader (macHdr);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  myPacket->RemoveHeader (frameHdr);
+
+  m_mType = macHdr.GetMType ();
+  m_address = frameHdr.GetAddress ();
+  m_fCnt = frameHdr.GetFCnt ();
+  m_adr = frameHdr.GetAdr ();
+  m_commands = frameHdr.GetCommands ();
+
+  LoraTag tag;
+  packet->PeekPacketTag (tag);
+  m_spreadingFactor = tag.GetSpreadingFactor ();
+  m_frequency = tag.GetFrequency ();
+  m_receivePower = tag.GetReceivePower ();
+
+  NS_LOG_DEBUG ("Parsed uplink from " << m_address << " with FCnt " << m_fCnt);
+}
+
+Ptr<const Packet>
+ParsedUplink::GetPacket (void) const
+{
+  return m_packet;
+}
+
+uint8_t
+ParsedUplink::GetMType (void) const
+{
+  return m_mType;
+}
+
+LoraDeviceAddress
+ParsedUplink::GetAddress (void) const
+{
+  return m_address;
+}
+
+uint16_t
+ParsedUplink::GetFCnt (void) const
+{
+  return m_fCnt;
+}
+
+bool
+ParsedUplink::GetAdr (void) const
+{
+  return m_adr;
+}
+
+const std::list<Ptr<MacCommand> > &
+ParsedUplink::GetCommands (void) const
+{
+  return m_commands;
+}
+
+uint8_t
+ParsedUplink::GetSpreadingFactor (void) const
+{
+  return m_spreadingFactor;
+}
+
+double
+ParsedUplink::GetFrequency (void) const
+{
+  return m_frequency;
+}
+
+double
+ParsedUplink::GetReceivePower (void) const
+{
+  return m_receivePower;
+}
+
+} // namespace lorawan
+} // namespace ns3
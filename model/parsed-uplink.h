@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARSED_UPLINK_H
+#define PARSED_UPLINK_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/packet.h"
+#include "ns3/lora-device-address.h"
+#include "ns3/mac-command.h"
+
+#include <list>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The content of an uplink packet received by the NetworkServer.
+ *
+ * The headers and the LoraTag of an uplink are parsed once, when the packet
+ * reaches the NetworkServer, and the result is shared by NetworkStatus,
+ * EndDeviceStatus, NetworkScheduler and the NetworkController components, so
+ * that none of them has to copy the packet to look at its headers.
+ */
+class ParsedUplink : public SimpleRefCount<ParsedUplink>
+{
+public:
+  /**
+   * Parse an uplink packet, as forwarded to the NetworkServer by a gateway.
+   *
+   * \param packet The packet, starting with its LorawanMacHeader and
+   * carrying a LoraTag.
+   */
+  ParsedUplink (Ptr<const Packet> packet);
+
+  /**
+   * Get the packet this information was parsed from.
+   */
+  Ptr<const Packet> GetPacket (void) const;
+
+  /**
+   * Get the message type of the MAC header.
+   */
+  uint8_t GetMType (void) const;
+
+  /**
+   * Get the address of the device that sent the packet.
+   */
+  LoraDeviceAddress GetAddress (void) const;
+
+  /**
+   * Get the frame counter of the packet.
+   */
+  uint16_t GetFCnt (void) const;
+
+  /**
+   * Get the value of the ADR bit of the frame header.
+   */
+  bool GetAdr (void) const;
+
+  /**
+   * Get the MAC commands contained in the frame header.
+   */
+  const std::list<Ptr<MacCommand> > &GetCommands (void) const;
+
+  /**
+   * Get the first MAC command of a certain type contained in the frame
+   * header.
+   *
+   * \return The command, or 0 if the packet contains no command of this type.
+   */
+  template <typename T>
+  inline Ptr<T> GetMacCommand (void) const;
+
+  /**
+   * Get the spreading factor the packet was received with.
+   */
+  uint8_t GetSpreadingFactor (void) const;
+
+  /**
+   * Get the frequency the packet was received on.
+   */
+  double GetFrequency (void) const;
+
+  /**
+   * Get the power the packet was received with by the gateway that forwarded
+   * it.
+   */
+  double GetReceivePower (void) const;
+
+private:
+  Ptr<const Packet> m_packet; //!< The parsed packet
+  uint8_t m_mType; //!< The message type
+  LoraDeviceAddress m_address; //!< The address of the sender
+  uint16_t m_fCnt; //!< The frame counter
+  bool m_adr; //!< The ADR bit
+  std::list<Ptr<MacCommand> > m_commands; //!< The MAC commands
+  uint8_t m_spreadingFactor; //!< The spreading factor from the LoraTag
+  double m_frequency; //!< The frequency from the LoraTag
+  double m_receivePower; //!< The reception power from the LoraTag
+};
+
+template <typename T>
+Ptr<T>
+ParsedUplink::GetMacCommand (void) const
+{
+  for (auto it = m_commands.begin (); it != m_commands.end (); ++it)
+    {
+      if ((*it)->GetObject<T> () != 0)
+        {
+          return (*it)->GetObject<T> ();
+        }
+    }
+  return 0;
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* PARSED_UPLINK_H */
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/regional-channel-plan.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("RegionalChannelPlan");
+
+RegionalChannelPlan::RegionalChannelPlan ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+RegionalChannelPlan::AddSubBand (Ptr<SubBand> subBand)
+{
+  NS_LOG_FUNCTION (this << subBand);
+
+  m_subBands.push_back (subBand);
+
+  // Channels that were added before their SubBand belong to this one now
+  for (uint32_t i = 0; i < m_channels.size (); i++)
+    {
+      if (m_channelSubBands[i] == NO_SUB_BAND)
+        {
+          m_channelSubBands[i] = GetSubBandIndex (m_channels[i]->GetFrequency ());
+        }
+    }
+}
+
+void
+RegionalChannelPlan::AddChannel (Ptr<LogicalLoraChannel> channel)
+{
+  NS_LOG_FUNCTION (this << channel);
+
+  channel->SetReadOnly ();
+  m_channels.push_back (channel);
+  m_channelSubBands.push_back (GetSubBandIndex (channel->GetFrequency ()));
+}
+
+void
+RegionalChannelPlan::SetChannel (uint32_t chIndex, Ptr<LogicalLoraChannel> channel)
+{
+  NS_LOG_FUNCTION (this << chIndex << channel);
+
+  channel->SetReadOnly ();
+  m_channels.at (chIndex) = channel;
+  m_channelSubBands.at (chIndex) = GetSubBandIndex (channel->GetFrequency ());
+}
+
+void
+RegionalChannelPlan::RemoveChannel (uint32_t chIndex)
+{
+  NS_LOG_FUNCTION (this << chIndex);
+
+  NS_ASSERT (chIndex < m_channels.size ());
+  m_channels.erase (m_channels.begin () + chIndex);
+  m_channelSubBands.erase (m_channelSubBands.begin () + chIndex);
+}
+
+const std::vector<Ptr<SubBand> > &
+RegionalChannelPlan::GetSubBands (void) const
+{
+  return m_subBands;
+}
+
+const std::vector<Ptr<LogicalLoraChannel> > &
+RegionalChannelPlan::GetChannels (void) const
+{
+  return m_channels;
+}
+
+int
+RegionalChannelPlan::GetSubBandIndex (double frequency) const
+{
+  for (uint32_t i = 0; i < m_subBands.size (); i++)
+    {
+      if (m_subBands[i]->BelongsToSubBand (frequency))
+        {
+          return i;
+        }
+    }
+  return NO_SUB_BAND;
+}
+
+int
+RegionalChannelPlan::GetChannelSubBandIndex (uint32_t chIndex) const
+{
+  return m_channelSubBands.at (chIndex);
+}
+
+bool
+RegionalChannelPlan::IsShared (void) const
+{
+  return GetReferenceCount () > 1;
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef REGIONAL_CHANNEL_PLAN_H
+#define REGIONAL_CHANNEL_PLAN_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/logical-lora-channel.h"
+#include "ns3/sub-band.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The SubBands and the LogicalLoraChannels of a region, with the index of the
+ * SubBand of each channel.
+ *
+ * A plan is shared by the LogicalLoraChannelHelper of all the devices that
+ * use it, which keep their own enabled channels and duty cycle timers. Once
+ * it is shared, a plan must not be modified: LogicalLoraChannelHelper copies
+ * it before changing its channels or SubBands (see IsShared). For the same
+ * reason, the state of the SubBand and LogicalLoraChannel objects of a plan is
+ * not used by the helper after they are added, and channels are made
+ * read-only when they are added to a plan.
+ */
+class RegionalChannelPlan : public SimpleRefCount<RegionalChannelPlan>
+{
+public:
+  static const int NO_SUB_BAND = -1; //!< The index of unknown SubBands
+
+  RegionalChannelPlan ();
+
+  /**
+   * Add a SubBand to the plan.
+   *
+   * Channels that were added before a SubBand they belong to are assigned to
+   * it.
+   *
+   * \param subBand The SubBand to add.
+   */
+  void AddSubBand (Ptr<SubBand> subBand);
+
+  /**
+   * Add a channel at the end of the plan.
+   *
+   * \param channel The channel to add.
+   */
+  void AddChannel (Ptr<LogicalLoraChannel> channel);
+
+  /**
+   * Replace the channel at a given index.
+   *
+   * \param chIndex The index of the channel to replace.
+   * \param channel The new channel.
+   */
+  void SetChannel (uint32_t chIndex, Ptr<LogicalLoraChannel> channel);
+
+  /**
+   * Remove the channel at a given index, moving the following ones down.
+   *
+   * \param chIndex The index of the channel to remove.
+   */
+  void RemoveChannel (uint32_t chIndex);
+
+  /**
+   * \return The SubBands of the plan.
+   */
+  const std::vector<Ptr<SubBand> > &GetSubBands (void) const;
+
+  /**
+   * \return The channels of the plan.
+   */
+  const std::vector<Ptr<LogicalLoraChannel> > &GetChannels (void) const;
+
+  /**
+   * Get the index of the SubBand a frequency belongs to.
+   *
+   * \param frequency The frequency we want to check.
+   * \return The index of the SubBand, or NO_SUB_BAND if the frequency is
+   * outside any known SubBand.
+   */
+  int GetSubBandIndex (double frequency) const;
+
+  /**
+   * Get the index of the SubBand of a channel.
+   *
+   * \param chIndex The index of the channel.
+   * \return The index of the SubBand, or NO_SUB_BAND if the channel is
+   * outside any known SubBand.
+   */
+  int GetChannelSubBandIndex (uint32_t chIndex) const;
+
+  /**
+   * \return Whether the plan is used by more than one owner, and must be
+   * copied before being modified.
+   */
+  bool IsShared (void) const;
+
+private:
+  std::vector<Ptr<SubBand> > m_subBands; //!< The SubBands of the region
+  std::vector<Ptr<LogicalLoraChannel> > m_channels; //!< The channels
+  std::vector<int> m_channelSubBands; //!< The SubBand index of each channel
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* REGIONAL_CHANNEL_PLAN_H */
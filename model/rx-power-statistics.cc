@@ -0,0 +1,199 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/rx-power-statistics.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("RxPowerStatistics");
+
+RxPowerStatistics::RxPowerStatistics () :
+  m_windowLength (1),
+  m_oldest (0),
+  m_count (0),
+  m_lastReceptions (0),
+  m_lastSum (0),
+  m_lastMin (0),
+  m_lastMax (0)
+{
+  m_sum.fill (0);
+  m_min.fill (0);
+  m_max.fill (0);
+}
+
+void
+RxPowerStatistics::SetWindowLength (std::size_t length)
+{
+  NS_LOG_FUNCTION (this << length);
+
+  length = std::max<std::size_t> (length, 1);
+  if (length == m_windowLength)
+    {
+      return;
+    }
+
+  // Keep the most recent packets that fit in the new ring buffer, from the
+  // oldest one in slot 0
+  std::size_t kept = std::min (m_count, length - 1);
+  std::vector<CombinedPower> window (length - 1);
+  for (std::size_t i = 0; i < kept; i++)
+    {
+      window[i] = m_window[(m_oldest + m_count - kept + i) % m_window.size ()];
+    }
+  m_window.swap (window);
+  m_windowLength = length;
+  m_oldest = 0;
+  m_count = kept;
+  UpdateAggregates ();
+}
+
+std::size_t
+RxPowerStatistics::GetWindowLength (void) const
+{
+  return m_windowLength;
+}
+
+void
+RxPowerStatistics::AddPacket (double rxPower)
+{
+  // Move the previous packet to the ring buffer, now that it cannot be
+  // received by other gateways anymore
+  if (m_lastReceptions > 0 && !m_window.empty ())
+    {
+      CombinedPower last = GetLastPacketPower ();
+      if (m_count < m_window.size ())
+        {
+          m_window[(m_oldest + m_count) % m_window.size ()] = last;
+          m_count++;
+          for (int method = 0; method < N_COMBINING_METHODS; method++)
+            {
+              m_sum[method] += last[method];
+              m_min[method] = m_count > 1 ? std::min (m_min[method], last[method]) : last[method];
+              m_max[method] = m_count > 1 ? std::max (m_max[method], last[method]) : last[method];
+            }
+        }
+      else
+        {
+          // Replace the oldest packet. The extremes need to be computed again
+          // only if they could have been given by that packet.
+          CombinedPower evicted = m_window[m_oldest];
+          m_window[m_oldest] = last;
+          m_oldest = (m_oldest + 1) % m_window.size ();
+          bool extremeEvicted = false;
+          for (int method = 0; method < N_COMBINING_METHODS; method++)
+            {
+              extremeEvicted |= evicted[method] <= m_min[method];
+              extremeEvicted |= evicted[method] >= m_max[method];
+            }
+          if (extremeEvicted)
+            {
+              UpdateAggregates ();
+            }
+          else
+            {
+              for (int method = 0; method < N_COMBINING_METHODS; method++)
+                {
+                  m_sum[method] += last[method] - evicted[method];
+                  m_min[method] = std::min (m_min[method], last[method]);
+                  m_max[method] = std::max (m_max[method], last[method]);
+                }
+            }
+        }
+    }
+
+  m_lastReceptions = 1;
+  m_lastSum = rxPower;
+  m_lastMin = rxPower;
+  m_lastMax = rxPower;
+}
+
+void
+RxPowerStatistics::AddReception (double rxPower)
+{
+  NS_ASSERT (m_lastReceptions > 0);
+
+  m_lastReceptions++;
+  m_lastSum += rxPower;
+  m_lastMin = std::min (m_lastMin, rxPower);
+  m_lastMax = std::max (m_lastMax, rxPower);
+}
+
+std::size_t
+RxPowerStatistics::GetPacketCount (void) const
+{
+  return m_count + (m_lastReceptions > 0 ? 1 : 0);
+}
+
+double
+RxPowerStatistics::GetRxPower (CombiningMethod gateways, CombiningMethod packets) const
+{
+  NS_ASSERT (m_lastReceptions > 0);
+  NS_ASSERT (gateways < N_COMBINING_METHODS);
+
+  double last = GetLastPacketPower ()[gateways];
+  if (m_count == 0)
+    {
+      return last;
+    }
+
+  switch (packets)
+    {
+    case AVERAGE:
+      return (m_sum[gateways] + last) / (m_count + 1);
+    case MAXIMUM:
+      return std::max (m_max[gateways], last);
+    case MINIMUM:
+      return std::min (m_min[gateways], last);
+    default:
+      NS_ABORT_MSG ("Invalid combining method");
+      return 0;
+    }
+}
+
+RxPowerStatistics::CombinedPower
+RxPowerStatistics::GetLastPacketPower (void) const
+{
+  CombinedPower power;
+  power[AVERAGE] = m_lastSum / m_lastReceptions;
+  power[MAXIMUM] = m_lastMax;
+  power[MINIMUM] = m_lastMin;
+  return power;
+}
+
+void
+RxPowerStatistics::UpdateAggregates (void)
+{
+  // The sums are computed again too, so that rounding errors don't build up
+  for (int method = 0; method < N_COMBINING_METHODS; method++)
+    {
+      m_sum[method] = 0;
+      for (std::size_t i = 0; i < m_count; i++)
+        {
+          double value = m_window[(m_oldest + i) % m_window.size ()][method];
+          m_sum[method] += value;
+          m_min[method] = i > 0 ? std::min (m_min[method], value) : value;
+          m_max[method] = i > 0 ? std::max (m_max[method], value) : value;
+        }
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
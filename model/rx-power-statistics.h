@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RX_POWER_STATISTICS_H
+#define RX_POWER_STATISTICS_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Rolling statistics of the power at which the last packets of a device were
+ * received by the gateways.
+ *
+ * The power of each packet is first combined over the gateways that received
+ * it (taking the average, the maximum or the minimum), and the combined
+ * values are then combined over the last packets in a window of fixed length.
+ * All nine combinations are kept up to date as receptions are added, so that
+ * they can be read in constant time.
+ *
+ * The most recent packet may still be received by other gateways, so it is
+ * kept apart. Its combined values are only moved to the window once a newer
+ * packet arrives.
+ */
+class RxPowerStatistics
+{
+public:
+  /**
+   * The ways a set of values can be combined.
+   */
+  enum CombiningMethod
+  {
+    AVERAGE,
+    MAXIMUM,
+    MINIMUM,
+    N_COMBINING_METHODS
+  };
+
+  RxPowerStatistics ();
+
+  /**
+   * Set the number of packets the statistics are computed on, keeping the
+   * most recent packets that fit in the new window.
+   *
+   * \param length The length of the window, at least 1.
+   */
+  void SetWindowLength (std::size_t length);
+
+  /**
+   * \return The number of packets the statistics are computed on.
+   */
+  std::size_t GetWindowLength (void) const;
+
+  /**
+   * Add a new packet, received by a first gateway.
+   *
+   * \param rxPower The power at which the gateway received the packet (dBm).
+   */
+  void AddPacket (double rxPower);
+
+  /**
+   * Add the reception of the most recent packet by another gateway.
+   *
+   * \param rxPower The power at which the gateway received the packet (dBm).
+   */
+  void AddReception (double rxPower);
+
+  /**
+   * \return The number of packets in the window, including the most recent
+   * one.
+   */
+  std::size_t GetPacketCount (void) const;
+
+  /**
+   * Get the receive power of the packets in the window. Must not be called
+   * before a packet is added.
+   *
+   * \param gateways How to combine the powers of the gateways that received
+   * each packet.
+   * \param packets How to combine the powers of the packets in the window.
+   * \return The combined power (dBm).
+   */
+  double GetRxPower (CombiningMethod gateways, CombiningMethod packets) const;
+
+private:
+  /**
+   * The powers of a packet, combined over its gateways with each method.
+   */
+  typedef std::array<double, N_COMBINING_METHODS> CombinedPower;
+
+  /**
+   * Get the powers of the most recent packet, combined over its gateways.
+   */
+  CombinedPower GetLastPacketPower (void) const;
+
+  /**
+   * Compute the aggregates of the window from scratch.
+   */
+  void UpdateAggregates (void);
+
+  // The packets before the most recent one, in a ring buffer of length
+  // m_windowLength - 1
+  std::vector<CombinedPower> m_window; //!< The ring buffer
+  std::size_t m_windowLength;  //!< The number of packets in a full window
+  std::size_t m_oldest;        //!< The slot of the oldest packet
+  std::size_t m_count;         //!< The number of packets in the ring buffer
+
+  // Aggregates of the ring buffer, for each method of combining gateways
+  CombinedPower m_sum; //!< The sums of the packets' powers
+  CombinedPower m_min; //!< The minimum of the packets' powers
+  CombinedPower m_max; //!< The maximum of the packets' powers
+
+  // The receptions of the most recent packet
+  std::size_t m_lastReceptions; //!< The number of gateways, or 0 if none
+  double m_lastSum;  //!< The sum of the receive powers
+  double m_lastMin;  //!< The minimum receive power
+  double m_lastMax;  //!< The maximum receive power
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* RX_POWER_STATISTICS_H */
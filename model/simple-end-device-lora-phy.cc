@@ -102,7 +102,7 @@ SimpleEndDeviceLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams,
   // Call the trace source
   if (m_device)
     {
-      m_startSending (packet, m_device->GetNode ()->GetId ());
+      m_startSending (packet, GetNodeId ());
     }
   else
     {
@@ -124,10 +124,14 @@ SimpleEndDeviceLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
   //
   // We need to do this regardless of our state or frequency, since these could
   // change (and making the interference relevant) while the interference is
-  // still incoming.
+  // still incoming. The exception is when the channel keeps a shared log of
+  // transmissions, which we use instead if we start listening again.
 
   Ptr<LoraInterferenceHelper::Event> event;
-  event = m_interference.Add (duration, rxPowerDbm, sf, packet, frequencyMHz);
+  if (IsTrackingInterference ())
+    {
+      event = m_interference.Add (duration, rxPowerDbm, sf, packet, frequencyMHz);
+    }
 
   // Switch on the current PHY state
   switch (m_state)
@@ -177,7 +181,7 @@ SimpleEndDeviceLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
             // Fire the trace source for this event.
             if (m_device)
               {
-                m_wrongFrequency (packet, m_device->GetNode ()->GetId ());
+                m_wrongFrequency (packet, GetNodeId ());
               }
             else
               {
@@ -197,7 +201,7 @@ SimpleEndDeviceLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
             // Fire the trace source for this event.
             if (m_device)
               {
-                m_wrongSf (packet, m_device->GetNode ()->GetId ());
+                m_wrongSf (packet, GetNodeId ());
               }
             else
               {
@@ -218,7 +222,7 @@ SimpleEndDeviceLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
             // Fire the trace source for this event.
             if (m_device)
               {
-                m_underSensitivity (packet, m_device->GetNode ()->GetId ());
+                m_underSensitivity (packet, GetNodeId ());
               }
             else
               {
@@ -273,7 +277,7 @@ SimpleEndDeviceLoraPhy::EndReceive (Ptr<Packet> packet,
 
       if (m_device)
         {
-          m_interferedPacket (packet, m_device->GetNode ()->GetId ());
+          m_interferedPacket (packet, GetNodeId ());
         }
       else
         {
@@ -294,7 +298,7 @@ SimpleEndDeviceLoraPhy::EndReceive (Ptr<Packet> packet,
 
       if (m_device)
         {
-          m_successfullyReceivedPacket (packet, m_device->GetNode ()->GetId ());
+          m_successfullyReceivedPacket (packet, GetNodeId ());
         }
       else
         {
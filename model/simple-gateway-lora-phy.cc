@@ -80,7 +80,7 @@ SimpleGatewayLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams, doubl
           if (m_device)
             {
               m_noReceptionBecauseTransmitting (currentPath->GetEvent ()->GetPacket (),
-                                                m_device->GetNode ()->GetId ());
+                                                GetNodeId ());
             }
           else
             {
@@ -106,7 +106,7 @@ SimpleGatewayLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams, doubl
   // Fire the trace source
   if (m_device)
     {
-      m_startSending (packet, m_device->GetNode ()->GetId ());
+      m_startSending (packet, GetNodeId ());
     }
   else
     {
@@ -134,7 +134,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8
       // Fire the trace source
       if (m_device)
         {
-          m_noReceptionBecauseTransmitting (packet, m_device->GetNode ()->GetId ());
+          m_noReceptionBecauseTransmitting (packet, GetNodeId ());
         }
       else
         {
@@ -171,7 +171,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8
 
               if (m_device)
                 {
-                  m_underSensitivity (packet, m_device->GetNode ()->GetId ());
+                  m_underSensitivity (packet, GetNodeId ());
                 }
               else
                 {
@@ -210,7 +210,7 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm, uint8
   // Fire the trace source
   if (m_device)
     {
-      m_noMoreDemodulators (packet, m_device->GetNode ()->GetId ());
+      m_noMoreDemodulators (packet, GetNodeId ());
     }
   else
     {
@@ -246,7 +246,7 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet, Ptr<LoraInterferenceHelper
       // Fire the trace source
       if (m_device)
         {
-          m_interferedPacket (packet, m_device->GetNode ()->GetId ());
+          m_interferedPacket (packet, GetNodeId ());
         }
       else
         {
@@ -261,7 +261,7 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet, Ptr<LoraInterferenceHelper
       // Fire the trace source
       if (m_device)
         {
-          m_successfullyReceivedPacket (packet, m_device->GetNode ()->GetId ());
+          m_successfullyReceivedPacket (packet, GetNodeId ());
         }
       else
         {
@@ -78,8 +78,9 @@ public:
   /**
    * Update the next transmission time.
    *
-   * This function is used by LogicalLoraChannelHelper, which computes the time
-   * based on the SubBand's duty cycle and on the transmission duration.
+   * LogicalLoraChannelHelper only reads this time when the SubBand is added
+   * to it, and then keeps its own timer, since SubBands can be shared by the
+   * channel plans of multiple devices.
    *
    * \param nextTime The future time from which transmission should be allowed
    * again.
@@ -0,0 +1,307 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A hierarchical timing wheel, which expires large numbers of timers with a
+ * single simulator event per tick.
+ *
+ * Timers are rounded up to the next multiple of the tick, and kept in three
+ * levels of 256 slots each: the first level has a slot per tick, the second
+ * a slot per 256 ticks and the third a slot per 65536 ticks. Timers that are
+ * further in the future wait in an overflow map. When time reaches the span
+ * of a slot of a higher level, its timers are moved to the lower levels.
+ *
+ * Only one simulator event is pending at any time, at the first tick that
+ * has timers. When it runs, the expire callback is called for all the timers
+ * of that tick, in the order they were scheduled, and then the tick callback
+ * is called once, so that users can process the expired timers as a batch.
+ */
+template <typename T>
+class TimerWheel
+{
+public:
+  /**
+   * Create a wheel.
+   *
+   * \param tick The resolution of the timers.
+   */
+  TimerWheel (Time tick = MilliSeconds (1)) :
+    m_tick (tick),
+    m_currentTick (0),
+    m_nextTick (0),
+    m_size (0)
+  {
+    NS_ASSERT (tick.IsStrictlyPositive ());
+  }
+
+  ~TimerWheel ()
+  {
+    Simulator::Cancel (m_event);
+  }
+
+  /**
+   * Set the function called when a timer expires.
+   */
+  void
+  SetExpireCallback (Callback<void, T> expire)
+  {
+    m_expire = expire;
+  }
+
+  /**
+   * Set the function called after all the timers of a tick expired.
+   */
+  void
+  SetTickCallback (Callback<void> tick)
+  {
+    m_tickCallback = tick;
+  }
+
+  /**
+   * Set the resolution of the timers. Can only be called when the wheel is
+   * empty.
+   */
+  void
+  SetTick (Time tick)
+  {
+    NS_ASSERT (m_size == 0);
+    NS_ASSERT (tick.IsStrictlyPositive ());
+    m_tick = tick;
+  }
+
+  /**
+   * \return The resolution of the timers.
+   */
+  Time
+  GetTick (void) const
+  {
+    return m_tick;
+  }
+
+  /**
+   * Schedule a timer.
+   *
+   * \param delay The time after which the timer expires. The timer expires
+   * at the first tick at or after that time.
+   * \param value The value passed to the expire callback.
+   */
+  void
+  Schedule (Time delay, const T &value)
+  {
+    NS_ASSERT (!delay.IsStrictlyNegative ());
+
+    int64_t time = (Simulator::Now () + delay).GetTimeStep ();
+    int64_t tick = m_tick.GetTimeStep ();
+    uint64_t timerTick = uint64_t ((time + tick - 1) / tick);
+
+    // Slots are relative to the current tick, which can be moved forward
+    // freely while the wheel is empty
+    if (m_size == 0)
+      {
+        m_currentTick = uint64_t (Simulator::Now ().GetTimeStep () / tick);
+      }
+    NS_ASSERT (timerTick >= m_currentTick);
+
+    Insert (Timer (timerTick, value));
+    m_size++;
+
+    if (!m_event.IsRunning () || timerTick < m_nextTick)
+      {
+        ScheduleEvent (timerTick);
+      }
+  }
+
+  /**
+   * \return The number of pending timers.
+   */
+  std::size_t
+  GetSize (void) const
+  {
+    return m_size;
+  }
+
+private:
+  static const int LEVELS = 3;    //!< The number of levels of slots
+  static const int SLOT_BITS = 8; //!< The log2 of the number of slots per level
+  static const uint64_t SLOT_MASK = (1 << 8) - 1; //!< The mask of slot indices
+
+  /**
+   * A pending timer.
+   */
+  struct Timer
+  {
+    Timer (uint64_t tick, const T &value) : tick (tick), value (value)
+    {
+    }
+
+    uint64_t tick; //!< The tick at which the timer expires
+    T value;       //!< The value passed to the expire callback
+  };
+
+  /**
+   * Put a timer in the level that covers its tick, with respect to the
+   * current tick.
+   */
+  void
+  Insert (const Timer &timer)
+  {
+    for (int level = 0; level < LEVELS; level++)
+      {
+        int shift = SLOT_BITS * (level + 1);
+        if ((timer.tick >> shift) == (m_currentTick >> shift))
+          {
+            m_slots[level][(timer.tick >> (shift - SLOT_BITS)) & SLOT_MASK].push_back (timer);
+            return;
+          }
+      }
+    m_overflow.insert (std::make_pair (timer.tick, timer));
+  }
+
+  /**
+   * Get the first tick that has timers. Must only be called if there are
+   * pending timers.
+   */
+  uint64_t
+  GetNextTick (void) const
+  {
+    // In the first level, ticks are in the same order as the slots. In
+    // higher levels, the first non-empty slot (after the one of the current
+    // tick, which is always empty) holds the earliest timers.
+    for (int level = 0; level < LEVELS; level++)
+      {
+        int shift = SLOT_BITS * level;
+        uint64_t first = ((m_currentTick >> shift) & SLOT_MASK) + (level > 0 ? 1 : 0);
+        for (uint64_t slot = first; slot <= SLOT_MASK; slot++)
+          {
+            const std::vector<Timer> &timers = m_slots[level][slot];
+            if (timers.empty ())
+              {
+                continue;
+              }
+            uint64_t next = timers.front ().tick;
+            for (auto &timer : timers)
+              {
+                next = std::min (next, timer.tick);
+              }
+            return next;
+          }
+      }
+    NS_ASSERT (!m_overflow.empty ());
+    return m_overflow.begin ()->first;
+  }
+
+  /**
+   * Schedule the simulator event that processes a tick.
+   */
+  void
+  ScheduleEvent (uint64_t tick)
+  {
+    Simulator::Cancel (m_event);
+    m_nextTick = tick;
+    Time at = TimeStep (tick * m_tick.GetTimeStep ());
+    m_event = Simulator::Schedule (at - Simulator::Now (), &TimerWheel<T>::Expire, this);
+  }
+
+  /**
+   * Advance to the tick of the pending event, and expire its timers.
+   */
+  void
+  Expire (void)
+  {
+    uint64_t previous = m_currentTick;
+    m_currentTick = m_nextTick;
+
+    // Move the timers of the slots of the higher levels that now cover the
+    // current tick to the lower levels, starting from the highest one
+    if ((m_currentTick >> (SLOT_BITS * LEVELS)) != (previous >> (SLOT_BITS * LEVELS)))
+      {
+        auto end = m_overflow.upper_bound (m_currentTick | ((1ULL << (SLOT_BITS * LEVELS)) - 1));
+        std::vector<Timer> timers;
+        for (auto it = m_overflow.begin (); it != end; it++)
+          {
+            timers.push_back (it->second);
+          }
+        m_overflow.erase (m_overflow.begin (), end);
+        for (auto &timer : timers)
+          {
+            Insert (timer);
+          }
+      }
+    for (int level = LEVELS - 1; level > 0; level--)
+      {
+        int shift = SLOT_BITS * level;
+        if ((m_currentTick >> shift) != (previous >> shift))
+          {
+            std::vector<Timer> timers;
+            timers.swap (m_slots[level][(m_currentTick >> shift) & SLOT_MASK]);
+            for (auto &timer : timers)
+              {
+                Insert (timer);
+              }
+          }
+      }
+
+    // Take the timers of the current tick, and schedule the next event
+    // before expiring them, since the callback may schedule new timers
+    std::vector<Timer> timers;
+    timers.swap (m_slots[0][m_currentTick & SLOT_MASK]);
+    m_size -= timers.size ();
+    if (m_size > 0)
+      {
+        ScheduleEvent (GetNextTick ());
+      }
+    for (auto &timer : timers)
+      {
+        m_expire (timer.value);
+      }
+    if (!m_tickCallback.IsNull ())
+      {
+        m_tickCallback ();
+      }
+  }
+
+  Time m_tick;                //!< The resolution of the timers
+  uint64_t m_currentTick;     //!< The last processed tick
+  uint64_t m_nextTick;        //!< The tick of the pending event
+  std::size_t m_size;         //!< The number of pending timers
+  EventId m_event;            //!< The pending event
+  Callback<void, T> m_expire; //!< The function called on expired timers
+  Callback<void> m_tickCallback; //!< The function called after each tick
+
+  std::vector<Timer> m_slots[LEVELS][SLOT_MASK + 1]; //!< The slots of each level
+  std::multimap<uint64_t, Timer> m_overflow;          //!< The timers beyond the levels
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* TIMER_WHEEL_H */
@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UID_HASH_MAP_H
+#define UID_HASH_MAP_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A hash map from 64-bit identifiers (like packet UIDs) to values.
+ *
+ * Entries are stored in a single array and collisions are resolved through
+ * linear probing, so that lookups don't need to follow pointers and
+ * insertions don't allocate memory, apart from when the array grows. Erased
+ * entries are removed by shifting back the following ones, so that the table
+ * never fills up with deleted markers.
+ */
+template <typename T>
+class UidHashMap
+{
+public:
+  UidHashMap () : m_size (0)
+  {
+  }
+
+  /**
+   * Find the value associated to a key.
+   *
+   * \param key The key to look for.
+   * \return A pointer to the value, or 0 if the key is not in the map. The
+   * pointer is invalidated by the next insertion or removal.
+   */
+  T *
+  Find (uint64_t key)
+  {
+    if (m_size == 0)
+      {
+        return 0;
+      }
+    std::size_t mask = m_slots.size () - 1;
+    for (std::size_t i = Home (key); m_slots[i].used; i = (i + 1) & mask)
+      {
+        if (m_slots[i].key == key)
+          {
+            return &m_slots[i].value;
+          }
+      }
+    return 0;
+  }
+
+  /**
+   * Insert a value in the map, if its key is not already present.
+   *
+   * \param key The key of the value.
+   * \param value The value to insert.
+   * \return True if the value was inserted, false if the key was already
+   * present (in which case the map is left untouched).
+   */
+  bool
+  Insert (uint64_t key, const T &value)
+  {
+    if (2 * (m_size + 1) > m_slots.size ())
+      {
+        Grow ();
+      }
+    std::size_t mask = m_slots.size () - 1;
+    std::size_t i = Home (key);
+    for (; m_slots[i].used; i = (i + 1) & mask)
+      {
+        if (m_slots[i].key == key)
+          {
+            return false;
+          }
+      }
+    m_slots[i].key = key;
+    m_slots[i].value = value;
+    m_slots[i].used = true;
+    m_size++;
+    return true;
+  }
+
+  /**
+   * Remove a key from the map.
+   *
+   * \param key The key to remove.
+   * \return True if the key was in the map.
+   */
+  bool
+  Erase (uint64_t key)
+  {
+    if (m_size == 0)
+      {
+        return false;
+      }
+    std::size_t mask = m_slots.size () - 1;
+    std::size_t i = Home (key);
+    for (; m_slots[i].key != key; i = (i + 1) & mask)
+      {
+        if (!m_slots[i].used)
+          {
+            return false;
+          }
+      }
+    if (!m_slots[i].used)
+      {
+        return false;
+      }
+
+    // Shift back the entries of the same run that would not be reachable
+    // anymore from their home slot once slot i is emptied
+    std::size_t j = i;
+    while (true)
+      {
+        j = (j + 1) & mask;
+        if (!m_slots[j].used)
+          {
+            break;
+          }
+        std::size_t home = Home (m_slots[j].key);
+        bool reachable = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!reachable)
+          {
+            m_slots[i] = m_slots[j];
+            i = j;
+          }
+      }
+    m_slots[i].used = false;
+    m_slots[i].value = T ();
+    m_size--;
+    return true;
+  }
+
+  /**
+   * \return The number of entries in the map.
+   */
+  std::size_t
+  GetSize (void) const
+  {
+    return m_size;
+  }
+
+private:
+  /**
+   * An entry of the table.
+   */
+  struct Slot
+  {
+    Slot () : key (0), value (), used (false)
+    {
+    }
+
+    uint64_t key;
+    T value;
+    bool used;
+  };
+
+  /**
+   * Get the slot where the search for a key starts.
+   */
+  std::size_t
+  Home (uint64_t key) const
+  {
+    // Fibonacci hashing spreads consecutive identifiers over the table
+    return std::size_t ((key * 0x9E3779B97F4A7C15ULL) >> 32) & (m_slots.size () - 1);
+  }
+
+  /**
+   * Double the size of the table, and re-insert all entries.
+   */
+  void
+  Grow (void)
+  {
+    std::vector<Slot> old;
+    old.swap (m_slots);
+    m_slots.resize (old.empty () ? 16 : 2 * old.size ());
+    m_size = 0;
+    for (auto &slot : old)
+      {
+        if (slot.used)
+          {
+            Insert (slot.key, slot.value);
+          }
+      }
+  }
+
+  std::vector<Slot> m_slots; //!< The table, whose size is a power of two
+  std::size_t m_size; //!< The number of used slots
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* UID_HASH_MAP_H */
@@ -8,6 +8,17 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/position-allocator.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/uid-hash-map.h"
+#include "ns3/lora-trace-writer.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/basic-energy-source.h"
+
+#include <fstream>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -847,6 +858,60 @@ LogicalLoraChannelTest::DoRun (void)
                          "Waiting time affects other subbands");
   NS_TEST_EXPECT_MSG_EQ (channelHelper->GetWaitingTime (channel5), Time (0),
                          "Waiting time affects other subbands");
+
+  // Waiting times by channel index match the ones by channel
+  for (uint32_t i = 0; i < channelHelper->GetChannels ().size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (channelHelper->GetWaitingTime (i),
+                             channelHelper->GetWaitingTime (channelHelper->GetChannels ()[i]),
+                             "Waiting time by index doesn't match the one by channel");
+    }
+
+  // The minimum waiting time only considers enabled channels
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetMinimumWaitingTime (), Time (0),
+                         "Minimum waiting time doesn't behave as expected");
+  channelHelper->DisableChannel (3);
+  channelHelper->DisableChannel (4);
+  NS_TEST_EXPECT_MSG_EQ (channelHelper->GetMinimumWaitingTime (), expectedTimeOff,
+                         "Minimum waiting time considers disabled channels");
+
+  // Channels added before their SubBand are assigned to it
+  Ptr<LogicalLoraChannelHelper> otherHelper = CreateObject<LogicalLoraChannelHelper> ();
+  otherHelper->AddChannel (869.1);
+  otherHelper->AddSubBand (868, 868.7, 0.01, 14);
+  otherHelper->AddSubBand (869, 869.4, 0.1, 27);
+  otherHelper->AddEvent (Seconds (1), otherHelper->GetChannels ()[0]);
+  NS_TEST_EXPECT_MSG_EQ (otherHelper->GetWaitingTime (0), Seconds (1 / 0.1 - 1),
+                         "Channel added before its SubBand has the wrong waiting time");
+
+  // Helpers created from the same plan share it, but not their channel mask
+  // and duty cycle timers
+  Ptr<RegionalChannelPlan> plan = Create<RegionalChannelPlan> ();
+  plan->AddSubBand (Create<SubBand> (868, 868.7, 0.01, 14));
+  plan->AddChannel (CreateObject<LogicalLoraChannel> (868.1));
+  plan->AddChannel (CreateObject<LogicalLoraChannel> (868.3));
+  Ptr<LogicalLoraChannelHelper> first = CreateObject<LogicalLoraChannelHelper> (plan);
+  Ptr<LogicalLoraChannelHelper> second = CreateObject<LogicalLoraChannelHelper> (plan);
+  first->DisableChannel (0);
+  first->AddEvent (Seconds (1), plan->GetChannels ()[0]);
+  NS_TEST_EXPECT_MSG_EQ (second->IsChannelEnabled (0), true,
+                         "Disabling a channel affects other devices");
+  NS_TEST_EXPECT_MSG_EQ (second->GetWaitingTime (0), Time (0),
+                         "Duty cycle affects other devices");
+  NS_TEST_EXPECT_MSG_EQ ((first->GetChannelPlan () == second->GetChannelPlan ()), true,
+                         "The channel plan was copied without being modified");
+  NS_TEST_EXPECT_MSG_EQ (plan->GetChannels ()[0]->IsReadOnly (), true,
+                         "A channel of a shared plan can be modified");
+
+  // Changing the channels of a helper copies the plan
+  second->SetChannel (1, CreateObject<LogicalLoraChannel> (868.5));
+  NS_TEST_EXPECT_MSG_EQ ((first->GetChannelPlan () == second->GetChannelPlan ()), false,
+                         "The shared channel plan was modified");
+  NS_TEST_EXPECT_MSG_EQ (first->GetChannels ()[1]->GetFrequency (), 868.3,
+                         "The shared channel plan was modified");
+  NS_TEST_EXPECT_MSG_EQ (second->GetChannels ()[1]->GetFrequency (), 868.5,
+                         "The new channel was not set");
+  NS_TEST_EXPECT_MSG_EQ (second->IsChannelEnabled (1), true, "The new channel is not enabled");
 }
 
 /*****************
@@ -957,6 +1022,28 @@ TimeOnAirTest::DoRun (void)
   txParams.codingRate = 1;
   duration = LoraPhy::GetOnAirTime (packet, txParams);
   NS_TEST_EXPECT_MSG_EQ_TOL (duration.GetSeconds (), 2.301952, 0.0001, "Unexpected duration");
+
+  // The memoised values are exactly the ones given by the formula, both when
+  // they are first computed and when they are looked up, and so are the
+  // values computed with the tables disabled
+  for (int pass = 0; pass < 3; pass++)
+    {
+      LoraPhy::EnableOnAirTimeTables (pass < 2);
+      for (uint8_t sf = 7; sf <= 12; sf++)
+        {
+          txParams.sf = sf;
+          txParams.lowDataRateOptimizationEnabled = sf >= 11;
+          for (uint32_t size = 10; size <= 300; size += 10)
+            {
+              duration = LoraPhy::GetOnAirTime (Create<Packet> (size), txParams);
+              NS_TEST_EXPECT_MSG_EQ (duration, LoraPhy::ComputeOnAirTime (size, txParams),
+                                     "Memoised duration differs for SF" << unsigned (sf)
+                                                                        << " and " << size
+                                                                        << " bytes");
+            }
+        }
+    }
+  LoraPhy::EnableOnAirTimeTables (true);
 }
 
 /**************************
@@ -975,6 +1062,7 @@ public:
   void NoMoreDemodulators (Ptr<const Packet> packet, uint32_t node);
   void WrongFrequency (Ptr<const Packet> packet, uint32_t node);
   void WrongSf (Ptr<const Packet> packet, uint32_t node);
+  void PacketSent (Ptr<const Packet> packet);
   bool HaveSamePacketContents (Ptr<Packet> packet1, Ptr<Packet> packet2);
 
 private:
@@ -991,6 +1079,7 @@ private:
   int m_noMoreDemodulatorsCalls = 0;
   int m_wrongSfCalls = 0;
   int m_wrongFrequencyCalls = 0;
+  int m_packetSentCalls = 0;
 };
 
 // Add some help text to this case to describe what it is intended to test
@@ -1046,6 +1135,14 @@ PhyConnectivityTest::WrongSf (Ptr<const Packet> packet, uint32_t node)
   m_wrongSfCalls++;
 }
 
+void
+PhyConnectivityTest::PacketSent (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (packet);
+
+  m_packetSentCalls++;
+}
+
 void
 PhyConnectivityTest::WrongFrequency (Ptr<const Packet> packet, uint32_t node)
 {
@@ -1089,6 +1186,7 @@ PhyConnectivityTest::Reset (void)
   m_interferenceCalls = 0;
   m_wrongSfCalls = 0;
   m_wrongFrequencyCalls = 0;
+  m_packetSentCalls = 0;
 
   Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
   loss->SetPathLossExponent (3.76);
@@ -1358,6 +1456,754 @@ PhyConnectivityTest::DoRun (void)
                          "State didn't switch to STANDBY as expected");
   NS_TEST_EXPECT_MSG_EQ (edPhy2->GetState (), SimpleEndDeviceLoraPhy::STANDBY,
                          "State didn't switch to STANDBY as expected");
+
+  Reset ();
+
+  // Spatial culling
+  //////////////////
+
+  // PHYs beyond the maximum range are not notified of the transmission
+  txParams.sf = 12;
+  channel->SetAttribute ("MaxRange", DoubleValue (15));
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1,
+                         "Channel delivered a packet to a PHY beyond the maximum range");
+
+  // PHYs that move within range are notified again
+  m_receivedPacketCalls = 0;
+  edPhy3->GetMobility ()->GetObject<ConstantPositionMobilityModel> ()->SetPosition (
+      Vector (5, 0, 0));
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 2,
+                         "Channel did not deliver a packet to a PHY that moved within range");
+
+  Reset ();
+
+  // PHYs that move without changing course are reached at their current
+  // position
+  channel->SetAttribute ("MaxRange", DoubleValue (15));
+  Ptr<ConstantVelocityMobilityModel> movingMobility = CreateObject<ConstantVelocityMobilityModel> ();
+  movingMobility->SetPosition (Vector (115, 0, 0));
+  movingMobility->SetVelocity (Vector (-10, 0, 0));
+  edPhy3->SetMobility (movingMobility);
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (11), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 3,
+                         "Channel did not deliver packets to a moving PHY at its current position");
+
+  Reset ();
+
+  // Link budget cache
+  ////////////////////
+
+  // Cached link budgets are discarded when a PHY moves
+  channel->SetAttribute ("CacheLinkBudget", BooleanValue (true));
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (10), &ConstantPositionMobilityModel::SetPosition,
+                       edPhy2->GetMobility ()->GetObject<ConstantPositionMobilityModel> (),
+                       Vector (100000, 0, 0));
+  Simulator::Schedule (Seconds (20), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 3,
+                         "Channel did not deliver packets as expected with the cache enabled");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "Channel used a stale link budget after a PHY moved");
+
+  Reset ();
+
+  // Link budgets of PHYs that move without changing course are not cached
+  channel->SetAttribute ("CacheLinkBudget", BooleanValue (true));
+  Ptr<ConstantVelocityMobilityModel> leavingMobility = CreateObject<ConstantVelocityMobilityModel> ();
+  leavingMobility->SetPosition (Vector (-9990, 0, 0));
+  leavingMobility->SetVelocity (Vector (5000, 0, 0));
+  edPhy2->SetMobility (leavingMobility);
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (20), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 3,
+                         "Channel did not deliver packets as expected to a moving PHY");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "Channel used a stale link budget for a moving PHY");
+
+  Reset ();
+
+  // PHY records
+  //////////////
+
+  // PHYs whose mobility model is replaced are reached at their new position
+  Ptr<ConstantPositionMobilityModel> farMobility = CreateObject<ConstantPositionMobilityModel> ();
+  farMobility->SetPosition (Vector (100000, 0, 0));
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (10), &LoraPhy::SetMobility, edPhy2, farMobility);
+  Simulator::Schedule (Seconds (20), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 3,
+                         "Channel did not deliver packets as expected after a mobility change");
+  NS_TEST_EXPECT_MSG_EQ (m_underSensitivityCalls, 1,
+                         "Channel used a stale mobility model after it was replaced");
+
+  Reset ();
+
+  // Shared interference
+  //////////////////////
+
+  // PHYs that wake up while a transmission is arriving take its interference
+  // from the channel's log
+  channel->SetAttribute ("SharedInterference", BooleanValue (true));
+  edPhy1->SwitchToSleep ();
+  edPhy2->SwitchToSleep ();
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy3, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (2.1), &SimpleEndDeviceLoraPhy::SwitchToStandby, edPhy2);
+  Simulator::Schedule (Seconds (2.2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams,
+                       868.1, 14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_interferenceCalls, 1,
+                         "Interference that arrived during SLEEP was not taken from the channel");
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 0,
+                         "Packet was received despite interference that arrived during SLEEP");
+
+  Reset ();
+
+  // Sleeping PHYs are not notified of transmissions, but the ones that reach
+  // them after they wake up are delivered
+  channel->SetAttribute ("SharedInterference", BooleanValue (true));
+  edPhy2->SwitchToSleep ();
+  edPhy3->SwitchToSleep ();
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (2) + NanoSeconds (10), &SimpleEndDeviceLoraPhy::SwitchToStandby,
+                       edPhy2);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1,
+                         "Packet sent before a PHY woke up did not reach it after it woke up");
+
+  Reset ();
+
+  // Transmissions from beyond the maximum range are not delivered to PHYs
+  // that wake up
+  channel->SetAttribute ("SharedInterference", BooleanValue (true));
+  channel->SetAttribute ("MaxRange", DoubleValue (15));
+  edPhy1->SwitchToSleep ();
+  edPhy2->SwitchToSleep ();
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy3, packet, txParams, 868.1,
+                       14);
+  Simulator::Schedule (Seconds (2) + NanoSeconds (10), &SimpleEndDeviceLoraPhy::SwitchToStandby,
+                       edPhy1);
+  Simulator::Schedule (Seconds (2) + NanoSeconds (10), &SimpleEndDeviceLoraPhy::SwitchToStandby,
+                       edPhy2);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, 1,
+                         "Packet from beyond the maximum range reached a PHY that woke up");
+
+  Reset ();
+
+  // PHYs that are added to the channel while sleeping are not notified of
+  // transmissions
+  channel->SetAttribute ("SharedInterference", BooleanValue (true));
+  channel->TraceConnectWithoutContext ("PacketSent",
+                                       MakeCallback (&PhyConnectivityTest::PacketSent, this));
+  Ptr<SimpleEndDeviceLoraPhy> edPhy4 = CreateObject<SimpleEndDeviceLoraPhy> ();
+  Ptr<ConstantPositionMobilityModel> mob4 = CreateObject<ConstantPositionMobilityModel> ();
+  mob4->SetPosition (Vector (5.0, 0.0, 0.0));
+  edPhy4->SetMobility (mob4);
+  channel->Add (edPhy4);
+  edPhy4->SetChannel (channel);
+
+  Simulator::Schedule (Seconds (2), &SimpleEndDeviceLoraPhy::Send, edPhy1, packet, txParams, 868.1,
+                       14);
+
+  Simulator::Stop (Hours (2));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_packetSentCalls, 2,
+                         "Packet was delivered to a PHY that was added while sleeping");
+}
+
+/***************************
+ * PartitionedDeliveryTest *
+ ***************************/
+
+class PartitionedDeliveryTest : public TestCase
+{
+public:
+  PartitionedDeliveryTest ();
+  virtual ~PartitionedDeliveryTest ();
+  void ReceivedPacket (Ptr<const Packet> packet, uint32_t node);
+  void Interference (Ptr<const Packet> packet, uint32_t node);
+
+private:
+  virtual void DoRun (void);
+  void RunScenario (bool partitioned);
+  int m_receivedPacketCalls = 0;
+  int m_interferenceCalls = 0;
+  std::vector<Vector> m_positions; //!< The positions of the nodes
+  std::vector<uint32_t> m_systemIds; //!< The system ids of the nodes
+  Time m_lookAhead; //!< The lookahead computed by the channel
+};
+
+// Add some help text to this case to describe what it is intended to test
+PartitionedDeliveryTest::PartitionedDeliveryTest ()
+    : TestCase ("Verify that partitioning nodes for distributed simulations doesn't alter results")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PartitionedDeliveryTest::~PartitionedDeliveryTest ()
+{
+}
+
+void
+PartitionedDeliveryTest::ReceivedPacket (Ptr<const Packet> packet, uint32_t node)
+{
+  NS_LOG_FUNCTION (packet << node);
+
+  m_receivedPacketCalls++;
+}
+
+void
+PartitionedDeliveryTest::Interference (Ptr<const Packet> packet, uint32_t node)
+{
+  NS_LOG_FUNCTION (packet << node);
+
+  m_interferenceCalls++;
+}
+
+void
+PartitionedDeliveryTest::RunScenario (bool partitioned)
+{
+  m_receivedPacketCalls = 0;
+  m_interferenceCalls = 0;
+  m_positions.clear ();
+  m_systemIds.clear ();
+
+  // A gateway near the middle, and end devices on both sides of it. No
+  // position falls inside the guard band around the boundary at x = 0, so
+  // the partitioned run doesn't draw new ones.
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  allocator->Add (Vector (200, 0, 0));
+  std::vector<double> xs = {-900, -500, -150, 150, 500, 900};
+  for (auto &x : xs)
+    {
+      allocator->Add (Vector (x, 0, 0));
+    }
+  double guardBand = 200;
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  // The test runs without MPI, so the remote delivery path is not exercised
+  // (the distributed-lorawan example compares an MPI run with a sequential
+  // one): this checks that partitioning doesn't change the local results,
+  // and the lookahead derived from the guard band.
+  NodeContainer nodes;
+  if (partitioned)
+    {
+      nodes = LoraHelper ().CreatePartitionedNodes (xs.size () + 1, allocator, 2, -1000, 1000,
+                                                    guardBand);
+    }
+  else
+    {
+      nodes.Create (xs.size () + 1);
+      MobilityHelper mobility;
+      mobility.SetPositionAllocator (allocator);
+      mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+      mobility.Install (nodes);
+    }
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      m_positions.push_back (nodes.Get (i)->GetObject<MobilityModel> ()->GetPosition ());
+      m_systemIds.push_back (nodes.Get (i)->GetSystemId ());
+    }
+
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  LorawanMacHelper macHelper;
+  LoraHelper helper;
+
+  NodeContainer endDevices;
+  for (uint32_t i = 1; i < nodes.GetN (); i++)
+    {
+      endDevices.Add (nodes.Get (i));
+    }
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LorawanMacHelper::GW);
+  helper.Install (phyHelper, macHelper, nodes.Get (0));
+
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LorawanMacHelper::ED_A);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  if (partitioned)
+    {
+      m_lookAhead = channel->GetLookAhead (guardBand);
+      helper.BoundLookAhead (channel, guardBand);
+    }
+
+  Ptr<LoraPhy> gwPhy = nodes.Get (0)->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+  gwPhy->TraceConnectWithoutContext ("ReceivedPacket",
+                                     MakeCallback (&PartitionedDeliveryTest::ReceivedPacket, this));
+  gwPhy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
+                                     MakeCallback (&PartitionedDeliveryTest::Interference, this));
+
+  // Partially overlapping transmissions
+  LoraTxParameters txParams;
+  txParams.sf = 7;
+  for (uint32_t i = 0; i < endDevices.GetN (); i++)
+    {
+      Ptr<LoraPhy> phy = endDevices.Get (i)->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+      Simulator::Schedule (Seconds (1 + 0.03 * i), &LoraPhy::Send, phy, Create<Packet> (10),
+                           txParams, 868.1, 14);
+    }
+
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PartitionedDeliveryTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PartitionedDeliveryTest");
+
+  RunScenario (false);
+  int sequentialReceived = m_receivedPacketCalls;
+  int sequentialInterfered = m_interferenceCalls;
+  std::vector<Vector> sequentialPositions = m_positions;
+
+  RunScenario (true);
+
+  // Both runs simulate the same network
+  bool samePositions = sequentialPositions.size () == m_positions.size ();
+  for (uint32_t i = 0; samePositions && i < m_positions.size (); i++)
+    {
+      samePositions = CalculateDistance (sequentialPositions[i], m_positions[i]) == 0;
+    }
+  NS_TEST_EXPECT_MSG_EQ (samePositions, true, "Partitioning moved some nodes");
+
+  // Nodes are assigned to the strip they fall into
+  NS_TEST_EXPECT_MSG_EQ (m_systemIds[0], uint32_t (1), "Node was assigned to the wrong partition");
+  NS_TEST_EXPECT_MSG_EQ (m_systemIds[1], uint32_t (0), "Node was assigned to the wrong partition");
+  NS_TEST_EXPECT_MSG_EQ (m_systemIds[3], uint32_t (0), "Node was assigned to the wrong partition");
+  NS_TEST_EXPECT_MSG_EQ (m_systemIds[4], uint32_t (1), "Node was assigned to the wrong partition");
+
+  // The lookahead is the propagation delay across the guard band
+  Ptr<ConstantPositionMobilityModel> a = CreateObject<ConstantPositionMobilityModel> ();
+  Ptr<ConstantPositionMobilityModel> b = CreateObject<ConstantPositionMobilityModel> ();
+  b->SetPosition (Vector (200, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (m_lookAhead,
+                         CreateObject<ConstantSpeedPropagationDelayModel> ()->GetDelay (a, b),
+                         "Lookahead is not the propagation delay across the guard band");
+
+  // Results are the same as those of the sequential run
+  NS_TEST_EXPECT_MSG_GT (sequentialReceived + sequentialInterfered, 0,
+                         "Gateway didn't receive any packet");
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, sequentialReceived,
+                         "Partitioned run received a different number of packets");
+  NS_TEST_EXPECT_MSG_EQ (m_interferenceCalls, sequentialInterfered,
+                         "Partitioned run lost a different number of packets to interference");
+}
+
+/*********************
+ * PacketTrackerTest *
+ *********************/
+
+class PacketTrackerTest : public TestCase
+{
+public:
+  PacketTrackerTest ();
+  virtual ~PacketTrackerTest ();
+
+  Ptr<Packet> CreateUplink (void);
+
+  void Transmit (LoraPacketTracker *tracker, Ptr<Packet> packet);
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+PacketTrackerTest::PacketTrackerTest ()
+    : TestCase ("Verify that LoraPacketTracker keeps track of packet outcomes")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PacketTrackerTest::~PacketTrackerTest ()
+{
+}
+
+Ptr<Packet>
+PacketTrackerTest::CreateUplink (void)
+{
+  Ptr<Packet> packet = Create<Packet> (10);
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  packet->AddHeader (macHdr);
+  return packet;
+}
+
+void
+PacketTrackerTest::Transmit (LoraPacketTracker *tracker, Ptr<Packet> packet)
+{
+  tracker->TransmissionCallback (packet, 0);
+  tracker->PacketReceptionCallback (packet, 10);
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PacketTrackerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PacketTrackerTest");
+
+  ///////////////////////////////
+  // Test the UidHashMap class //
+  ///////////////////////////////
+
+  UidHashMap<int> map;
+  for (int i = 0; i < 1000; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (map.Insert (i, i), true, "Failed to insert a new key");
+    }
+  NS_TEST_EXPECT_MSG_EQ (map.Insert (10, 0), false, "A duplicate key was inserted");
+  NS_TEST_EXPECT_MSG_EQ (*map.Find (10), 10, "Value was overwritten by a duplicate key");
+
+  // Erase the even keys, and check that odd ones can still be found
+  for (int i = 0; i < 1000; i += 2)
+    {
+      NS_TEST_EXPECT_MSG_EQ (map.Erase (i), true, "Failed to erase a key");
+    }
+  NS_TEST_EXPECT_MSG_EQ (map.Erase (0), false, "A key was erased twice");
+  NS_TEST_EXPECT_MSG_EQ (map.GetSize (), 500u, "Wrong number of entries");
+  bool allFound = true;
+  for (int i = 0; i < 1000; i++)
+    {
+      int *value = map.Find (i);
+      allFound &= (i % 2 == 0) ? value == 0 : (value != 0 && *value == i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (allFound, true, "Keys were lost after erasing other keys");
+
+  //////////////////////////////////////
+  // Test the LoraPacketTracker class //
+  //////////////////////////////////////
+
+  LoraPacketTracker tracker;
+  Ptr<Packet> first = CreateUplink ();
+  Ptr<Packet> second = CreateUplink ();
+  tracker.TransmissionCallback (first, 0);
+  tracker.TransmissionCallback (second, 1);
+
+  // Outcomes are looked up by UID, so copies of a packet share them, and
+  // only the first outcome at each gateway is kept
+  tracker.PacketReceptionCallback (first->Copy (), 10);
+  tracker.InterferenceCallback (first, 10);
+  tracker.UnderSensitivityCallback (first, 11);
+  tracker.InterferenceCallback (second, 10);
+
+  std::vector<int> counts = tracker.CountPhyPacketsPerGw (Seconds (0), Seconds (1), 10);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 2, "Wrong number of sent packets");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (1), 1, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (2), 1, "Wrong number of interfered packets");
+  counts = tracker.CountPhyPacketsPerGw (Seconds (0), Seconds (1), 11);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (4), 1, "Wrong number of packets under sensitivity");
+  counts = tracker.CountPhyPacketsPerGw (Seconds (0), Seconds (1), 12);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 2, "Sent packets should not depend on the gateway");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (1), 0, "Unknown gateway has received packets");
+
+  // MAC packets received by at least one gateway are counted once
+  tracker.MacTransmissionCallback (first);
+  tracker.MacTransmissionCallback (second);
+  tracker.MacGwReceptionCallback (first);
+  tracker.MacGwReceptionCallback (first->Copy ());
+  counts = tracker.CountMacPacketsGloballyValues (Seconds (0), Seconds (1));
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 2, "Wrong number of sent MAC packets");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (1), 1, "Wrong number of received MAC packets");
+  NS_TEST_EXPECT_MSG_EQ (tracker.CountMacPacketsGlobally (Seconds (0), Seconds (1)),
+                         "2.000000 1.000000", "Wrong text MAC packet counts");
+
+  // In windowed mode, old packets are forgotten
+  LoraPacketTracker windowedTracker;
+  windowedTracker.SetHorizon (Seconds (10));
+  for (int i = 0; i < 30; i++)
+    {
+      Simulator::Schedule (Seconds (i), &PacketTrackerTest::Transmit, this, &windowedTracker,
+                           CreateUplink ());
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  counts = windowedTracker.CountPhyPacketsPerGw (Seconds (0), Seconds (30), 10);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 11, "Old packets were not forgotten");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (1), 11, "Outcomes don't match the tracked packets");
+
+  // Streaming statistics are still available after packets are forgotten
+  LoraPacketTracker streamingTracker;
+  streamingTracker.SetHorizon (Seconds (10));
+  streamingTracker.EnableStreamingStatistics (Seconds (10));
+  for (int i = 0; i < 30; i++)
+    {
+      Simulator::Schedule (Seconds (i + 0.5), &PacketTrackerTest::Transmit, this,
+                           &streamingTracker, CreateUplink ());
+    }
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  counts = streamingTracker.CountPhyPacketsPerGw (Seconds (0), Seconds (30), 10);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 30, "Wrong number of sent packets in buckets");
+  NS_TEST_EXPECT_MSG_EQ (counts.at (1), 30, "Wrong number of received packets in buckets");
+  counts = streamingTracker.CountPhyPacketsPerGw (Seconds (10), Seconds (20), 10);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 10, "Interval was not mapped to the right buckets");
+  counts = streamingTracker.CountPhyPacketsPerGw (Seconds (15), Seconds (25), 10);
+  NS_TEST_EXPECT_MSG_EQ (counts.at (0), 10, "Interval ends were not rounded down");
+}
+
+/*******************
+ * TraceWriterTest *
+ *******************/
+
+class TraceWriterTest : public TestCase
+{
+public:
+  TraceWriterTest ();
+  virtual ~TraceWriterTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+TraceWriterTest::TraceWriterTest ()
+    : TestCase ("Verify that binary traces can be converted back to CSV")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TraceWriterTest::~TraceWriterTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TraceWriterTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TraceWriterTest");
+
+  std::string filename = CreateTempDirFilename ("trace.bin");
+  std::string prefix = CreateTempDirFilename ("trace");
+
+  // Write more records than fit in a block, interleaving record types
+  {
+    LoraTraceWriter writer (filename, 100);
+    std::vector<int> counts = {6, 5, 1, 0, 0, 0};
+    for (int i = 0; i < 250; i++)
+      {
+        writer.WriteDeviceStatus (Seconds (i), i, Vector (i, -i, 0), 5, 14);
+        writer.WritePhyPerformance (Seconds (i), 1000, counts);
+      }
+    writer.WriteGlobalPerformance (Seconds (1.5), 10, 8);
+  }
+
+  NS_TEST_EXPECT_MSG_EQ (LoraTraceReader::ConvertToCsv (filename, prefix), 501,
+                         "Wrong number of converted records");
+
+  std::ifstream deviceStatus ((prefix + "-device-status.csv").c_str ());
+  std::string line;
+  std::getline (deviceStatus, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "time,nodeId,x,y,dataRate,txPower", "Wrong CSV header");
+  for (int i = 0; i < 250; i++)
+    {
+      std::getline (deviceStatus, line);
+    }
+  NS_TEST_EXPECT_MSG_EQ (line, "249,249,249,-249,5,14", "Wrong device status record");
+
+  std::ifstream globalPerformance ((prefix + "-global-performance.csv").c_str ());
+  std::getline (globalPerformance, line);
+  std::getline (globalPerformance, line);
+  NS_TEST_EXPECT_MSG_EQ (line, "1.5,10,8", "Wrong global performance record");
+
+  NS_TEST_EXPECT_MSG_EQ (LoraTraceReader::ConvertToCsv (prefix + "-device-status.csv", prefix),
+                         -1, "A text file was accepted as a binary trace");
+}
+
+/********************
+ * EnergyModelTest *
+ ********************/
+
+class EnergyModelTest : public TestCase
+{
+public:
+  EnergyModelTest ();
+  virtual ~EnergyModelTest ();
+
+private:
+  virtual void DoRun (void);
+  void CheckEnergy (void);
+  void CheckCurrent (void);
+
+  std::vector<Ptr<BasicEnergySource>> m_sources; //!< The default and lazy sources
+  std::vector<Ptr<LoraRadioEnergyModel>> m_models; //!< The default and lazy models
+};
+
+// Add some help text to this case to describe what it is intended to test
+EnergyModelTest::EnergyModelTest ()
+    : TestCase ("Verify that lazy energy accounting matches the default one")
+{
+}
+
+// Reminder that the test case should clean up after itself
+EnergyModelTest::~EnergyModelTest ()
+{
+}
+
+void
+EnergyModelTest::CheckEnergy (void)
+{
+  // Account for the time spent in the last state
+  for (auto &model : m_models)
+    {
+      model->ChangeState (EndDeviceLoraPhy::SLEEP);
+    }
+
+  NS_TEST_EXPECT_MSG_EQ (m_models[1]->GetTotalEnergyConsumption (),
+                         m_models[0]->GetTotalEnergyConsumption (),
+                         "Lazy accounting changed the total energy consumption");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_sources[1]->GetRemainingEnergy (),
+                             m_sources[0]->GetRemainingEnergy (), 1e-9,
+                             "Lazy accounting changed the energy drawn from the source");
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_sources[1]->GetRemainingEnergy (),
+                             100 - m_models[1]->GetTotalEnergyConsumption (), 1e-9,
+                             "The source did not account for all the consumption");
+}
+
+void
+EnergyModelTest::CheckCurrent (void)
+{
+  // Querying the current outside of a source update has no side effects
+  double currentA = m_models[1]->GetCurrentA ();
+  NS_TEST_EXPECT_MSG_EQ (m_models[1]->GetCurrentA (), currentA,
+                         "Querying the current of the lazy model changed it");
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EnergyModelTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("EnergyModelTest");
+
+  // Create a source and a model in the default mode, and another pair in
+  // lazy accounting mode, which is never notified at state changes
+  for (bool lazy : {false, true})
+    {
+      Ptr<BasicEnergySource> source = CreateObject<BasicEnergySource> ();
+      source->SetInitialEnergy (100);
+      source->SetSupplyVoltage (3.3);
+      source->SetEnergyUpdateInterval (Seconds (0.7));
+      Ptr<LoraRadioEnergyModel> model = CreateObject<LoraRadioEnergyModel> ();
+      model->SetAttribute ("LazyAccounting", BooleanValue (lazy));
+      model->SetAttribute ("LazyUpdateThreshold", DoubleValue (1000));
+      model->SetEnergySource (source);
+      source->AppendDeviceEnergyModel (model);
+      source->Initialize ();
+      m_sources.push_back (source);
+      m_models.push_back (model);
+    }
+
+  // Go through the states of a few uplinks, with periodic updates of the
+  // sources happening while the radio is in different states
+  int states[] = {EndDeviceLoraPhy::STANDBY, EndDeviceLoraPhy::TX, EndDeviceLoraPhy::STANDBY,
+                  EndDeviceLoraPhy::RX, EndDeviceLoraPhy::SLEEP};
+  double times[] = {0.1, 0.25, 1.6, 2.6, 2.75};
+  for (int uplink = 0; uplink < 3; uplink++)
+    {
+      for (int i = 0; i < 5; i++)
+        {
+          for (auto &model : m_models)
+            {
+              Simulator::Schedule (Seconds (uplink * 10 + times[i]), &LoraRadioEnergyModel::ChangeState,
+                                   model, states[i]);
+            }
+        }
+    }
+
+  // Check the energy while the simulation is running, since sources are not
+  // updated anymore once it is finished
+  Simulator::Schedule (Seconds (20.2), &EnergyModelTest::CheckCurrent, this);
+  Simulator::Schedule (Seconds (35.35), &EnergyModelTest::CheckEnergy, this);
+
+  Simulator::Stop (Seconds (40));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  m_sources.clear ();
+  m_models.clear ();
 }
 
 /*****************
@@ -1418,6 +2264,10 @@ LorawanTestSuite::LorawanTestSuite () : TestSuite ("lorawan", UNIT)
   AddTestCase (new LogicalLoraChannelTest, TestCase::QUICK);
   AddTestCase (new TimeOnAirTest, TestCase::QUICK);
   AddTestCase (new PhyConnectivityTest, TestCase::QUICK);
+  AddTestCase (new PartitionedDeliveryTest, TestCase::QUICK);
+  AddTestCase (new PacketTrackerTest, TestCase::QUICK);
+  AddTestCase (new TraceWriterTest, TestCase::QUICK);
+  AddTestCase (new EnergyModelTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
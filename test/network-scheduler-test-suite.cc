@@ -6,6 +6,9 @@
 // Include headers of classes to test
 #include "ns3/log.h"
 #include "ns3/network-scheduler.h"
+#include "ns3/timer-wheel.h"
+#include "ns3/downlink-planner.h"
+#include "ns3/simulator.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -52,6 +55,152 @@ NetworkSchedulerTest::DoRun (void)
   // scheduled to happen 1 second after the reception.
 }
 
+/////////////////////////
+// TimerWheel testing //
+/////////////////////////
+
+class TimerWheelTest : public TestCase
+{
+public:
+  TimerWheelTest ();
+  virtual ~TimerWheelTest ();
+
+private:
+  virtual void DoRun (void);
+  void Expire (int timer);
+
+  TimerWheel<int> *m_wheel;
+  std::vector<std::pair<int, Time> > m_expired;
+};
+
+TimerWheelTest::TimerWheelTest ()
+  : TestCase ("Verify that the TimerWheel expires timers at the right tick")
+{
+}
+
+TimerWheelTest::~TimerWheelTest ()
+{
+}
+
+void
+TimerWheelTest::Expire (int timer)
+{
+  m_expired.push_back (std::make_pair (timer, Simulator::Now ()));
+
+  // Timers scheduled while expiring others are not lost
+  if (timer == 0)
+    {
+      m_wheel->Schedule (MicroSeconds (500), 100);
+    }
+}
+
+void
+TimerWheelTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TimerWheelTest");
+
+  // Timers that fall in the same tick, and timers handled by each level of
+  // the wheel and by its overflow map
+  std::vector<Time> delays;
+  delays.push_back (MicroSeconds (1500));
+  delays.push_back (MilliSeconds (3));
+  delays.push_back (MicroSeconds (1001));
+  delays.push_back (MilliSeconds (2));
+  delays.push_back (Seconds (1));
+  delays.push_back (Seconds (100));
+  delays.push_back (Seconds (20000));
+  delays.push_back (Seconds (1));
+
+  {
+    TimerWheel<int> wheel (MilliSeconds (1));
+    m_wheel = &wheel;
+    wheel.SetExpireCallback (MakeCallback (&TimerWheelTest::Expire, this));
+    for (std::size_t timer = 0; timer < delays.size (); timer++)
+      {
+        wheel.Schedule (delays[timer], timer);
+      }
+    NS_TEST_EXPECT_MSG_EQ (wheel.GetSize (), delays.size (), "Wrong number of timers");
+
+    Simulator::Run ();
+
+    NS_TEST_EXPECT_MSG_EQ (wheel.GetSize (), 0, "Timers were left in the wheel");
+  }
+  Simulator::Destroy ();
+
+  // Timers expire at the first tick after their delay, and those of the same
+  // tick in the order they were scheduled
+  int order[] = {0, 2, 3, 1, 100, 4, 7, 5, 6};
+  int64_t expected[] = {2, 2, 2, 3, 3, 1000, 1000, 100000, 20000000};
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), delays.size () + 1, "Wrong number of expired timers");
+  for (std::size_t i = 0; i < m_expired.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_expired[i].first, order[i], "Timer expired out of order");
+      NS_TEST_EXPECT_MSG_EQ (m_expired[i].second, MilliSeconds (expected[i]),
+                             "Timer " << m_expired[i].first << " expired at the wrong time");
+    }
+}
+
+/////////////////////////////
+// DownlinkPlanner testing //
+/////////////////////////////
+
+class DownlinkPlannerTest : public TestCase
+{
+public:
+  DownlinkPlannerTest ();
+  virtual ~DownlinkPlannerTest ();
+
+private:
+  virtual void DoRun (void);
+  void CheckPlan (Ptr<DownlinkPlanner> planner, uint32_t expected[]);
+};
+
+DownlinkPlannerTest::DownlinkPlannerTest ()
+  : TestCase ("Verify the gateways assigned by the DownlinkPlanner strategies")
+{
+}
+
+DownlinkPlannerTest::~DownlinkPlannerTest ()
+{
+}
+
+void
+DownlinkPlannerTest::CheckPlan (Ptr<DownlinkPlanner> planner, uint32_t expected[])
+{
+  // The first three requests compete for gateways 0 to 2, and can only all
+  // be served if the first two use their second best gateway. The last two
+  // requests can only use gateway 3.
+  uint32_t candidates[][2] = {{0, 1}, {1, 2}, {0, 0}, {3, 3}, {3, 3}};
+  std::size_t nCandidates[] = {2, 2, 1, 1, 1};
+  std::vector<DownlinkPlanner::Request> requests (5);
+  for (std::size_t i = 0; i < requests.size (); i++)
+    {
+      requests[i].gateways.assign (candidates[i], candidates[i] + nCandidates[i]);
+    }
+
+  planner->Plan (requests, 4);
+
+  for (std::size_t i = 0; i < requests.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (requests[i].gateway, expected[i],
+                             "Request " << i << " was assigned the wrong gateway");
+    }
+}
+
+void
+DownlinkPlannerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("DownlinkPlannerTest");
+
+  const uint32_t none = DownlinkPlanner::NO_GATEWAY;
+
+  uint32_t greedy[] = {0, 1, none, 3, none};
+  CheckPlan (CreateObject<GreedyDownlinkPlanner> (), greedy);
+
+  uint32_t matching[] = {1, 2, 0, 3, none};
+  CheckPlan (CreateObject<MatchingDownlinkPlanner> (), matching);
+}
+
 /**************
  * Test Suite *
  **************/
@@ -72,6 +221,8 @@ NetworkSchedulerTestSuite::NetworkSchedulerTestSuite ()
   LogComponentEnable ("NetworkSchedulerTestSuite", LOG_LEVEL_DEBUG);
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new NetworkSchedulerTest, TestCase::QUICK);
+  AddTestCase (new TimerWheelTest, TestCase::QUICK);
+  AddTestCase (new DownlinkPlannerTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
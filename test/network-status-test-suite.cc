@@ -12,6 +12,8 @@
 #include "ns3/log.h"
 #include "ns3/end-device-status.h"
 #include "ns3/network-status.h"
+#include "ns3/lora-tag.h"
+#include "ns3/mac48-address.h"
 #include "utilities.h"
 
 // An essential include is test.h
@@ -47,6 +49,26 @@ EndDeviceStatusTest::~EndDeviceStatusTest ()
 {
 }
 
+// Craft an uplink with the given frame counter, as it would be forwarded by a
+// gateway that received it with the given power
+static Ptr<const ParsedUplink>
+CreateUplink (uint16_t fCnt, double rxPower)
+{
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (1));
+  frameHdr.SetFCnt (fCnt);
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::UNCONFIRMED_DATA_UP);
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (frameHdr);
+  packet->AddHeader (macHdr);
+  LoraTag tag (7);
+  tag.SetReceivePower (rxPower);
+  packet->AddPacketTag (tag);
+  return Create<ParsedUplink> (packet);
+}
+
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
@@ -56,6 +78,118 @@ EndDeviceStatusTest::DoRun (void)
 
   // Create an EndDeviceStatus object
   EndDeviceStatus eds = EndDeviceStatus ();
+
+  // Craft an uplink as it would be forwarded by a gateway
+  LoraDeviceAddress address (0x0A0B0C0D);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (address);
+  frameHdr.SetFCnt (7);
+  frameHdr.SetAdr (true);
+  frameHdr.AddLinkCheckReq ();
+  LorawanMacHeader macHdr;
+  macHdr.SetMType (LorawanMacHeader::CONFIRMED_DATA_UP);
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (frameHdr);
+  packet->AddHeader (macHdr);
+  LoraTag tag (9);
+  tag.SetFrequency (868.3);
+  tag.SetReceivePower (-120);
+  packet->AddPacketTag (tag);
+
+  Ptr<const ParsedUplink> uplink = Create<ParsedUplink> (packet);
+  NS_TEST_EXPECT_MSG_EQ (uplink->GetAddress (), address, "Wrong address");
+  NS_TEST_EXPECT_MSG_EQ (uplink->GetFCnt (), 7, "Wrong frame counter");
+  NS_TEST_EXPECT_MSG_EQ (uplink->GetAdr (), true, "Wrong ADR bit");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (uplink->GetMType ()),
+                         unsigned (LorawanMacHeader::CONFIRMED_DATA_UP), "Wrong MType");
+  NS_TEST_EXPECT_MSG_EQ ((uplink->GetMacCommand<LinkCheckReq> () != 0), true,
+                         "MAC command was not found");
+  NS_TEST_EXPECT_MSG_EQ ((uplink->GetMacCommand<LinkAdrReq> () == 0), true,
+                         "Unexpected MAC command was found");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (uplink->GetSpreadingFactor ()), 9, "Wrong SF");
+  NS_TEST_EXPECT_MSG_EQ (uplink->GetReceivePower (), -120, "Wrong receive power");
+
+  // The same packet received by two gateways is stored once
+  eds.InsertReceivedPacket (uplink, Mac48Address ("00:00:00:00:00:01"), 0);
+  eds.InsertReceivedPacket (Create<ParsedUplink> (packet->Copy ()),
+                            Mac48Address ("00:00:00:00:00:02"), 1);
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketList ().size (), 1u, "Duplicate was stored");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetLastReceivedPacketInfo ().gwList.size (), 2u,
+                         "Second gateway was not recorded");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetLastReceivedUplink (), uplink, "Wrong last uplink");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (eds.GetFirstReceiveWindowSpreadingFactor ()), 9,
+                         "First receive window SF was not updated");
+
+  // Only the last HistoryLength (4) packets are kept
+  for (uint16_t fCnt = 8; fCnt < 12; fCnt++)
+    {
+      Ptr<Packet> next = packet->Copy ();
+      LorawanMacHeader nextMacHdr;
+      LoraFrameHeader nextFrameHdr;
+      nextFrameHdr.SetAsUplink ();
+      next->RemoveHeader (nextMacHdr);
+      next->RemoveHeader (nextFrameHdr);
+      nextFrameHdr.SetFCnt (fCnt);
+      next->AddHeader (nextFrameHdr);
+      next->AddHeader (nextMacHdr);
+      eds.InsertReceivedPacket (Create<ParsedUplink> (next),
+                                Mac48Address ("00:00:00:00:00:01"), 0);
+    }
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketCount (), 4u, "History was not bounded");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketInfo (0).uplink->GetFCnt (), 11,
+                         "Wrong most recent packet");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketInfo (3).uplink->GetFCnt (), 8,
+                         "Wrong oldest packet");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketList ().front ().second.uplink->GetFCnt (), 8,
+                         "Packet list is not ordered from the oldest packet");
+
+  // A packet that left the history is not considered a duplicate anymore
+  eds.InsertReceivedPacket (uplink, Mac48Address ("00:00:00:00:00:02"), 1);
+  NS_TEST_EXPECT_MSG_EQ (eds.GetReceivedPacketCount (), 4u, "History was not bounded");
+  NS_TEST_EXPECT_MSG_EQ (eds.GetLastReceivedPacketInfo ().gwList.size (), 1u,
+                         "Evicted packet was treated as a duplicate");
+
+  // The receive power statistics cover the last packets of the window, and
+  // follow the gateways that receive the most recent one
+  EndDeviceStatus statsEds = EndDeviceStatus ();
+  statsEds.GetRxPowerStatistics ().SetWindowLength (2);
+  double powers[3][2] = {{-100, -110}, {-120, -130}, {-104, -90}};
+  for (uint16_t fCnt = 0; fCnt < 3; fCnt++)
+    {
+      statsEds.InsertReceivedPacket (CreateUplink (fCnt, powers[fCnt][0]),
+                                     Mac48Address ("00:00:00:00:00:01"), 0);
+      statsEds.InsertReceivedPacket (CreateUplink (fCnt, powers[fCnt][1]),
+                                     Mac48Address ("00:00:00:00:00:02"), 1);
+    }
+  RxPowerStatistics &stats = statsEds.GetRxPowerStatistics ();
+  NS_TEST_EXPECT_MSG_EQ (stats.GetPacketCount (), 2u, "Wrong number of packets in the window");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetRxPower (RxPowerStatistics::AVERAGE,
+                                               RxPowerStatistics::AVERAGE),
+                             -111, 1e-9, "Wrong average power");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetRxPower (RxPowerStatistics::MAXIMUM,
+                                               RxPowerStatistics::MINIMUM),
+                             -120, 1e-9, "Wrong minimum of the best gateway powers");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetRxPower (RxPowerStatistics::MINIMUM,
+                                               RxPowerStatistics::MAXIMUM),
+                             -104, 1e-9, "Wrong maximum of the worst gateway powers");
+
+  // Gateways are ranked by the power at which they received the last packet
+  NS_TEST_EXPECT_MSG_EQ (statsEds.GetBestGatewayCount (), 2u, "Wrong number of ranked gateways");
+  NS_TEST_EXPECT_MSG_EQ (statsEds.GetBestGateway (0), 1u, "Wrong best gateway");
+  NS_TEST_EXPECT_MSG_EQ (statsEds.GetBestGateway (1), 0u, "Wrong second best gateway");
+
+  // A gateway forwarding the same packet again (e.g., a retransmission with
+  // the same FCnt) doesn't count twice in the statistics
+  statsEds.InsertReceivedPacket (CreateUplink (2, -80), Mac48Address ("00:00:00:00:00:01"), 0);
+  NS_TEST_EXPECT_MSG_EQ (statsEds.GetLastReceivedPacketInfo ().gwList.size (), 2u,
+                         "Duplicate reception added a gateway");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetRxPower (RxPowerStatistics::AVERAGE,
+                                               RxPowerStatistics::AVERAGE),
+                             -111, 1e-9, "Duplicate reception changed the average power");
+  NS_TEST_EXPECT_MSG_EQ_TOL (stats.GetRxPower (RxPowerStatistics::MAXIMUM,
+                                               RxPowerStatistics::MAXIMUM),
+                             -90, 1e-9, "Duplicate reception changed the maximum power");
 }
 
 /////////////////////////////
@@ -101,7 +235,35 @@ NetworkStatusTest::DoRun (void)
   NodeContainer endDevices = components.endDevices;
   NodeContainer gateways = components.gateways;
 
-  ns.AddNode (GetMacLayerFromNode<ClassAEndDeviceLorawanMac> (endDevices.Get (0)));
+  Ptr<ClassAEndDeviceLorawanMac> edMac =
+    GetMacLayerFromNode<ClassAEndDeviceLorawanMac> (endDevices.Get (0));
+  ns.AddNode (edMac);
+  ns.AddNode (edMac);
+  NS_TEST_EXPECT_MSG_EQ (ns.CountEndDevices (), 1, "Device was added twice");
+  NS_TEST_EXPECT_MSG_EQ ((ns.GetEndDeviceStatus (edMac->GetDeviceAddress ()) != 0), true,
+                         "Device was not found");
+
+  // Devices are found both through sequential and sparse addresses
+  DeviceAddressTable<uint32_t> table;
+  for (uint32_t nwkAddr = 1864; nwkAddr < 2864; nwkAddr++)
+    {
+      table.Insert (LoraDeviceAddress (54, nwkAddr), nwkAddr);
+    }
+  table.Insert (LoraDeviceAddress (54, 0x1FFFFFF), 1);
+  table.Insert (LoraDeviceAddress (3, 20000000), 2);
+  NS_TEST_EXPECT_MSG_EQ (table.Insert (LoraDeviceAddress (54, 1900), 0), false,
+                         "Duplicate address was inserted");
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 1002u, "Wrong number of entries");
+  NS_TEST_EXPECT_MSG_EQ (*table.Find (LoraDeviceAddress (54, 2000)), 2000u,
+                         "Wrong value for a sequential address");
+  NS_TEST_EXPECT_MSG_EQ (*table.Find (LoraDeviceAddress (54, 0x1FFFFFF)), 1u,
+                         "Wrong value for a sparse address");
+  NS_TEST_EXPECT_MSG_EQ (*table.Find (LoraDeviceAddress (3, 20000000)), 2u,
+                         "Wrong value for a sparse address");
+  NS_TEST_EXPECT_MSG_EQ ((table.Find (LoraDeviceAddress (54, 2864)) == 0), true,
+                         "Missing address was found");
+  NS_TEST_EXPECT_MSG_EQ ((table.Find (LoraDeviceAddress (55, 1900)) == 0), true,
+                         "Address of another network was found");
 }
 
 /**************